@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace log_sheriff {
+
+// Little-endian fixed-width integers, as the on-disk formats store them.
+inline void put_u32(std::string& out, std::uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+inline void put_u64(std::string& out, std::uint64_t value) {
+  for (int i = 0; i < 8; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+inline std::uint32_t load_u32(const char* bytes) {
+  std::uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= static_cast<std::uint32_t>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+  }
+  return value;
+}
+
+inline std::uint64_t load_u64(const char* bytes) {
+  std::uint64_t value = 0;
+  for (int i = 0; i < 8; ++i) {
+    value |= static_cast<std::uint64_t>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+  }
+  return value;
+}
+
+// Writes `bytes` to `path` plus ".tmp" and renames that over `path`, so readers see either the
+// old file or the new one, never half of it. Throws std::runtime_error("failed to write
+// <what>: <path>") on failure.
+void replace_file(const std::filesystem::path& path, std::string_view bytes, std::string_view what);
+
+// Block size for files read rather than mapped.
+constexpr std::size_t kReadChunkBytes = 64 * 1024;
+
+// Reads `in` from its current position to its end in blocks of up to `buffer.size()` bytes,
+// handing each to `consume`; the block is overwritten by the next read.
+void read_stream_chunks(std::istream& in, std::span<char> buffer,
+                        const std::function<void(std::span<const char>)>& consume);
+
+// Same for the whole file at `path`. Throws std::runtime_error if it cannot be opened or read.
+void read_file_chunks(const std::string& path, std::span<char> buffer,
+                      const std::function<void(std::span<const char>)>& consume);
+
+}  // namespace log_sheriff
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace log_sheriff {
+
+// Quantile sketch with relative-error guarantees (DDSketch). Values map to logarithmically
+// spaced bins, so any quantile estimate is within kRelativeAccuracy of the true value while
+// at most kMaxBins bins per sign are kept; past that the lowest bins are collapsed. All
+// sketches share one accuracy so they can always be merged.
+class DDSketch {
+ public:
+  static constexpr double kRelativeAccuracy = 0.01;
+  static constexpr std::size_t kMaxBins = 2048;
+
+  // Contiguous run of bin counters starting at bin index `offset`.
+  struct Store {
+    std::int32_t offset = 0;
+    std::vector<std::uint64_t> bins;
+
+    void add(std::int32_t index, std::uint64_t count);
+    void merge(const Store& other);
+    bool empty() const { return bins.empty(); }
+  };
+
+  void add(double value);
+  void merge(const DDSketch& other);
+
+  // Estimate of the q-quantile, q in [0, 1]. Requires count() > 0.
+  double quantile(double q) const;
+
+  std::uint64_t count() const { return count_; }
+  double min() const { return min_; }
+  double max() const { return max_; }
+
+  // Raw state, for serialization.
+  std::uint64_t zero_count() const { return zero_count_; }
+  const Store& positive() const { return positive_; }
+  const Store& negative() const { return negative_; }
+  static DDSketch restore(std::uint64_t count, double min, double max, std::uint64_t zero_count,
+                          Store positive, Store negative);
+
+ private:
+  std::uint64_t count_ = 0;
+  double min_ = 0.0;
+  double max_ = 0.0;
+  std::uint64_t zero_count_ = 0;
+  Store positive_;
+  Store negative_;
+};
+
+}  // namespace log_sheriff
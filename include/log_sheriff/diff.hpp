@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "log_sheriff/json_writer.hpp"
+#include "log_sheriff/summarizer.hpp"
+
+namespace log_sheriff {
+
+struct PatternChange {
+  std::string normalized_line;
+  std::uint64_t baseline_count = 0;
+  std::uint64_t current_count = 0;
+  // current_count - baseline_count.
+  std::int64_t delta = 0;
+  // The pattern's share of matched lines in current over its share in baseline, with half a
+  // line added to every count so new and vanished patterns get a finite ratio.
+  double ratio = 1.0;
+  // Two-proportion z statistic of the change in share; positive when the pattern grew. 0 when
+  // either side matched nothing.
+  double z_score = 0.0;
+  // Two-sided p-value of z_score.
+  double p_value = 1.0;
+};
+
+struct DiffResult {
+  std::uint64_t baseline_files = 0;
+  std::uint64_t current_files = 0;
+  std::uint64_t baseline_matched = 0;
+  std::uint64_t current_matched = 0;
+  // Patterns whose share of matched lines grew (new ones included) or shrank (vanished ones
+  // included), most significant first: by z score, then by delta, then by text.
+  std::vector<PatternChange> increased;
+  std::vector<PatternChange> decreased;
+};
+
+// Joins the frequency tables of two summaries by pattern and ranks the changes, keeping at most
+// `top_n` per direction and only those with a p-value of at most `max_p_value`. Shares rather
+// than raw counts are compared, so windows of different lengths can be diffed.
+DiffResult diff_partials(const SummaryPartial& baseline, const SummaryPartial& current, std::size_t top_n,
+                         double max_p_value = 1.0);
+
+// Summarizes both sides concurrently and diffs them. Only the two partials are kept, so memory
+// grows with the number of distinct patterns, not lines. Rethrows the first side's error.
+DiffResult diff_summaries(const SummarizeOptions& baseline, const SummarizeOptions& current, std::size_t top_n,
+                          double max_p_value = 1.0);
+
+// The diff as one JSON object; the caller ends the record.
+void write_diff_json(JsonWriter& json, const DiffResult& diff);
+
+}  // namespace log_sheriff
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+namespace log_sheriff {
+
+// Value of the first `key=value` token in `line`. The key must start the line or follow
+// whitespace; the value runs to the next whitespace, or to the closing quote when it starts
+// with '"'. Returns a view into `line`.
+std::optional<std::string_view> find_field(std::string_view line, std::string_view key);
+
+// Strict decimal parse ("42", "-3.5", "1e3"); trailing characters such as units are rejected.
+std::optional<double> parse_number(std::string_view text);
+
+}  // namespace log_sheriff
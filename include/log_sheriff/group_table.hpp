@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace log_sheriff {
+
+// Counts per distinct tuple of group-by field values. Groups live in dense columns; lookup goes
+// through an open-addressing slot array with linear probing, comparing the caller's views
+// against stored values, so a line only copies its values when it starts a new group.
+class GroupTable {
+ public:
+  // Adds `count` occurrences of the group identified by `values` and returns its index.
+  std::size_t add(std::span<const std::string_view> values, std::uint64_t count = 1);
+  // Attributes `count` of group `group`'s occurrences to pattern `pattern`.
+  void add_pattern(std::size_t group, std::size_t pattern, std::uint64_t count = 1);
+
+  // Adds every group of `other`. `pattern_mapping` translates pattern indexes of `other`
+  // into this table's pattern space (see PatternTable::merge).
+  void merge(const GroupTable& other, const std::vector<std::size_t>& pattern_mapping);
+
+  std::size_t size() const { return counts_.size(); }
+  const std::vector<std::string>& values(std::size_t group) const { return values_[group]; }
+  std::uint64_t count(std::size_t group) const { return counts_[group]; }
+  const std::unordered_map<std::size_t, std::uint64_t>& patterns(std::size_t group) const {
+    return patterns_[group];
+  }
+
+  // Indexes of the `limit` largest groups, ties broken by values.
+  std::vector<std::size_t> top(std::size_t limit) const;
+
+ private:
+  static std::uint64_t hash_values(std::span<const std::string_view> values);
+  bool equals(std::size_t group, std::span<const std::string_view> values) const;
+  void grow();
+
+  // 0 marks an empty slot; otherwise group index + 1.
+  std::vector<std::uint32_t> slots_;
+  std::vector<std::uint64_t> hashes_;
+  std::vector<std::vector<std::string>> values_;
+  std::vector<std::uint64_t> counts_;
+  std::vector<std::unordered_map<std::size_t, std::uint64_t>> patterns_;
+};
+
+}  // namespace log_sheriff
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace log_sheriff {
+
+// Finalizer from MurmurHash3; spreads every input bit over the whole word.
+inline std::uint64_t mix64(std::uint64_t value) {
+  value ^= value >> 33;
+  value *= 0xFF51AFD7ED558CCDULL;
+  value ^= value >> 33;
+  value *= 0xC4CEB9FE1A85EC53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+// 64-bit hash whose value is identical across runs and builds, unlike std::hash, so it can be
+// stored in sketches and on-disk structures. Consumes eight bytes per step.
+inline std::uint64_t hash_bytes(std::string_view bytes, std::uint64_t seed = 0) {
+  constexpr std::uint64_t kMultiplier = 0x9E3779B97F4A7C15ULL;
+  std::uint64_t hash = seed ^ (bytes.size() * kMultiplier);
+
+  std::size_t pos = 0;
+  for (; pos + 8 <= bytes.size(); pos += 8) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, bytes.data() + pos, sizeof(word));
+    hash = (hash ^ mix64(word)) * kMultiplier;
+  }
+
+  std::uint64_t tail = 0;
+  for (std::size_t shift = 0; pos < bytes.size(); ++pos, shift += 8) {
+    tail |= static_cast<std::uint64_t>(static_cast<unsigned char>(bytes[pos])) << shift;
+  }
+  hash = (hash ^ mix64(tail)) * kMultiplier;
+
+  return mix64(hash);
+}
+
+}  // namespace log_sheriff
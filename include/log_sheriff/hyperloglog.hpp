@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace log_sheriff {
+
+// HyperLogLog++ cardinality sketch over 64-bit hashes.
+//
+// Small sets are kept in a sparse list at precision 25, which makes their estimates practically
+// exact; once the list would outgrow the dense registers it is converted to 2^precision
+// one-byte registers. Dense estimates use linear counting while it reads below 2.5 * 2^p and the
+// raw harmonic-mean estimate above that; the HLL++ empirical bias tables are not included.
+class HyperLogLog {
+ public:
+  static constexpr std::uint8_t kMinPrecision = 4;
+  static constexpr std::uint8_t kMaxPrecision = 18;
+  static constexpr std::uint8_t kDefaultPrecision = 14;
+
+  HyperLogLog() : HyperLogLog(kDefaultPrecision) {}
+  // Throws std::invalid_argument for precisions outside [kMinPrecision, kMaxPrecision].
+  explicit HyperLogLog(std::uint8_t precision);
+
+  void add(std::string_view value);
+  void add_hash(std::uint64_t hash);
+
+  // Throws std::invalid_argument if the precisions differ. Does not modify `other`.
+  void merge(const HyperLogLog& other);
+
+  // Folds sparse additions still waiting to be sorted into the sparse list. Const members never
+  // modify the sketch; without this they work on a sorted copy of the pending additions, so
+  // compact a sketch before it is shared and read repeatedly.
+  void compact() { compact_sparse(); }
+
+  std::uint64_t estimate() const;
+
+  std::uint8_t precision() const { return precision_; }
+  bool is_sparse() const { return registers_.empty(); }
+
+  // Raw state, for serialization. Sparse entries are sorted and encode
+  // (25-bit index << 6) | rank.
+  std::vector<std::uint32_t> sparse_entries() const;
+  const std::vector<std::uint8_t>& registers() const { return registers_; }
+  static HyperLogLog restore_sparse(std::uint8_t precision, std::vector<std::uint32_t> entries);
+  static HyperLogLog restore_dense(std::uint8_t precision, std::vector<std::uint8_t> registers);
+
+ private:
+  void add_sparse(std::uint32_t entry);
+  void compact_sparse();
+  void convert_to_dense();
+  void add_dense(std::uint32_t index, std::uint8_t rank);
+
+  std::uint8_t precision_;
+  // Sparse mode: sorted, one entry per index with the highest rank. Unsorted additions wait in
+  // sparse_buffer_ until compaction.
+  std::vector<std::uint32_t> sparse_;
+  std::vector<std::uint32_t> sparse_buffer_;
+  // Dense mode: one register per bucket; empty while sparse.
+  std::vector<std::uint8_t> registers_;
+};
+
+}  // namespace log_sheriff
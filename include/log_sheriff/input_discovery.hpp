@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace log_sheriff {
+
+// Whether `name` matches the shell-style `pattern`: `*` is any run of characters, `?` any one
+// character, and `[abc]`, `[a-z]` or `[!a]` one character from (or not from) a set.
+bool glob_match(std::string_view pattern, std::string_view name);
+
+// Last modification time of `path`, or nullopt if it cannot be read.
+std::optional<std::time_t> file_modified_time(const std::string& path);
+
+struct DiscoverOptions {
+  // Files, or glob patterns. Wildcards may only appear in the last path component, except
+  // that `dir/**/pattern` matches the pattern at any depth below `dir`.
+  std::vector<std::string> paths;
+  // Directories whose regular files are all taken, at any depth.
+  std::vector<std::string> directories;
+  // Found files last modified before this are skipped: a file holds no line written after its
+  // last modification. Files named literally are always kept.
+  std::optional<std::time_t> modified_since;
+  // Threads walking directories; 0 uses one per hardware thread.
+  std::size_t threads = 0;
+};
+
+// The files to read: literal paths in the order given, then the files found by globs and
+// directory walks, sorted by path and without repeats. Directory trees are walked in parallel,
+// one task per directory; on Linux entries are listed with getdents64 so the file type usually
+// comes without a stat call. Symbolic links to files are taken, links to directories are not
+// followed. Throws std::runtime_error if a literal path is not a file or a directory cannot be
+// read, and std::invalid_argument for a glob with wildcards in a directory component.
+std::vector<std::string> discover_inputs(const DiscoverOptions& options);
+
+}  // namespace log_sheriff
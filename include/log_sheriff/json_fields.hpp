@@ -0,0 +1,37 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace log_sheriff {
+
+// Top-level members of a one-line JSON object, located in a single pass without building a
+// document or decoding anything: strings are skipped with memchr jumps from quote to quote, and
+// nested objects and arrays by bracket depth. Member views point into the scanned line and stay
+// valid while it does. Meant to be reused across lines so the member list is allocated once.
+class JsonFields {
+ public:
+  struct Member {
+    // As written, without quotes; escapes are not decoded.
+    std::string_view key;
+    // Strings without their quotes and with escapes as written; numbers, literals, objects and
+    // arrays as their raw text.
+    std::string_view value;
+    bool is_string = false;
+  };
+
+  // Scans `line`. Returns false, leaving no members, unless it holds exactly one JSON object
+  // with well-formed structure; scalar values are not validated.
+  bool parse(std::string_view line);
+
+  // First member named `key`, or nullptr.
+  const Member* find(std::string_view key) const;
+
+  const std::vector<Member>& members() const { return members_; }
+
+ private:
+  std::vector<Member> members_;
+};
+
+}  // namespace log_sheriff
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace log_sheriff {
+
+// A parsed JSON document. Objects keep their members in document order; lookups are linear,
+// which suits the small request objects this is used for.
+class JsonValue {
+ public:
+  enum class Kind { Null, Bool, Number, String, Array, Object };
+
+  JsonValue() = default;
+  static JsonValue boolean(bool flag);
+  static JsonValue number(double value);
+  static JsonValue string(std::string text);
+  static JsonValue array(std::vector<JsonValue> items);
+  static JsonValue object(std::vector<std::pair<std::string, JsonValue>> members);
+
+  Kind kind() const { return kind_; }
+  bool is_null() const { return kind_ == Kind::Null; }
+
+  // The typed accessors throw std::invalid_argument when the value has another kind.
+  bool as_bool() const;
+  double as_number() const;
+  const std::string& as_string() const;
+  const std::vector<JsonValue>& items() const;
+  const std::vector<std::pair<std::string, JsonValue>>& members() const;
+
+  // Member `name` of an object, or nullptr if absent. Throws if this is not an object.
+  const JsonValue* find(std::string_view name) const;
+
+ private:
+  Kind kind_ = Kind::Null;
+  bool flag_ = false;
+  double number_ = 0.0;
+  std::string text_;
+  std::vector<JsonValue> items_;
+  std::vector<std::pair<std::string, JsonValue>> members_;
+};
+
+// Parses one JSON value (RFC 8259), allowing surrounding whitespace. \u escapes, including
+// surrogate pairs, are decoded to UTF-8. Throws std::invalid_argument naming the byte offset of
+// the first error; nesting deeper than kMaxJsonDepth is rejected.
+inline constexpr std::size_t kMaxJsonDepth = 64;
+JsonValue parse_json(std::string_view text);
+
+}  // namespace log_sheriff
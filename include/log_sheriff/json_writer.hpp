@@ -0,0 +1,89 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace log_sheriff {
+
+// Appends `text` to `out` with the characters JSON requires escaped. Clean runs are found a
+// vector at a time and copied in bulk.
+void append_json_escaped(std::string& out, std::string_view text);
+
+// Streaming JSON writer that renders straight into a fixed-size buffer and hands it to the
+// stream with one fwrite per flush, or appends it to a string. Separators and indentation are
+// inserted automatically.
+//
+//   JsonWriter json(stdout, 2);
+//   json.begin_object().key("count").value(3).end_object().end_record();
+class JsonWriter {
+ public:
+  static constexpr std::size_t kDefaultBufferBytes = 64 * 1024;
+
+  // Containers nested up to `pretty_depth` levels put each member on its own indented line;
+  // deeper ones are written on one line. 0 writes compact JSON, e.g. for NDJSON records.
+  explicit JsonWriter(std::FILE* out, int pretty_depth = 0,
+                      std::size_t buffer_bytes = kDefaultBufferBytes);
+  // Appends the output to `out`, which must outlive the writer.
+  explicit JsonWriter(std::string& out, int pretty_depth = 0);
+  JsonWriter(const JsonWriter&) = delete;
+  JsonWriter& operator=(const JsonWriter&) = delete;
+  // Flushes remaining output; errors are ignored here, call flush() to observe them.
+  ~JsonWriter();
+
+  JsonWriter& begin_object();
+  JsonWriter& end_object();
+  JsonWriter& begin_array();
+  JsonWriter& end_array();
+  JsonWriter& key(std::string_view name);
+
+  JsonWriter& value(std::string_view text);
+  JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+  JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+  JsonWriter& value(bool flag);
+  // Non-finite values are written as null.
+  JsonWriter& value(double number);
+  template <std::integral T>
+  JsonWriter& value(T number) {
+    if constexpr (std::signed_integral<T>) {
+      return signed_value(number);
+    } else {
+      return unsigned_value(number);
+    }
+  }
+  JsonWriter& null();
+  // Writes an already formatted number verbatim.
+  JsonWriter& number(std::string_view formatted);
+
+  // Terminates a top-level value with a newline, e.g. one NDJSON record.
+  void end_record();
+  // Throws std::runtime_error if the stream rejects the write.
+  void flush();
+
+ private:
+  struct Frame {
+    bool first = true;
+  };
+
+  JsonWriter& signed_value(std::int64_t number);
+  JsonWriter& unsigned_value(std::uint64_t number);
+  void separate();
+  void open(char bracket);
+  void close(char bracket);
+  void newline_indent(std::size_t depth);
+  void maybe_flush();
+
+  std::FILE* out_ = nullptr;
+  std::string* sink_ = nullptr;
+  int pretty_depth_;
+  std::size_t buffer_bytes_;
+  std::string buffer_;
+  std::vector<Frame> frames_;
+  bool after_key_ = false;
+};
+
+}  // namespace log_sheriff
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace log_sheriff {
+
+// Read-only mmap view of a whole regular file, advised for sequential access. Move-only; the
+// view stays valid for the object's life.
+//
+// A file is only mapped if its size and modification time read the same before and after
+// mapping, so a file caught mid-truncation is not. Truncating a file while it stays mapped still
+// raises SIGBUS on the next access past its new end: inputs rotated with copytruncate must not be
+// scanned through a mapping while rotation may run (renaming rotation is safe).
+class MappedFile {
+ public:
+  // The mapping of `path`, or std::nullopt where it cannot be mapped (empty files, pipes and
+  // devices, files changing while being mapped, platforms without mmap); read_file_chunks (see
+  // binary_io.hpp) reads those. Throws std::runtime_error if the file cannot be opened.
+  static std::optional<MappedFile> map(const std::string& path);
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  std::span<const char> data() const { return {data_, size_}; }
+  std::size_t size() const { return size_; }
+
+ private:
+  MappedFile(const char* data, std::size_t size) : data_(data), size_(size) {}
+  void release() noexcept;
+
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+}  // namespace log_sheriff
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "log_sheriff/pattern_dictionary.hpp"
+#include "log_sheriff/pattern_table.hpp"
+#include "log_sheriff/record.hpp"
+#include "log_sheriff/summarizer.hpp"
+
+namespace log_sheriff {
+
+// Picks out lines whose pattern has never been seen: in neither the baseline nor any line
+// checked before. The baseline is a pattern dictionary, probed in place through its perfect
+// hash, and/or the frequency table of a prior run's partial; each check is one normalization
+// and a constant number of hash probes.
+class NoveltyDetector {
+ public:
+  // `dictionary` and `baseline` hold the known patterns; either may be empty. Both must outlive
+  // the detector. Throws std::invalid_argument for invalid filter options, as LineFilter.
+  NoveltyDetector(const SummarizeOptions& options, const PatternDictionary& dictionary, const PatternTable& baseline);
+
+  // The pattern of `line` if the line passes the filters and its pattern is new; each new
+  // pattern is reported once.
+  std::optional<std::string> check(std::string_view line);
+
+  std::uint64_t lines_checked() const { return lines_checked_; }
+  std::size_t novel_patterns() const { return seen_.size(); }
+
+ private:
+  LineFilter filter_;
+  Record record_;
+  const PatternDictionary& dictionary_;
+  const PatternTable& baseline_;
+  // Patterns already reported.
+  PatternTable seen_;
+  std::uint64_t lines_checked_ = 0;
+};
+
+struct Novelty {
+  std::string source;
+  // Byte offset of the line within its source.
+  std::uint64_t offset = 0;
+  std::string pattern;
+  std::string line;
+};
+
+struct WatchOptions {
+  // Keep polling the files for appended lines after reaching their end.
+  bool follow = false;
+  std::chrono::milliseconds poll_interval{500};
+  // Asked between polls; following stops once it returns true. Unset follows until an error.
+  std::function<bool()> stop;
+};
+
+// Runs every line of `files` through `detector`, calling `emit` for each novelty as soon as its
+// line is complete. Lines are read in place in chunks; a trailing unterminated line waits for
+// its newline while following and is checked at the end otherwise. While following, each file
+// is kept open: when its path comes to name another file (by device and inode), the old file is
+// read to its end before the new one is read from its start. A file that shrinks is taken to be
+// truncated and is read again from the start, and a path that names no file is retried at the
+// next poll. Throws std::runtime_error if a file cannot be opened on the first read.
+void watch_novelties(NoveltyDetector& detector, const std::vector<std::string>& files, const WatchOptions& options,
+                     const std::function<void(const Novelty&)>& emit);
+
+}  // namespace log_sheriff
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "log_sheriff/summarizer.hpp"
+
+namespace log_sheriff {
+
+// Compact binary encoding of a SummaryPartial: a magic/version header followed by
+// LEB128-encoded counters and the full frequency table.
+std::string serialize_partial(const SummaryPartial& partial);
+
+// Throws std::runtime_error on truncated or foreign input.
+SummaryPartial deserialize_partial(std::string_view bytes);
+
+bool looks_like_partial(std::string_view bytes);
+
+void write_partial_file(const std::string& path, const SummaryPartial& partial);
+SummaryPartial read_partial_file(const std::string& path);
+
+}  // namespace log_sheriff
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "log_sheriff/mapped_file.hpp"
+#include "log_sheriff/summarizer.hpp"
+
+namespace log_sheriff {
+
+// Read-only pattern dictionary file: normalized patterns numbered by dense, stable IDs, each
+// with the count recorded by the run that last wrote the file. The file is mapped and used in
+// place, so opening it costs no parsing whatever its size. Lookups go through a perfect hash
+// built with hash-and-displace (two hashes and one string comparison per lookup); IDs are
+// resolved through an offset table. All integers are little-endian.
+class PatternDictionary {
+ public:
+  // An empty dictionary.
+  PatternDictionary() = default;
+  // Throws std::runtime_error if the file cannot be read or is not a valid dictionary.
+  explicit PatternDictionary(const std::string& path);
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  std::optional<std::uint32_t> find(std::string_view pattern) const;
+  std::string_view pattern(std::uint32_t id) const;
+  std::uint64_t count(std::uint32_t id) const;
+
+ private:
+  std::optional<MappedFile> file_;
+  // The file's bytes where it could not be mapped; a vector, so moves keep the section pointers.
+  std::vector<char> contents_;
+  std::size_t size_ = 0;
+  std::uint64_t seed_ = 0;
+  std::uint64_t bucket_count_ = 0;
+  std::uint64_t slot_count_ = 0;
+  // Sections of the mapping.
+  const char* displacements_ = nullptr;
+  const char* slots_ = nullptr;
+  const char* counts_ = nullptr;
+  const char* offsets_ = nullptr;
+  const char* text_ = nullptr;
+  std::uint64_t text_size_ = 0;
+};
+
+// A dictionary file holding `patterns` with IDs 0..n-1 in order and the matching `counts`.
+// Throws std::invalid_argument if the spans differ in length or a pattern repeats.
+std::string build_pattern_dictionary(std::span<const std::string_view> patterns,
+                                     std::span<const std::uint64_t> counts);
+
+// Labels the top lines of `result` (group top lines included) with stable IDs from the
+// dictionary at `path` and the counts it recorded, then rewrites it: patterns it holds keep
+// their IDs, patterns of `partial` it lacks are appended in the order they were first seen, and
+// every count becomes this run's (0 for patterns not seen). The dictionary only grows. A
+// missing file starts an empty dictionary. Throws std::runtime_error if the file is invalid or
+// cannot be written; the file is replaced atomically.
+void apply_pattern_dictionary(const std::filesystem::path& path, const SummaryPartial& partial,
+                              SummaryResult& result);
+
+}  // namespace log_sheriff
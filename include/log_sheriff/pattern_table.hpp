@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace log_sheriff {
+
+// Frequency table keyed by normalized line. Every pattern gets a dense index in insertion
+// order; per-pattern data lives in columns addressed by that index, so metadata such as
+// timestamps never widens the key lookup path.
+class PatternTable {
+ public:
+  PatternTable() = default;
+  PatternTable(const PatternTable& other);
+  PatternTable& operator=(const PatternTable& other);
+  PatternTable(PatternTable&&) noexcept = default;
+  PatternTable& operator=(PatternTable&&) noexcept = default;
+
+  // Adds `count` occurrences of `pattern` and returns its index.
+  std::size_t add(std::string_view pattern, std::uint64_t count = 1);
+  std::optional<std::size_t> find(std::string_view pattern) const;
+
+  // Widens the first/last-seen range of pattern `index` to include `epoch_seconds`.
+  void observe_time(std::size_t index, std::time_t epoch_seconds);
+
+  // Adds every pattern of `other` to this table and returns, for each index in `other`, the
+  // index the pattern has here.
+  std::vector<std::size_t> merge(const PatternTable& other);
+
+  std::size_t size() const { return keys_.size(); }
+  bool empty() const { return keys_.empty(); }
+  const std::string& pattern(std::size_t index) const { return *keys_[index]; }
+  std::uint64_t count(std::size_t index) const { return counts_[index]; }
+  std::optional<std::time_t> first_seen(std::size_t index) const;
+  std::optional<std::time_t> last_seen(std::size_t index) const;
+
+  // Indexes of the `limit` most frequent patterns, ties broken by pattern text.
+  std::vector<std::size_t> top(std::size_t limit) const;
+
+ private:
+  struct KeyHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+  };
+
+  void rebuild_keys();
+
+  std::unordered_map<std::string, std::size_t, KeyHash, std::equal_to<>> index_;
+  // Points at the keys owned by index_; node-based storage keeps them stable.
+  std::vector<const std::string*> keys_;
+  std::vector<std::uint64_t> counts_;
+  // kNoTime until a timestamped occurrence is observed.
+  std::vector<std::time_t> first_seen_;
+  std::vector<std::time_t> last_seen_;
+};
+
+}  // namespace log_sheriff
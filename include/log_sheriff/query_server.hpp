@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "log_sheriff/json_reader.hpp"
+#include "log_sheriff/summarizer.hpp"
+
+namespace log_sheriff {
+
+// Builds summarize options from a JSON query object. Members mirror the summarize flags:
+// files (required), input_format, contains, level, where, since, until, top, group_by,
+// group_top, bucket, bucket_patterns, stat_field, distinct_fields, hll_precision and samples;
+// "op" may be "summarize". Throws std::invalid_argument for unknown members and ill-typed values.
+SummarizeOptions parse_query(const JsonValue& query);
+
+// Answers summarize queries from state kept between them. The partial of every (file, filter
+// options) pair is cached, so repeating a query or changing only --top re-reads nothing; the
+// cache evicts its least recently used entries beyond its limit. A file whose size or
+// modification time changed is re-read. Files are read in blocks rather than mapped, so a file
+// truncated while a query reads it cannot take down the process; that query summarizes what it
+// read, and the next one sees the new size and reads the file again. Thread-safe.
+class QueryEngine {
+ public:
+  struct Limits {
+    std::size_t cached_partials = 1024;
+  };
+
+  struct Stats {
+    std::uint64_t queries = 0;
+    std::uint64_t partial_hits = 0;
+    std::uint64_t partial_misses = 0;
+    std::size_t cached_partials = 0;
+  };
+
+  QueryEngine() : QueryEngine(Limits{}) {}
+  explicit QueryEngine(Limits limits);
+
+  // One JSON request in, one compact JSON response out, without a trailing newline. A
+  // summarize request gets the document `summarize --json` prints; {"op": "stats"} gets the
+  // cache counters; failures get {"error": "..."}.
+  std::string handle(std::string_view request);
+
+  // The merged partial of `options.files`, from cache where possible. Throws like
+  // Summarizer::summarize_partial.
+  SummaryPartial summarize(const SummarizeOptions& options);
+
+  Stats stats() const;
+
+ private:
+  struct FileIdentity {
+    std::uintmax_t size = 0;
+    std::filesystem::file_time_type modified;
+
+    bool operator==(const FileIdentity&) const = default;
+  };
+
+  template <typename Value>
+  struct CacheEntry {
+    FileIdentity identity;
+    std::shared_ptr<const Value> value;
+    std::uint64_t last_used = 0;
+  };
+
+  template <typename Value>
+  std::shared_ptr<const Value> lookup(std::unordered_map<std::string, CacheEntry<Value>>& cache,
+                                      const std::string& key, const FileIdentity& identity);
+  template <typename Value>
+  void insert(std::unordered_map<std::string, CacheEntry<Value>>& cache, std::size_t limit, const std::string& key,
+              const FileIdentity& identity, std::shared_ptr<const Value> value);
+
+  std::shared_ptr<const SummaryPartial> file_partial(const std::string& path, const SummarizeOptions& options,
+                                                     const std::string& fingerprint);
+
+  Limits limits_;
+  mutable std::mutex mutex_;
+  // Keyed by path and options fingerprint.
+  std::unordered_map<std::string, CacheEntry<SummaryPartial>> partials_;
+  std::uint64_t clock_ = 0;
+  Stats stats_;
+};
+
+// Serves `engine` on a Unix domain socket created at `socket_path` (mode 0600) until SIGINT or
+// SIGTERM. Each connection sends newline-terminated JSON requests and reads one response line
+// per request, in request order. The calling thread polls every connection; the complete
+// requests a connection sent are answered on a pool of `threads` workers (0: one per hardware
+// thread), so idle connections occupy no worker. A client that reads no response for 30 seconds
+// is disconnected. A stale socket file at the path is replaced; any other file is an error.
+// Throws std::runtime_error on socket errors and on platforms without Unix sockets.
+void serve_unix_socket(const std::string& socket_path, QueryEngine& engine, std::size_t threads = 0);
+
+}  // namespace log_sheriff
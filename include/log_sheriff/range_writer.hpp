@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "log_sheriff/summarizer.hpp"
+
+namespace log_sheriff {
+
+// Queues byte ranges for a file descriptor without copying them and writes them with writev,
+// merging ranges that are adjacent in memory. Queued ranges must stay valid until flush().
+class RangeWriter {
+ public:
+  // Ranges queued before a flush is forced; also the most handed to one writev call.
+  static constexpr std::size_t kMaxPending = 1024;
+
+  explicit RangeWriter(int fd);
+  RangeWriter(const RangeWriter&) = delete;
+  RangeWriter& operator=(const RangeWriter&) = delete;
+  // Flushes what is left; errors are ignored here, call flush() to observe them.
+  ~RangeWriter();
+
+  void add(std::span<const char> bytes);
+  // Throws std::runtime_error if the descriptor rejects the write.
+  void flush();
+
+ private:
+  int fd_;
+  std::vector<std::span<const char>> pending_;
+};
+
+// Queues every line of `data` accepted by `filter` on `out`, with its newline; a final line
+// without one gets a newline appended. With a null `out` lines are only counted. Returns the
+// number of matched lines.
+std::uint64_t emit_matching_lines(std::span<const char> data, const LineFilter& filter, RangeWriter* out);
+// Same for the file at `path`, flushing `out` when done. A mappable file is scanned in place; any
+// other (see MappedFile::map) is read in blocks, flushing `out` before each refill and carrying a
+// line cut by the block end over to the next. Throws std::runtime_error if it cannot be read.
+std::uint64_t emit_matching_file_lines(const std::string& path, const LineFilter& filter, RangeWriter* out);
+// Same over several inputs, interleaving their lines by timestamp (see TimeMerger) instead of
+// taking the inputs one after another. The inputs must stay valid until `out` is flushed.
+std::uint64_t emit_matching_lines_by_time(const std::vector<std::span<const char>>& inputs, const LineFilter& filter,
+                                          RangeWriter* out);
+// Same for the files at `paths`, flushing `out` when done. Mappable files are merged in place;
+// any other (see MappedFile::map) is read into memory first, and empty files are skipped. Throws
+// std::runtime_error if a file cannot be read.
+std::uint64_t emit_matching_file_lines_by_time(const std::vector<std::string>& paths, const LineFilter& filter,
+                                               RangeWriter* out);
+
+}  // namespace log_sheriff
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <string_view>
+
+#include "log_sheriff/json_fields.hpp"
+
+namespace log_sheriff {
+
+enum class LogLevel {
+  Error = 0,
+  Warn = 1,
+  Info = 2,
+  Debug = 3,
+};
+
+std::optional<LogLevel> parse_level(std::string_view raw);
+std::string_view level_name(LogLevel level);
+
+struct TimestampPrefix {
+  std::time_t epoch_seconds = 0;
+  // Characters of the line the timestamp took up.
+  std::size_t length = 0;
+};
+
+// Leading `YYYY-MM-DDTHH:MM:SSZ` (UTC) or `YYYY-MM-DD HH:MM:SS` (local time) of `line`, which
+// must end there or continue with whitespace.
+std::optional<TimestampPrefix> parse_timestamp_prefix(std::string_view line);
+// `text`, apart from surrounding whitespace, is one timestamp in the formats above.
+std::optional<std::time_t> parse_timestamp(std::string_view text);
+// Characters parse_timestamp_prefix would take from `line`, or 0 if it finds no timestamp;
+// skips the conversion to epoch seconds.
+std::size_t timestamp_prefix_length(std::string_view line);
+
+enum class InputFormat : std::uint8_t {
+  // Free text: leading timestamp, level keywords anywhere, `key=value` fields.
+  Text,
+  // One JSON object per line.
+  JsonLines,
+  // `key=value` pairs with `ts`, `level` and `msg` keys.
+  Logfmt,
+  // RFC 5424 or RFC 3164 syslog, with or without the `<PRI>` prefix.
+  Syslog,
+  // Each line as whichever of the formats above its first bytes indicate.
+  Auto,
+};
+
+std::optional<InputFormat> parse_input_format(std::string_view raw);
+std::string_view input_format_name(InputFormat format);
+
+// How lines are joined into multi-line records such as stack traces.
+enum class MultilineMode : std::uint8_t {
+  // Every line is a record.
+  None,
+  // Lines starting with whitespace, or with `Caused by:`, continue the previous record.
+  Indent,
+  // Lines without a timestamp (see Record::timestamp) continue the previous record.
+  Timestamp,
+};
+
+std::optional<MultilineMode> parse_multiline_mode(std::string_view raw);
+std::string_view multiline_mode_name(MultilineMode mode);
+
+// One input line with the parts a summary looks at located according to its format, without
+// copying. Reuse one Record across lines; views stay valid while the parsed line does.
+//
+// Structured formats name their parts:
+//   - JSON lines are scanned once with JsonFields; the message is the `msg` or `message`
+//     member, the level the `level`, `lvl` or `severity` member, the timestamp the `ts`,
+//     `time`, `timestamp` or `@timestamp` member, and fields are top-level members.
+//   - logfmt uses the same keys, looked up as `key=value` tokens.
+//   - Syslog takes the level from the priority's severity (0-3 error, 4 warn, 5-6 info,
+//     7 debug) and the timestamp from the header. The message is MSG for RFC 5424 and the
+//     text after the hostname (tag included) for RFC 3164. Fields are `key=value` tokens,
+//     which covers structured-data parameters. RFC 3164 timestamps lack a year; the year used
+//     is the one that puts them at most a day after the Record was created.
+// Structured timestamps are RFC 3339 (fractional seconds dropped, `Z`, an offset or local
+// time) or epoch seconds or milliseconds. Level names also accept forms such as warning or
+// fatal. A line that does not parse as its format is read as text.
+class Record {
+ public:
+  explicit Record(InputFormat format = InputFormat::Text);
+
+  const Record& parse(std::string_view line);
+
+  InputFormat format() const { return format_; }
+  // The format the current line was read as; never Auto.
+  InputFormat kind() const { return kind_; }
+  std::string_view line() const { return line_; }
+  // The text normalized into the line's pattern: the message where the format has one, else
+  // the whole line.
+  std::string_view message() const;
+  // Text: the level token right after a leading timestamp (`ERROR`, `[warn]`, `info:`, also
+  // names such as warning or fatal), so "INFO retrying after error" is info. Text without
+  // one, and syslog lines without a priority: the first of the keywords error, warn, info,
+  // debug found anywhere in the message (case-insensitive). Otherwise the level the format
+  // records, if any.
+  std::optional<LogLevel> level() const;
+  // Whether the line counts for a --level filter. A keyword search only looks for that level,
+  // so a text line without a level token may pass for several levels.
+  bool has_level(LogLevel wanted) const;
+  std::optional<std::time_t> timestamp() const;
+  // JSON: the member's value. Otherwise the value of the first `key=value` token (see
+  // find_field).
+  std::optional<std::string_view> field(std::string_view key) const;
+
+ private:
+  InputFormat format_;
+  InputFormat kind_ = InputFormat::Text;
+  std::string_view line_;
+  JsonFields json_;
+  // Text: the level token after the timestamp, located by parse().
+  std::optional<LogLevel> token_level_;
+  // Syslog header parts, located by parse().
+  std::string_view message_;
+  std::optional<LogLevel> priority_level_;
+  std::optional<std::time_t> header_time_;
+  // Reference point for years missing from RFC 3164 timestamps.
+  std::time_t created_;
+};
+
+}  // namespace log_sheriff
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace log_sheriff {
+
+// Uniform random sample of up to K raw lines per key (pattern index), with where each line came
+// from. Every key owns K fixed slots; the line bytes live in one shared arena that is compacted
+// once replaced lines make up most of it, and lines are truncated to kMaxLineBytes, so memory
+// is bounded by keys * K * kMaxLineBytes no matter how many lines are offered.
+//
+// Sampling is Algorithm R: the n-th line of a key replaces a random slot with probability K/n.
+// The generator has a fixed seed, so the same input always yields the same samples.
+class ReservoirSampler {
+ public:
+  static constexpr std::size_t kMaxLineBytes = 512;
+  static constexpr std::size_t kMaxPerKey = 1000;
+
+  struct Sample {
+    std::string_view line;
+    // Index into the owner's source list.
+    std::uint32_t source = 0;
+    // Byte offset of the line within its source.
+    std::uint64_t offset = 0;
+  };
+
+  ReservoirSampler() = default;
+  // Keeps up to `per_key` lines per key; 0 keeps none. Throws std::invalid_argument above
+  // kMaxPerKey.
+  explicit ReservoirSampler(std::size_t per_key);
+
+  std::size_t per_key() const { return per_key_; }
+  bool enabled() const { return per_key_ != 0; }
+
+  void offer(std::size_t key, std::string_view line, std::uint32_t source, std::uint64_t offset);
+
+  // Folds in `other`'s samples so every key holds a uniform sample of the lines both sides saw.
+  // `key_mapping` and `source_mapping` translate `other`'s keys and sources into this one's.
+  // Throws std::invalid_argument if the per-key sizes differ and both sides hold samples.
+  void merge(const ReservoirSampler& other, std::span<const std::size_t> key_mapping,
+             std::span<const std::uint32_t> source_mapping);
+
+  // Number of keys with at least one slot allocated.
+  std::size_t keys() const { return seen_.size(); }
+  // Lines offered for `key`; the sample holds min(seen, K) of them.
+  std::uint64_t seen(std::size_t key) const { return key < seen_.size() ? seen_[key] : 0; }
+  // Samples of `key` ordered by source and offset. Views point into the arena and are
+  // invalidated by the next offer or merge.
+  std::vector<Sample> samples(std::size_t key) const;
+
+  // Replaces the state of `key`, for deserialization. Throws std::invalid_argument unless
+  // exactly min(seen, K) samples are given.
+  void restore(std::size_t key, std::uint64_t seen, std::span<const Sample> samples);
+
+  std::size_t arena_bytes() const { return arena_.size(); }
+
+ private:
+  struct Slot {
+    std::uint64_t offset = 0;
+    std::size_t begin = 0;
+    std::uint32_t size = 0;
+    std::uint32_t source = 0;
+  };
+
+  void reserve_key(std::size_t key);
+  void store(Slot& slot, std::string_view line, std::uint32_t source, std::uint64_t offset);
+  void compact();
+  std::uint64_t next_random();
+  // Uniform in [0, bound).
+  std::uint64_t below(std::uint64_t bound);
+
+  std::size_t per_key_ = 0;
+  // Slots of key k are slots_[k * per_key_, (k + 1) * per_key_); the first min(seen, K) are used.
+  std::vector<Slot> slots_;
+  std::vector<std::uint64_t> seen_;
+  std::string arena_;
+  // Arena bytes no longer referenced by any slot.
+  std::size_t garbage_ = 0;
+  std::uint64_t rng_state_ = 0x9E3779B97F4A7C15ULL;
+};
+
+}  // namespace log_sheriff
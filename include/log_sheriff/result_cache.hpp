@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "log_sheriff/summarizer.hpp"
+
+namespace log_sheriff {
+
+// Everything in `options` that shapes a per-file partial, length-prefixed so distinct option
+// sets never collide. `files`, `top_n` and `group_top_n` (beyond whether it is 0) only matter
+// when merging and finalizing and are left out.
+std::string options_fingerprint(const SummarizeOptions& options);
+
+// Merges `file_partial(path, options_fingerprint(options))` over `options.files` in order, for
+// callers that keep per-file partials. `file_partial` returns a SummaryPartial or a pointer to
+// one. Like Summarizer, files that file_outside_time_range rules out are skipped, and the result
+// carries the options' configuration even when no file is left. The filters are validated first,
+// even when every file is answered from cache; throws std::invalid_argument for them or for an
+// empty file list.
+template <typename FilePartial>
+SummaryPartial merge_file_partials(const SummarizeOptions& options, FilePartial file_partial) {
+  if (options.files.empty()) {
+    throw std::invalid_argument("no input files supplied");
+  }
+  const LineFilter filter(options);
+  const std::string fingerprint = options_fingerprint(options);
+
+  SummaryPartial combined = IncrementalSummarizer(options).take_partial();
+  for (const std::string& path : options.files) {
+    if (filter.has_time_filter() && file_outside_time_range(path, filter)) {
+      continue;
+    }
+    const auto partial = file_partial(path, fingerprint);
+    if constexpr (std::is_same_v<std::remove_cv_t<decltype(partial)>, SummaryPartial>) {
+      merge(combined, partial);
+    } else {
+      merge(combined, *partial);
+    }
+  }
+  return combined;
+}
+
+// $XDG_CACHE_HOME/log-sheriff, else $HOME/.cache/log-sheriff (%LOCALAPPDATA%\log-sheriff on
+// Windows). Throws std::runtime_error if the variables are unset.
+std::filesystem::path default_cache_directory();
+
+// On-disk checkpoints of per-file summaries, one entry file per (file, options fingerprint). An
+// entry holds the partial of every complete line read so far, the unterminated last line held
+// back from it, and the file's device, inode, size and modification time plus hashes of the
+// first and last 4 KiB block read:
+//   - all unchanged: the checkpoint answers the query without reading the file;
+//   - same inode, larger, both blocks unchanged: the file was appended to, so reading resumes
+//     at the checkpoint, completing the held-back line first;
+//   - anything else (rotation, truncation, rewrite, corrupt entry): the file is re-read.
+// Samples taken from appended bytes are a uniform sample of the whole file, though not
+// necessarily the one a full re-read would pick. Files that cannot be mapped (see MappedFile)
+// are read through without a checkpoint.
+class ResultCache {
+ public:
+  struct Stats {
+    std::uint64_t hits = 0;
+    std::uint64_t appends = 0;
+    std::uint64_t misses = 0;
+  };
+
+  // Creates `directory` if needed; throws std::runtime_error if that fails.
+  explicit ResultCache(std::filesystem::path directory);
+
+  // Same result as Summarizer::summarize_partial, answered from cache where possible. Updated
+  // entries are written back before returning; throws std::runtime_error if that fails.
+  SummaryPartial summarize_partial(const SummarizeOptions& options);
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  SummaryPartial file_partial(const std::string& path, const SummarizeOptions& options,
+                              const std::string& fingerprint);
+
+  std::filesystem::path directory_;
+  Stats stats_;
+};
+
+}  // namespace log_sheriff
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <ctime>
+#include <string>
+
+#include "log_sheriff/json_writer.hpp"
+#include "log_sheriff/summarizer.hpp"
+
+namespace log_sheriff {
+
+// ISO-8601 UTC, e.g. 2026-02-09T18:01:03Z.
+std::string format_timestamp_utc(std::time_t epoch_seconds);
+// Two decimals, as rates are shown.
+std::string format_rate(double per_minute);
+// Six significant digits, as field statistics are shown.
+std::string format_number(double value);
+
+// The summary as one JSON object, as printed by --json. The caller ends the record.
+void write_result_json(JsonWriter& json, const SummaryResult& result);
+
+// One compact JSON record per line: a "summary" record, then one record per top line, group
+// and bucket, so consumers can stream large outputs without parsing a single document.
+void write_result_ndjson(JsonWriter& json, const SummaryResult& result);
+
+}  // namespace log_sheriff
@@ -3,35 +3,114 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <ctime>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
 
-namespace log_sheriff {
-
-enum class LogLevel {
-  Error = 0,
-  Warn = 1,
-  Info = 2,
-  Debug = 3,
-};
+#include "log_sheriff/ddsketch.hpp"
+#include "log_sheriff/group_table.hpp"
+#include "log_sheriff/hyperloglog.hpp"
+#include "log_sheriff/pattern_table.hpp"
+#include "log_sheriff/record.hpp"
+#include "log_sheriff/reservoir.hpp"
+#include "log_sheriff/time_histogram.hpp"
+#include "log_sheriff/where.hpp"
 
-std::optional<LogLevel> parse_level(std::string_view raw);
-std::string_view level_name(LogLevel level);
+namespace log_sheriff {
 
 struct SummarizeOptions {
   std::vector<std::string> files;
+  // How lines locate their message, level, timestamp and fields; see Record.
+  InputFormat input_format = InputFormat::Text;
+  // Joins continuation lines such as stack-trace frames into one record before filtering and
+  // normalization; line counts then count records.
+  MultilineMode multiline = MultilineMode::None;
   std::optional<std::string> contains;
   std::optional<LogLevel> level;
   std::optional<std::string> since;
   std::optional<std::string> until;
+  // Field expression such as `status>=500 shard=3`; see WhereFilter.
+  std::optional<std::string> where;
   std::size_t top_n = 10;
+  // Width of time buckets for the per-level histogram; 0 disables bucketing.
+  std::uint32_t bucket_seconds = 0;
+  // Also keep a histogram per pattern and report it for the top lines.
+  bool bucket_patterns = false;
+  // Numeric `key=value` field to collect quantiles for, overall and per pattern.
+  std::optional<std::string> stat_field;
+  // Fields whose value tuple groups matched lines; empty disables grouping.
+  std::vector<std::string> group_by;
+  // Number of top patterns reported per group; 0 skips per-group pattern counts.
+  std::size_t group_top_n = 0;
+  // Fields whose number of distinct values is estimated.
+  std::vector<std::string> distinct_fields;
+  // Precision of the distinct-count sketches: 2^p registers, standard error about 1.04/sqrt(2^p).
+  std::uint8_t hll_precision = HyperLogLog::kDefaultPrecision;
+  // Raw example lines kept per pattern by reservoir sampling; 0 disables sampling.
+  std::size_t samples_per_pattern = 0;
+  // Files summarized concurrently by Summarizer, largest first; 0 uses one thread per hardware
+  // thread. Counts do not depend on it; sampled lines may.
+  std::size_t threads = 1;
+};
+
+struct FieldStats {
+  std::uint64_t count = 0;
+  double min = 0.0;
+  double p50 = 0.0;
+  double p90 = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+};
+
+struct LineSample {
+  // Raw line, truncated to ReservoirSampler::kMaxLineBytes.
+  std::string line;
+  // Input file name; empty for data fed without IncrementalSummarizer::begin_source.
+  std::string source;
+  std::uint64_t offset = 0;
 };
 
 struct TopLine {
   std::string normalized_line;
   std::uint64_t count = 0;
+  // Earliest and latest leading timestamps among the pattern's lines, if any had one.
+  std::optional<std::time_t> first_seen;
+  std::optional<std::time_t> last_seen;
+  // Occurrences per minute between first and last sighting; spans under a minute count as one.
+  double per_minute = 0.0;
+  // Per-bucket counts aligned with SummaryResult::buckets; empty unless bucket_patterns is set.
+  std::vector<std::uint64_t> buckets;
+  // Quantiles of the stat field over this pattern's lines, when any carried it.
+  std::optional<FieldStats> stats;
+  // Uniformly sampled raw lines of the pattern, ordered by source and offset.
+  std::vector<LineSample> samples;
+  // Stable ID of the pattern in a PatternDictionary, and the count the dictionary recorded for
+  // it in the previous run, if it knew the pattern; see apply_pattern_dictionary.
+  std::optional<std::uint32_t> pattern_id;
+  std::optional<std::uint64_t> previous_count;
+};
+
+struct GroupCount {
+  // One value per SummarizeOptions::group_by field.
+  std::vector<std::string> values;
+  std::uint64_t count = 0;
+  // Most frequent patterns within the group (normalized line and count only).
+  std::vector<TopLine> top_lines;
+};
+
+struct DistinctCount {
+  std::string field;
+  // Estimated number of distinct values among matched lines carrying the field.
+  std::uint64_t estimate = 0;
+};
+
+struct TimeBucket {
+  std::time_t start = 0;
+  std::uint64_t matched = 0;
+  std::array<std::uint64_t, 4> by_level{0, 0, 0, 0};
 };
 
 struct SummaryResult {
@@ -40,11 +119,194 @@ struct SummaryResult {
   std::uint64_t matched_lines = 0;
   std::array<std::uint64_t, 4> matched_by_level{0, 0, 0, 0};
   std::vector<TopLine> top_lines;
+
+  std::uint32_t bucket_seconds = 0;
+  // Contiguous buckets, empty ones included, from the earliest to the latest matched timestamp
+  // within the run of at most BucketSeries::kMaxBuckets buckets holding the most matches (the
+  // latest such run on ties). Chosen from the final counts, so it does not depend on input order.
+  std::vector<TimeBucket> buckets;
+  // Matched lines left out of the histogram: no parseable timestamp or outside that run.
+  std::uint64_t unbucketed_lines = 0;
+
+  std::optional<std::string> stat_field;
+  std::optional<FieldStats> stats;
+
+  std::vector<std::string> group_by;
+  // Largest groups first, at most top_n of them.
+  std::vector<GroupCount> groups;
+  // Matched lines lacking at least one group-by field.
+  std::uint64_t ungrouped_lines = 0;
+
+  // Estimated number of distinct normalized lines among matched lines.
+  std::uint64_t distinct_patterns = 0;
+  // One entry per SummarizeOptions::distinct_fields field, in order.
+  std::vector<DistinctCount> distinct_values;
+
+  // Outputs name top lines by TopLine::pattern_id only, leaving their text to the dictionary.
+  bool lines_as_ids = false;
 };
 
+// Mergeable intermediate state of a summary. Unlike SummaryResult it keeps the whole
+// frequency table, so partials computed on different hosts can be combined and only then
+// reduced to a top-N.
+struct SummaryPartial {
+  std::uint64_t files_processed = 0;
+  std::uint64_t total_lines = 0;
+  std::uint64_t matched_lines = 0;
+  std::array<std::uint64_t, 4> matched_by_level{0, 0, 0, 0};
+  PatternTable patterns;
+
+  std::uint32_t bucket_seconds = 0;
+  BucketSeries<LevelBucket> level_buckets;
+  // Indexed like `patterns`; empty unless per-pattern bucketing was requested.
+  std::vector<BucketSeries<std::uint64_t>> pattern_buckets;
+  std::uint64_t unbucketed_lines = 0;
+
+  std::optional<std::string> stat_field;
+  DDSketch stats;
+  // Indexed like `patterns`; may be shorter when trailing patterns never carried the field.
+  std::vector<DDSketch> pattern_stats;
+
+  std::vector<std::string> group_by;
+  GroupTable groups;
+  std::uint64_t ungrouped_lines = 0;
+
+  // Sketch precision is part of the configuration; both sides of a merge must agree.
+  HyperLogLog distinct_patterns;
+  std::vector<std::string> distinct_fields;
+  // Indexed like `distinct_fields`.
+  std::vector<HyperLogLog> distinct_values;
+
+  // Inputs the partial was built from; sample sources index into this list.
+  std::vector<std::string> sources;
+  // Keyed like `patterns`. Its per-key size is configuration: both sides of a merge must agree.
+  ReservoirSampler samples;
+};
+
+// Folds `other` into `into`. Merging is associative and commutative. Throws
+// std::invalid_argument if the two sides used different bucket widths, stat, group-by or
+// distinct fields, sketch precisions or sample sizes. A partial with no files and no lines
+// changes nothing and is not checked, unless `into` is also empty and adopts its configuration.
+void merge(SummaryPartial& into, const SummaryPartial& other);
+SummaryResult finalize(const SummaryPartial& partial, std::size_t top_n, std::size_t group_top_n = 0);
+
+// The pattern a line's message is counted under: whitespace trimmed and collapsed, each run of
+// digits replaced by `<num>`; `<empty>` for a blank message.
+std::string normalize_line(std::string_view input);
+
+// The per-line predicate of a summary: contains, where, level and time-range filters. Time
+// bounds are validated at construction (std::invalid_argument).
+class LineFilter {
+ public:
+  explicit LineFilter(const SummarizeOptions& options);
+
+  bool matches(std::string_view line) const {
+    std::optional<std::time_t> timestamp;
+    return matches(line, timestamp);
+  }
+  bool matches(std::string_view line, std::optional<std::time_t>& timestamp) const {
+    return matches(Record(format_).parse(line), timestamp);
+  }
+  // When a time bound is set, a matching record's timestamp is stored in `timestamp`;
+  // otherwise it is left untouched.
+  bool matches(const Record& record, std::optional<std::time_t>& timestamp) const;
+
+  bool has_time_filter() const { return since_bound_.has_value() || until_bound_.has_value(); }
+  std::optional<std::time_t> since_bound() const { return since_bound_; }
+  std::optional<std::time_t> until_bound() const { return until_bound_; }
+  InputFormat format() const { return format_; }
+
+ private:
+  InputFormat format_;
+  std::optional<std::string> contains_;
+  std::optional<LogLevel> level_;
+  std::optional<WhereFilter> where_;
+  std::optional<std::time_t> since_bound_;
+  std::optional<std::time_t> until_bound_;
+};
+
+// Push-based summarizer for callers that already hold log data in memory. Complete lines are
+// processed in place from the fed buffer; only a trailing partial line is copied until a later
+// feed() completes it. Multi-line records are likewise views of the fed buffer, spanning their
+// lines' newlines; only a record still open at the end of a feed() is copied. A record ends when
+// a line that does not continue it arrives, or at flush(). `SummarizeOptions::files` is ignored.
+class IncrementalSummarizer {
+ public:
+  explicit IncrementalSummarizer(const SummarizeOptions& options);
+
+  // Flushes the current input and starts a new one named `name` whose next fed byte sits at
+  // `offset`; sampled lines record the name and their byte offset within it.
+  void begin_source(std::string_view name, std::uint64_t offset = 0);
+
+  // Replaces all state with a checkpoint of a summarizer built with the same options: the
+  // partial it gave from take_partial() and the bytes it held back (pending()) after `offset`
+  // bytes of source `name`. Feeding continues with byte `offset` of that source.
+  void resume(std::string_view name, std::uint64_t offset, SummaryPartial partial, std::string_view pending);
+
+  void feed(std::span<const char> data);
+  // Processes a buffered partial line, if any, as a complete line, and ends any open record.
+  void flush();
+  // The bytes at the end of the current source held back until a newline or flush(): the
+  // unterminated trailing line and, when joining multi-line records, the record still open.
+  std::string_view pending() const { return pending_; }
+
+  // Summary of all complete lines seen so far.
+  SummaryResult snapshot() const;
+  // Moves the accumulated state out, leaving the summarizer empty. Its sketches come compacted,
+  // so the partial may be read, and merged from, on several threads at once.
+  SummaryPartial take_partial();
+
+ private:
+  // Routes one complete line from the fed buffer into record assembly.
+  void take_line(std::string_view line, std::uint64_t offset);
+  // Same for the line completed at the end of pending_.
+  void take_pending_line();
+  bool continues_record(std::string_view line);
+  void close_record();
+  void process_line(std::string_view line, std::uint64_t offset);
+  void record_stat(const Record& record, std::size_t pattern);
+  void record_bucket(std::optional<std::time_t> timestamp, std::optional<LogLevel> detected, std::size_t pattern);
+  void record_group(const Record& record, std::size_t pattern);
+  void record_distinct(const Record& record);
+
+  LineFilter filter_;
+  // Scratch for locating the parts of the current line.
+  Record record_;
+  std::size_t top_n_ = 10;
+  std::size_t group_top_n_ = 0;
+  bool bucket_patterns_ = false;
+
+  MultilineMode multiline_ = MultilineMode::None;
+
+  SummaryPartial partial_;
+  std::string pending_;
+  // Byte offset of pending_ within the current source, and of the next fed byte.
+  std::uint64_t pending_offset_ = 0;
+  // Open multi-line record: a view of the fed buffer, or the first held_record_ bytes of
+  // pending_ (newline included) once carried over from an earlier feed().
+  bool record_open_ = false;
+  std::string_view record_view_;
+  std::uint64_t record_offset_ = 0;
+  std::size_t held_record_ = 0;
+  std::uint64_t consumed_ = 0;
+  std::uint32_t source_ = 0;
+  // Scratch for the group-by values of the current line.
+  std::vector<std::string_view> group_values_;
+};
+
+// Whether no line of the file at `path` can pass `filter`'s time bounds, judged without reading
+// the whole file. Cheapest first: a last modification before --since, then the first and last
+// timestamps found in the file's first and last 64 KiB, which bound its lines when the file is
+// in time order, as log files are. False without a time filter, for a file that cannot be
+// stat'ed (so reading it reports the error), or when in doubt.
+bool file_outside_time_range(const std::string& path, const LineFilter& filter);
+
+// Summarizes SummarizeOptions::files. With a time filter, files that file_outside_time_range
+// rules out are not read; they are counted in neither files_processed nor total_lines.
 class Summarizer {
  public:
   SummaryResult summarize(const SummarizeOptions& options) const;
+  SummaryPartial summarize_partial(const SummarizeOptions& options) const;
 };
 
 }  // namespace log_sheriff
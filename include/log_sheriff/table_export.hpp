@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "log_sheriff/summarizer.hpp"
+
+namespace log_sheriff {
+
+// Flat tables a SummaryResult can be exported as.
+enum class ResultTable { Top, Buckets, Groups };
+
+// Accepts "top", "buckets" or "groups".
+std::optional<ResultTable> parse_result_table(std::string_view raw);
+
+enum class ColumnType : std::uint8_t { UInt64, Float64, Timestamp, Utf8 };
+
+// One column in Arrow's memory layout: fixed-width values as 64-bit words (timestamps are epoch
+// seconds, doubles their bit pattern), strings as int32 offsets into one byte buffer, and nulls
+// in an LSB-first validity bitmap that is only materialized once a null is appended.
+class Column {
+ public:
+  Column(std::string name, ColumnType type);
+
+  void append_uint(std::uint64_t value);
+  void append_double(double value);
+  void append_time(std::time_t value);
+  void append_text(std::string_view value);
+  void append_null();
+
+  const std::string& name() const { return name_; }
+  ColumnType type() const { return type_; }
+  std::size_t size() const { return size_; }
+  std::size_t null_count() const { return null_count_; }
+  bool is_valid(std::size_t row) const;
+
+  // Fixed-width types only.
+  std::span<const std::uint64_t> words() const { return words_; }
+  double double_at(std::size_t row) const;
+  // Utf8 only; offsets has size() + 1 entries.
+  std::span<const std::int32_t> offsets() const { return offsets_; }
+  std::string_view text() const { return text_; }
+  std::string_view text_at(std::size_t row) const;
+  std::span<const std::uint8_t> validity() const { return validity_; }
+
+ private:
+  void push_valid(bool valid);
+
+  std::string name_;
+  ColumnType type_;
+  std::size_t size_ = 0;
+  std::size_t null_count_ = 0;
+  std::vector<std::uint64_t> words_;
+  std::vector<std::int32_t> offsets_{0};
+  std::string text_;
+  std::vector<std::uint8_t> validity_;
+};
+
+struct ColumnTable {
+  std::vector<Column> columns;
+
+  std::size_t rows() const { return columns.empty() ? 0 : columns.front().size(); }
+};
+
+// Top lines (with stat-field quantiles when present), time buckets (with per-pattern counts
+// when present) or groups (one column per group-by field).
+ColumnTable result_table(const SummaryResult& result, ResultTable which);
+
+// RFC 4180 CSV with a header row; timestamps as ISO-8601 UTC, nulls as empty fields.
+std::string to_csv(const ColumnTable& table);
+
+// Arrow IPC streaming format: a schema message, one record batch and the end-of-stream marker.
+// Readable with e.g. pyarrow.ipc.open_stream.
+std::string to_arrow_stream(const ColumnTable& table);
+
+}  // namespace log_sheriff
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace log_sheriff {
+
+// Fixed set of worker threads draining one FIFO task queue. Tasks handle their own errors; an
+// exception escaping a task terminates the process, as it would on a plain std::thread.
+class ThreadPool {
+ public:
+  // 0 uses one thread per hardware thread (at least one).
+  explicit ThreadPool(std::size_t threads = 0);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  // Runs every task already submitted, then joins the workers.
+  ~ThreadPool();
+
+  void submit(std::function<void()> task);
+
+  std::size_t size() const { return workers_.size(); }
+
+ private:
+  void run();
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<std::function<void()>> tasks_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace log_sheriff
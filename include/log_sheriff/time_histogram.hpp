@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace log_sheriff {
+
+// Parses bucket widths such as "30s", "1m", "2h" or "1d" (a bare number means seconds).
+std::optional<std::uint32_t> parse_duration(std::string_view raw);
+
+// Index of the `width_seconds` wide bucket containing `epoch_seconds`, rounding toward
+// negative infinity so pre-epoch timestamps stay contiguous.
+std::int64_t bucket_index(std::time_t epoch_seconds, std::uint32_t width_seconds);
+
+struct LevelBucket {
+  std::uint64_t matched = 0;
+  std::array<std::uint64_t, 4> by_level{0, 0, 0, 0};
+
+  LevelBucket& operator+=(const LevelBucket& other);
+};
+
+// Counters addressed by absolute bucket index. Only buckets that were counted are stored, so
+// files that are not in time order, or a stray timestamp years away from the rest, cost one entry
+// per bucket they touch. Nothing is dropped while counting or merging: the result is the same
+// whatever order lines, files and partials arrive in, and densest_window() later picks the
+// buckets a result shows.
+template <typename T>
+class BucketSeries {
+ public:
+  // Upper bound on the number of buckets a result spans, empty ones included.
+  static constexpr std::size_t kMaxBuckets = std::size_t{1} << 17;
+
+  BucketSeries() = default;
+  // The cached entry belongs to the source's map, so copies start without one.
+  BucketSeries(const BucketSeries& other) : values_(other.values_) {}
+  BucketSeries(BucketSeries&& other) noexcept
+      : values_(std::move(other.values_)), cached_bucket_(other.cached_bucket_),
+        cached_(std::exchange(other.cached_, nullptr)) {}
+  BucketSeries& operator=(const BucketSeries& other) {
+    if (this != &other) {
+      values_ = other.values_;
+      cached_ = nullptr;
+    }
+    return *this;
+  }
+  BucketSeries& operator=(BucketSeries&& other) noexcept {
+    if (this != &other) {
+      values_ = std::move(other.values_);
+      cached_bucket_ = other.cached_bucket_;
+      cached_ = std::exchange(other.cached_, nullptr);
+    }
+    return *this;
+  }
+  ~BucketSeries() = default;
+
+  // Counter of `bucket`, created at zero. Consecutive lines mostly share a bucket, so the last
+  // one is kept at hand.
+  T& at(std::int64_t bucket) {
+    if (cached_ == nullptr || cached_bucket_ != bucket) {
+      cached_ = &values_[bucket];
+      cached_bucket_ = bucket;
+    }
+    return *cached_;
+  }
+
+  // Value at `bucket`, or a default value if it was never counted.
+  T get(std::int64_t bucket) const {
+    const auto found = values_.find(bucket);
+    return found == values_.end() ? T{} : found->second;
+  }
+
+  // Adds every bucket of `other`.
+  void merge(const BucketSeries& other) {
+    for (const auto& [bucket, value] : other.values_) {
+      values_[bucket] += value;
+    }
+  }
+
+  // First and last bucket of the run of at most kMaxBuckets consecutive buckets holding the most
+  // `weight(value)`, the latest such run on ties: the whole series when it spans no more. Since
+  // it only looks at the counts, it does not depend on the order they were added in.
+  template <typename Weight>
+  std::pair<std::int64_t, std::int64_t> densest_window(Weight weight) const {
+    std::pair<std::int64_t, std::int64_t> best{0, -1};
+    std::uint64_t best_weight = 0;
+    std::uint64_t window_weight = 0;
+    auto first = values_.begin();
+    for (auto last = values_.begin(); last != values_.end(); ++last) {
+      window_weight += weight(last->second);
+      while (static_cast<std::uint64_t>(last->first - first->first) >= kMaxBuckets) {
+        window_weight -= weight(first->second);
+        ++first;
+      }
+      if (window_weight >= best_weight) {
+        best_weight = window_weight;
+        best = {first->first, last->first};
+      }
+    }
+    return best;
+  }
+
+  bool empty() const { return values_.empty(); }
+  // Number of buckets counted, not the span between the first and the last.
+  std::size_t size() const { return values_.size(); }
+  const std::map<std::int64_t, T>& buckets() const { return values_; }
+
+ private:
+  std::map<std::int64_t, T> values_;
+  std::int64_t cached_bucket_ = 0;
+  T* cached_ = nullptr;
+};
+
+}  // namespace log_sheriff
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "log_sheriff/record.hpp"
+
+namespace log_sheriff {
+
+// Interleaves the lines of several inputs into one stream ordered by timestamp. A k-way merge:
+// one cursor per input and a min-heap of the inputs' current lines, so each line is parsed once
+// and only the inputs' next lines are touched, however many inputs there are. Lines are views
+// into the inputs and are not copied.
+//
+// Each input is expected to be in time order on its own, as log files are. A line without a
+// timestamp sorts with the line before it in its input, which keeps continuation lines attached,
+// or first if it opens the input. Lines with equal timestamps come out in input order.
+class TimeMerger {
+ public:
+  struct Line {
+    // Without its newline.
+    std::string_view text;
+    // Whether a newline followed the line in its input.
+    bool terminated = false;
+    std::size_t input = 0;
+    // The line parsed with the merger's input format.
+    const Record* record = nullptr;
+  };
+
+  TimeMerger(std::vector<std::span<const char>> inputs, InputFormat format);
+  TimeMerger(const TimeMerger&) = delete;
+  TimeMerger& operator=(const TimeMerger&) = delete;
+
+  // Moves to the next line in time order; false once every input is exhausted. The line's
+  // record stays valid until the next call.
+  bool next(Line& line);
+
+ private:
+  struct Cursor {
+    std::span<const char> data;
+    // Start of the line after the current one.
+    std::size_t pos = 0;
+    Line current;
+    Record record;
+    // Timestamp the current line sorts by.
+    std::time_t key = 0;
+  };
+
+  bool advance(std::size_t input);
+  // Heap order: whether `lhs` comes out after `rhs`.
+  bool after(std::size_t lhs, std::size_t rhs) const;
+
+  std::vector<Cursor> cursors_;
+  std::vector<std::size_t> heap_;
+  // Input whose line next() returned last; advanced on the following call so the line's record
+  // stays intact meanwhile.
+  std::optional<std::size_t> yielded_;
+};
+
+}  // namespace log_sheriff
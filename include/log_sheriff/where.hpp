@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "log_sheriff/record.hpp"
+
+namespace log_sheriff {
+
+// Field-aware line predicate such as `status>=500 and (shard=3 or shard=4)`.
+//
+// Grammar: comparisons `key OP value` with OP one of = == != < <= > >= ~ (substring), a bare
+// `key` testing that the field exists, combined with `and`/`&&` (or plain juxtaposition),
+// `or`/`||`, `not`/`!` and parentheses. Values may be double-quoted, and must be to hold
+// whitespace or any of `()|&!`, which end an unquoted value. Comparisons are numeric
+// when both sides parse as numbers and textual otherwise, except that ordering against a numeric
+// literal never matches a non-numeric value. A missing field fails every comparison.
+//
+// The expression is compiled once into a flat node array. Evaluation looks up only the fields
+// a node needs, via Record::field, and short-circuits.
+class WhereFilter {
+ public:
+  // Throws std::invalid_argument describing the first syntax error.
+  static WhereFilter compile(std::string_view expression);
+
+  // Fields are looked up as `key=value` tokens of `line`.
+  bool matches(std::string_view line) const { return matches(Record().parse(line)); }
+  // Fields are looked up with Record::field, so they follow the record's input format.
+  bool matches(const Record& record) const;
+
+  // Distinct field names referenced by the expression.
+  const std::vector<std::string>& keys() const { return keys_; }
+
+ private:
+  enum class NodeKind : std::uint8_t { And, Or, Not, Exists, Compare };
+  enum class CompareOp : std::uint8_t { Eq, Ne, Lt, Le, Gt, Ge, Contains };
+
+  struct Node {
+    NodeKind kind = NodeKind::Exists;
+    CompareOp op = CompareOp::Eq;
+    std::uint32_t lhs = 0;
+    std::uint32_t rhs = 0;
+    std::uint32_t key = 0;
+    std::string text;
+    std::optional<double> number;
+  };
+
+  friend class WhereParser;
+
+  bool evaluate(std::uint32_t node, const Record& record) const;
+
+  std::vector<Node> nodes_;
+  std::vector<std::string> keys_;
+  std::uint32_t root_ = 0;
+};
+
+}  // namespace log_sheriff
@@ -0,0 +1,48 @@
+#include "log_sheriff/binary_io.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace log_sheriff {
+
+void replace_file(const std::filesystem::path& path, std::string_view bytes, std::string_view what) {
+  std::filesystem::path temporary = path;
+  temporary += ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+      throw std::runtime_error("failed to write " + std::string{what} + ": " + temporary.string());
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary, path, error);
+  if (error) {
+    throw std::runtime_error("failed to write " + std::string{what} + ": " + path.string());
+  }
+}
+
+void read_stream_chunks(std::istream& in, std::span<char> buffer,
+                        const std::function<void(std::span<const char>)>& consume) {
+  while (in) {
+    in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (in.gcount() > 0) {
+      consume(buffer.first(static_cast<std::size_t>(in.gcount())));
+    }
+  }
+}
+
+void read_file_chunks(const std::string& path, std::span<char> buffer,
+                      const std::function<void(std::span<const char>)>& consume) {
+  std::ifstream in(path, std::ios::in | std::ios::binary);
+  if (!in.is_open()) {
+    throw std::runtime_error("failed to open file: " + path);
+  }
+  read_stream_chunks(in, buffer, consume);
+  if (in.bad()) {
+    throw std::runtime_error("failed to read file: " + path);
+  }
+}
+
+}  // namespace log_sheriff
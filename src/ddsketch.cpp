@@ -0,0 +1,146 @@
+#include "log_sheriff/ddsketch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace log_sheriff {
+namespace {
+
+constexpr double kGamma = (1.0 + DDSketch::kRelativeAccuracy) / (1.0 - DDSketch::kRelativeAccuracy);
+// Magnitudes below this land in the zero bin instead of a logarithmic one.
+constexpr double kMinIndexable = 1e-9;
+
+double log_gamma() {
+  static const double value = std::log(kGamma);
+  return value;
+}
+
+std::int32_t index_of(double magnitude) {
+  return static_cast<std::int32_t>(std::ceil(std::log(magnitude) / log_gamma()));
+}
+
+// Bin i covers (gamma^(i-1), gamma^i]; this point is within the relative accuracy of both ends.
+double value_of(std::int32_t index) { return 2.0 * std::pow(kGamma, index) / (kGamma + 1.0); }
+
+}  // namespace
+
+void DDSketch::Store::add(std::int32_t index, std::uint64_t count) {
+  if (bins.empty()) {
+    offset = index;
+    bins.assign(1, 0);
+  }
+
+  const auto last = static_cast<std::int32_t>(offset + static_cast<std::int32_t>(bins.size()) - 1);
+  const std::int32_t highest = std::max(last, index);
+  const std::int32_t lowest_kept = highest - static_cast<std::int32_t>(kMaxBins - 1);
+  index = std::max(index, lowest_kept);
+
+  if (index < offset) {
+    bins.insert(bins.begin(), static_cast<std::size_t>(offset - index), 0);
+    offset = index;
+  } else if (index > last) {
+    bins.resize(static_cast<std::size_t>(index - offset) + 1);
+  }
+
+  if (offset < lowest_kept) {
+    const auto excess = static_cast<std::size_t>(lowest_kept - offset);
+    for (std::size_t i = 0; i < excess; ++i) {
+      bins[excess] += bins[i];
+    }
+    bins.erase(bins.begin(), bins.begin() + static_cast<std::ptrdiff_t>(excess));
+    offset = lowest_kept;
+  }
+
+  bins[static_cast<std::size_t>(index - offset)] += count;
+}
+
+void DDSketch::Store::merge(const Store& other) {
+  for (std::size_t i = 0; i < other.bins.size(); ++i) {
+    if (other.bins[i] != 0) {
+      add(other.offset + static_cast<std::int32_t>(i), other.bins[i]);
+    }
+  }
+}
+
+void DDSketch::add(double value) {
+  if (!std::isfinite(value)) {
+    return;
+  }
+
+  if (count_ == 0) {
+    min_ = value;
+    max_ = value;
+  } else {
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+  ++count_;
+
+  if (value > kMinIndexable) {
+    positive_.add(index_of(value), 1);
+  } else if (value < -kMinIndexable) {
+    negative_.add(index_of(-value), 1);
+  } else {
+    ++zero_count_;
+  }
+}
+
+void DDSketch::merge(const DDSketch& other) {
+  if (other.count_ == 0) {
+    return;
+  }
+  if (count_ == 0) {
+    min_ = other.min_;
+    max_ = other.max_;
+  } else {
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+  count_ += other.count_;
+  zero_count_ += other.zero_count_;
+  positive_.merge(other.positive_);
+  negative_.merge(other.negative_);
+}
+
+double DDSketch::quantile(double q) const {
+  const double rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(count_ - 1);
+  const auto clamp_value = [this](double value) { return std::clamp(value, min_, max_); };
+
+  double seen = 0.0;
+  // Most negative values live in the highest negative bins.
+  for (std::size_t i = negative_.bins.size(); i-- > 0;) {
+    seen += static_cast<double>(negative_.bins[i]);
+    if (seen > rank) {
+      return clamp_value(-value_of(negative_.offset + static_cast<std::int32_t>(i)));
+    }
+  }
+
+  seen += static_cast<double>(zero_count_);
+  if (seen > rank) {
+    return clamp_value(0.0);
+  }
+
+  for (std::size_t i = 0; i < positive_.bins.size(); ++i) {
+    seen += static_cast<double>(positive_.bins[i]);
+    if (seen > rank) {
+      return clamp_value(value_of(positive_.offset + static_cast<std::int32_t>(i)));
+    }
+  }
+
+  return max_;
+}
+
+DDSketch DDSketch::restore(std::uint64_t count, double min, double max, std::uint64_t zero_count,
+                           Store positive, Store negative) {
+  DDSketch sketch;
+  sketch.count_ = count;
+  sketch.min_ = min;
+  sketch.max_ = max;
+  sketch.zero_count_ = zero_count;
+  sketch.positive_ = std::move(positive);
+  sketch.negative_ = std::move(negative);
+  return sketch;
+}
+
+}  // namespace log_sheriff
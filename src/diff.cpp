@@ -0,0 +1,159 @@
+#include "log_sheriff/diff.hpp"
+
+#include "log_sheriff/result_json.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <thread>
+#include <utility>
+
+namespace log_sheriff {
+namespace {
+
+double share(std::uint64_t count, std::uint64_t total) {
+  return total == 0 ? 0.0 : static_cast<double>(count) / static_cast<double>(total);
+}
+
+PatternChange compare(const std::string& pattern, std::uint64_t baseline, std::uint64_t current,
+                      std::uint64_t baseline_total, std::uint64_t current_total) {
+  PatternChange change;
+  change.normalized_line = pattern;
+  change.baseline_count = baseline;
+  change.current_count = current;
+  change.delta = static_cast<std::int64_t>(current) - static_cast<std::int64_t>(baseline);
+  change.ratio = ((static_cast<double>(current) + 0.5) / (static_cast<double>(current_total) + 0.5)) /
+                 ((static_cast<double>(baseline) + 0.5) / (static_cast<double>(baseline_total) + 0.5));
+  if (baseline_total == 0 || current_total == 0) {
+    return change;
+  }
+
+  // Pooled two-proportion z test: under "no change" both sides share one rate.
+  const double pooled = share(baseline + current, baseline_total + current_total);
+  const double variance = pooled * (1.0 - pooled) *
+                          (1.0 / static_cast<double>(baseline_total) + 1.0 / static_cast<double>(current_total));
+  if (variance > 0.0) {
+    change.z_score = (share(current, current_total) - share(baseline, baseline_total)) / std::sqrt(variance);
+    change.p_value = std::erfc(std::fabs(change.z_score) / std::sqrt(2.0));
+  }
+  return change;
+}
+
+// Most significant first; `sign` is 1 for increases and -1 for decreases.
+void rank(std::vector<PatternChange>& changes, double sign, std::size_t top_n) {
+  const auto before = [sign](const PatternChange& lhs, const PatternChange& rhs) {
+    if (lhs.z_score != rhs.z_score) {
+      return sign * lhs.z_score > sign * rhs.z_score;
+    }
+    if (lhs.delta != rhs.delta) {
+      return sign * static_cast<double>(lhs.delta) > sign * static_cast<double>(rhs.delta);
+    }
+    return lhs.normalized_line < rhs.normalized_line;
+  };
+  const std::size_t keep = std::min(top_n, changes.size());
+  std::partial_sort(changes.begin(), changes.begin() + static_cast<std::ptrdiff_t>(keep), changes.end(), before);
+  changes.resize(keep);
+}
+
+void write_changes(JsonWriter& json, const std::vector<PatternChange>& changes) {
+  json.begin_array();
+  for (const PatternChange& change : changes) {
+    json.begin_object();
+    json.key("line").value(change.normalized_line);
+    json.key("baseline_count").value(change.baseline_count);
+    json.key("current_count").value(change.current_count);
+    json.key("delta").value(change.delta);
+    json.key("ratio").number(format_number(change.ratio));
+    json.key("z_score").number(format_number(change.z_score));
+    json.key("p_value").number(format_number(change.p_value));
+    json.end_object();
+  }
+  json.end_array();
+}
+
+}  // namespace
+
+DiffResult diff_partials(const SummaryPartial& baseline, const SummaryPartial& current, std::size_t top_n,
+                         double max_p_value) {
+  DiffResult diff;
+  diff.baseline_files = baseline.files_processed;
+  diff.current_files = current.files_processed;
+  diff.baseline_matched = baseline.matched_lines;
+  diff.current_matched = current.matched_lines;
+
+  const auto add = [&](const std::string& pattern, std::uint64_t before, std::uint64_t after) {
+    const double before_share = share(before, diff.baseline_matched);
+    const double after_share = share(after, diff.current_matched);
+    if (before_share == after_share) {
+      return;
+    }
+    PatternChange change = compare(pattern, before, after, diff.baseline_matched, diff.current_matched);
+    if (change.p_value > max_p_value) {
+      return;
+    }
+    (after_share > before_share ? diff.increased : diff.decreased).push_back(std::move(change));
+  };
+
+  // One pass over each table: patterns of the current side, then those only the baseline has.
+  for (std::size_t index = 0; index < current.patterns.size(); ++index) {
+    const std::string& pattern = current.patterns.pattern(index);
+    const auto in_baseline = baseline.patterns.find(pattern);
+    add(pattern, in_baseline.has_value() ? baseline.patterns.count(*in_baseline) : 0, current.patterns.count(index));
+  }
+  for (std::size_t index = 0; index < baseline.patterns.size(); ++index) {
+    const std::string& pattern = baseline.patterns.pattern(index);
+    if (!current.patterns.find(pattern).has_value()) {
+      add(pattern, baseline.patterns.count(index), 0);
+    }
+  }
+
+  rank(diff.increased, 1.0, top_n);
+  rank(diff.decreased, -1.0, top_n);
+  return diff;
+}
+
+DiffResult diff_summaries(const SummarizeOptions& baseline, const SummarizeOptions& current, std::size_t top_n,
+                          double max_p_value) {
+  const Summarizer summarizer;
+  SummaryPartial baseline_partial;
+  std::exception_ptr baseline_error;
+  std::thread worker([&] {
+    try {
+      baseline_partial = summarizer.summarize_partial(baseline);
+    } catch (...) {
+      baseline_error = std::current_exception();
+    }
+  });
+  SummaryPartial current_partial;
+  std::exception_ptr current_error;
+  try {
+    current_partial = summarizer.summarize_partial(current);
+  } catch (...) {
+    current_error = std::current_exception();
+  }
+  worker.join();
+  if (baseline_error) {
+    std::rethrow_exception(baseline_error);
+  }
+  if (current_error) {
+    std::rethrow_exception(current_error);
+  }
+  return diff_partials(baseline_partial, current_partial, top_n, max_p_value);
+}
+
+void write_diff_json(JsonWriter& json, const DiffResult& diff) {
+  json.begin_object();
+  json.key("baseline").begin_object();
+  json.key("files_processed").value(diff.baseline_files).key("matched_lines").value(diff.baseline_matched);
+  json.end_object();
+  json.key("current").begin_object();
+  json.key("files_processed").value(diff.current_files).key("matched_lines").value(diff.current_matched);
+  json.end_object();
+  json.key("increased");
+  write_changes(json, diff.increased);
+  json.key("decreased");
+  write_changes(json, diff.decreased);
+  json.end_object();
+}
+
+}  // namespace log_sheriff
@@ -0,0 +1,96 @@
+#include "log_sheriff/fields.hpp"
+
+#include <cctype>
+#include <cmath>
+
+namespace log_sheriff {
+
+std::optional<std::string_view> find_field(std::string_view line, std::string_view key) {
+  if (key.empty()) {
+    return std::nullopt;
+  }
+
+  std::size_t pos = line.find(key);
+  while (pos != std::string_view::npos) {
+    const std::size_t after = pos + key.size();
+    const bool at_token_start = pos == 0 || std::isspace(static_cast<unsigned char>(line[pos - 1])) != 0;
+    if (at_token_start && after < line.size() && line[after] == '=') {
+      const std::size_t value_start = after + 1;
+      if (value_start < line.size() && line[value_start] == '"') {
+        const std::size_t close = line.find('"', value_start + 1);
+        if (close == std::string_view::npos) {
+          return line.substr(value_start + 1);
+        }
+        return line.substr(value_start + 1, close - value_start - 1);
+      }
+
+      std::size_t value_end = value_start;
+      while (value_end < line.size() && std::isspace(static_cast<unsigned char>(line[value_end])) == 0) {
+        ++value_end;
+      }
+      return line.substr(value_start, value_end - value_start);
+    }
+    pos = line.find(key, pos + 1);
+  }
+
+  return std::nullopt;
+}
+
+std::optional<double> parse_number(std::string_view text) {
+  std::size_t pos = 0;
+  bool negative = false;
+  if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+    negative = text[pos] == '-';
+    ++pos;
+  }
+
+  double value = 0.0;
+  bool has_digits = false;
+  while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])) != 0) {
+    value = value * 10.0 + (text[pos] - '0');
+    has_digits = true;
+    ++pos;
+  }
+
+  if (pos < text.size() && text[pos] == '.') {
+    ++pos;
+    double scale = 0.1;
+    while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])) != 0) {
+      value += (text[pos] - '0') * scale;
+      scale *= 0.1;
+      has_digits = true;
+      ++pos;
+    }
+  }
+
+  if (!has_digits) {
+    return std::nullopt;
+  }
+
+  if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+    ++pos;
+    bool negative_exponent = false;
+    if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+      negative_exponent = text[pos] == '-';
+      ++pos;
+    }
+    int exponent = 0;
+    bool has_exponent_digits = false;
+    while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])) != 0 && exponent < 400) {
+      exponent = exponent * 10 + (text[pos] - '0');
+      has_exponent_digits = true;
+      ++pos;
+    }
+    if (!has_exponent_digits) {
+      return std::nullopt;
+    }
+    value *= std::pow(10.0, negative_exponent ? -exponent : exponent);
+  }
+
+  if (pos != text.size()) {
+    return std::nullopt;
+  }
+  return negative ? -value : value;
+}
+
+}  // namespace log_sheriff
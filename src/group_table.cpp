@@ -0,0 +1,109 @@
+#include "log_sheriff/group_table.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace log_sheriff {
+namespace {
+
+constexpr std::size_t kInitialSlots = 64;
+
+}  // namespace
+
+std::uint64_t GroupTable::hash_values(std::span<const std::string_view> values) {
+  std::uint64_t hash = 0x9E3779B97F4A7C15ULL;
+  for (const std::string_view value : values) {
+    hash ^= std::hash<std::string_view>{}(value) + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
+
+bool GroupTable::equals(std::size_t group, std::span<const std::string_view> values) const {
+  const std::vector<std::string>& stored = values_[group];
+  if (stored.size() != values.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < stored.size(); ++i) {
+    if (stored[i] != values[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void GroupTable::grow() {
+  std::vector<std::uint32_t> slots(slots_.empty() ? kInitialSlots : slots_.size() * 2, 0);
+  const std::size_t mask = slots.size() - 1;
+  for (std::size_t group = 0; group < hashes_.size(); ++group) {
+    std::size_t slot = hashes_[group] & mask;
+    while (slots[slot] != 0) {
+      slot = (slot + 1) & mask;
+    }
+    slots[slot] = static_cast<std::uint32_t>(group + 1);
+  }
+  slots_ = std::move(slots);
+}
+
+std::size_t GroupTable::add(std::span<const std::string_view> values, std::uint64_t count) {
+  // Keep the load factor at or below one half so probe runs stay short.
+  if ((counts_.size() + 1) * 2 > slots_.size()) {
+    grow();
+  }
+
+  const std::uint64_t hash = hash_values(values);
+  const std::size_t mask = slots_.size() - 1;
+  std::size_t slot = hash & mask;
+  while (slots_[slot] != 0) {
+    const std::size_t group = slots_[slot] - 1;
+    if (hashes_[group] == hash && equals(group, values)) {
+      counts_[group] += count;
+      return group;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  const std::size_t group = counts_.size();
+  slots_[slot] = static_cast<std::uint32_t>(group + 1);
+  hashes_.push_back(hash);
+  values_.emplace_back(values.begin(), values.end());
+  counts_.push_back(count);
+  patterns_.emplace_back();
+  return group;
+}
+
+void GroupTable::add_pattern(std::size_t group, std::size_t pattern, std::uint64_t count) {
+  patterns_[group][pattern] += count;
+}
+
+void GroupTable::merge(const GroupTable& other, const std::vector<std::size_t>& pattern_mapping) {
+  std::vector<std::string_view> views;
+  for (std::size_t i = 0; i < other.size(); ++i) {
+    views.assign(other.values_[i].begin(), other.values_[i].end());
+    const std::size_t group = add(views, other.counts_[i]);
+    for (const auto& [pattern, count] : other.patterns_[i]) {
+      add_pattern(group, pattern_mapping[pattern], count);
+    }
+  }
+}
+
+std::vector<std::size_t> GroupTable::top(std::size_t limit) const {
+  std::vector<std::size_t> order(size());
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+
+  const auto cmp = [this](std::size_t lhs, std::size_t rhs) {
+    if (counts_[lhs] != counts_[rhs]) {
+      return counts_[lhs] > counts_[rhs];
+    }
+    return values_[lhs] < values_[rhs];
+  };
+
+  limit = std::min(limit, order.size());
+  std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(limit), order.end(), cmp);
+  order.resize(limit);
+  return order;
+}
+
+}  // namespace log_sheriff
@@ -0,0 +1,232 @@
+#include "log_sheriff/hyperloglog.hpp"
+
+#include "log_sheriff/hash.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace log_sheriff {
+namespace {
+
+// Sparse entries address 2^25 buckets, so collisions among a few thousand values are rare.
+constexpr unsigned kSparsePrecision = 25;
+constexpr std::uint32_t kRankBits = 6;
+constexpr std::uint32_t kRankMask = (1U << kRankBits) - 1;
+
+// Without the HLL++ bias tables the raw estimate overshoots up to about 2.5 * 2^p; linear
+// counting is the more accurate of the two below that.
+constexpr double kLinearCountingCutoff = 2.5;
+
+std::uint8_t rank_of(std::uint64_t hash, unsigned index_bits) {
+  const std::uint64_t rest = hash << index_bits;
+  const unsigned max_rank = 64 - index_bits + 1;
+  if (rest == 0) {
+    return static_cast<std::uint8_t>(max_rank);
+  }
+  return static_cast<std::uint8_t>(std::countl_zero(rest) + 1);
+}
+
+double alpha(std::size_t buckets) {
+  switch (buckets) {
+    case 16:
+      return 0.673;
+    case 32:
+      return 0.697;
+    case 64:
+      return 0.709;
+    default:
+      return 0.7213 / (1.0 + 1.079 / static_cast<double>(buckets));
+  }
+}
+
+double linear_counting(double buckets, double empty) {
+  return buckets * std::log(buckets / empty);
+}
+
+void check_precision(unsigned precision) {
+  if (precision < HyperLogLog::kMinPrecision || precision > HyperLogLog::kMaxPrecision) {
+    throw std::invalid_argument("HyperLogLog precision must be between " +
+                                std::to_string(HyperLogLog::kMinPrecision) + " and " +
+                                std::to_string(HyperLogLog::kMaxPrecision));
+  }
+}
+
+// Sorts sparse entries and keeps one per index, the one with the highest rank.
+void sort_unique_indices(std::vector<std::uint32_t>& entries) {
+  std::sort(entries.begin(), entries.end());
+  // Entries for the same index are adjacent with the highest rank last; keep that one.
+  std::size_t out = 0;
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    const bool last_of_index =
+        i + 1 == entries.size() || (entries[i + 1] >> kRankBits) != (entries[i] >> kRankBits);
+    if (last_of_index) {
+      entries[out++] = entries[i];
+    }
+  }
+  entries.resize(out);
+}
+
+}  // namespace
+
+HyperLogLog::HyperLogLog(std::uint8_t precision) : precision_(precision) {
+  check_precision(precision);
+}
+
+void HyperLogLog::add(std::string_view value) {
+  add_hash(hash_bytes(value));
+}
+
+void HyperLogLog::add_hash(std::uint64_t hash) {
+  if (!is_sparse()) {
+    add_dense(static_cast<std::uint32_t>(hash >> (64 - precision_)), rank_of(hash, precision_));
+    return;
+  }
+  const auto index = static_cast<std::uint32_t>(hash >> (64 - kSparsePrecision));
+  add_sparse((index << kRankBits) | rank_of(hash, kSparsePrecision));
+}
+
+void HyperLogLog::add_sparse(std::uint32_t entry) {
+  sparse_buffer_.push_back(entry);
+  const std::size_t buckets = std::size_t{1} << precision_;
+  if (sparse_buffer_.size() < std::max<std::size_t>(16, buckets / 32)) {
+    return;
+  }
+  compact_sparse();
+  // Four bytes per sparse entry against one per register.
+  if (sparse_.size() * 4 > buckets) {
+    convert_to_dense();
+  }
+}
+
+void HyperLogLog::compact_sparse() {
+  if (sparse_buffer_.empty()) {
+    return;
+  }
+  sparse_.insert(sparse_.end(), sparse_buffer_.begin(), sparse_buffer_.end());
+  sparse_buffer_.clear();
+  sort_unique_indices(sparse_);
+}
+
+void HyperLogLog::convert_to_dense() {
+  compact_sparse();
+  registers_.assign(std::size_t{1} << precision_, 0);
+
+  const unsigned extra_bits = kSparsePrecision - precision_;
+  const std::uint32_t extra_mask = (1U << extra_bits) - 1;
+  for (const std::uint32_t entry : sparse_) {
+    const std::uint32_t sparse_index = entry >> kRankBits;
+    const std::uint32_t extra = sparse_index & extra_mask;
+    // The bits between the two precisions are the leading bits the dense rank is counted over.
+    const auto rank =
+        extra != 0 ? static_cast<std::uint8_t>(std::countl_zero(extra) - (32 - extra_bits) + 1)
+                   : static_cast<std::uint8_t>(extra_bits + (entry & kRankMask));
+    add_dense(sparse_index >> extra_bits, rank);
+  }
+
+  sparse_.clear();
+  sparse_.shrink_to_fit();
+}
+
+void HyperLogLog::add_dense(std::uint32_t index, std::uint8_t rank) {
+  registers_[index] = std::max(registers_[index], rank);
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+  if (other.precision_ != precision_) {
+    throw std::invalid_argument("cannot merge HyperLogLog sketches with different precisions");
+  }
+
+  if (other.is_sparse()) {
+    if (is_sparse()) {
+      // Both of other's lists are read as they are; compaction sorts them together with ours.
+      sparse_buffer_.insert(sparse_buffer_.end(), other.sparse_.begin(), other.sparse_.end());
+      sparse_buffer_.insert(sparse_buffer_.end(), other.sparse_buffer_.begin(), other.sparse_buffer_.end());
+      compact_sparse();
+      if (sparse_.size() * 4 > (std::size_t{1} << precision_)) {
+        convert_to_dense();
+      }
+      return;
+    }
+    HyperLogLog copy = other;
+    copy.convert_to_dense();
+    merge(copy);
+    return;
+  }
+
+  if (is_sparse()) {
+    convert_to_dense();
+  }
+  for (std::size_t i = 0; i < registers_.size(); ++i) {
+    registers_[i] = std::max(registers_[i], other.registers_[i]);
+  }
+}
+
+std::uint64_t HyperLogLog::estimate() const {
+  if (is_sparse()) {
+    const double buckets = static_cast<double>(std::uint64_t{1} << kSparsePrecision);
+    const double used = static_cast<double>(sparse_buffer_.empty() ? sparse_.size() : sparse_entries().size());
+    return static_cast<std::uint64_t>(std::llround(linear_counting(buckets, buckets - used)));
+  }
+
+  const double buckets = static_cast<double>(registers_.size());
+  double sum = 0.0;
+  std::size_t empty = 0;
+  for (const std::uint8_t rank : registers_) {
+    sum += std::ldexp(1.0, -static_cast<int>(rank));
+    empty += rank == 0 ? 1 : 0;
+  }
+
+  if (empty > 0) {
+    const double estimate = linear_counting(buckets, static_cast<double>(empty));
+    if (estimate <= kLinearCountingCutoff * buckets) {
+      return static_cast<std::uint64_t>(std::llround(estimate));
+    }
+  }
+  const double raw = alpha(registers_.size()) * buckets * buckets / sum;
+  return static_cast<std::uint64_t>(std::llround(raw));
+}
+
+std::vector<std::uint32_t> HyperLogLog::sparse_entries() const {
+  std::vector<std::uint32_t> entries = sparse_;
+  if (!sparse_buffer_.empty()) {
+    entries.insert(entries.end(), sparse_buffer_.begin(), sparse_buffer_.end());
+    sort_unique_indices(entries);
+  }
+  return entries;
+}
+
+HyperLogLog HyperLogLog::restore_sparse(std::uint8_t precision,
+                                        std::vector<std::uint32_t> entries) {
+  HyperLogLog sketch(precision);
+  for (const std::uint32_t entry : entries) {
+    const std::uint32_t rank = entry & kRankMask;
+    if (rank == 0 || rank > 64 - kSparsePrecision + 1) {
+      throw std::invalid_argument("HyperLogLog sparse entry out of range");
+    }
+  }
+  sketch.sparse_buffer_ = std::move(entries);
+  sketch.compact_sparse();
+  return sketch;
+}
+
+HyperLogLog HyperLogLog::restore_dense(std::uint8_t precision,
+                                       std::vector<std::uint8_t> registers) {
+  HyperLogLog sketch(precision);
+  if (registers.size() != (std::size_t{1} << precision)) {
+    throw std::invalid_argument("HyperLogLog register count does not match precision");
+  }
+  const auto max_rank = static_cast<std::uint8_t>(64 - precision + 1);
+  for (const std::uint8_t rank : registers) {
+    if (rank > max_rank) {
+      throw std::invalid_argument("HyperLogLog register out of range");
+    }
+  }
+  sketch.registers_ = std::move(registers);
+  return sketch;
+}
+
+}  // namespace log_sheriff
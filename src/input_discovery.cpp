@@ -0,0 +1,387 @@
+#include "log_sheriff/input_discovery.hpp"
+
+#include "log_sheriff/thread_pool.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <sys/stat.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace log_sheriff {
+namespace {
+
+constexpr std::size_t kNone = std::string_view::npos;
+
+// Matches the set opening at `open` ('[') against `ch` and stores the index past its ']' in
+// `next`; nullopt if the set is never closed, in which case '[' is an ordinary character.
+std::optional<bool> match_set(std::string_view pattern, std::size_t open, char ch, std::size_t& next) {
+  std::size_t pos = open + 1;
+  bool negate = false;
+  if (pos < pattern.size() && (pattern[pos] == '!' || pattern[pos] == '^')) {
+    negate = true;
+    ++pos;
+  }
+  const auto value = static_cast<unsigned char>(ch);
+  bool matched = false;
+  // A ']' right after the opening bracket is a member, not the end of the set.
+  for (bool first = true; pos < pattern.size() && (first || pattern[pos] != ']'); first = false) {
+    const auto low = static_cast<unsigned char>(pattern[pos]);
+    if (pos + 2 < pattern.size() && pattern[pos + 1] == '-' && pattern[pos + 2] != ']') {
+      const auto high = static_cast<unsigned char>(pattern[pos + 2]);
+      matched = matched || (low <= value && value <= high);
+      pos += 3;
+    } else {
+      matched = matched || low == value;
+      ++pos;
+    }
+  }
+  if (pos >= pattern.size()) {
+    return std::nullopt;
+  }
+  next = pos + 1;
+  return matched != negate;
+}
+
+bool has_wildcard(std::string_view text) { return text.find_first_of("*?[") != kNone; }
+
+std::string join_path(const std::string& directory, std::string_view name) {
+  if (directory.empty()) {
+    return std::string(name);
+  }
+  std::string out = directory;
+  if (out.back() != '/') {
+    out.push_back('/');
+  }
+  out.append(name);
+  return out;
+}
+
+std::string strip_trailing_slashes(std::string path) {
+  while (path.size() > 1 && path.back() == '/') {
+    path.pop_back();
+  }
+  return path;
+}
+
+enum class EntryKind { File, Directory, Other, Unknown };
+
+// Kind of `path` for entries whose listing did not tell: links to files count as files, links
+// to directories are not followed.
+EntryKind resolve_kind(const std::string& path) {
+#if defined(_WIN32)
+  std::error_code error;
+  const auto status = std::filesystem::symlink_status(path, error);
+  if (error) {
+    return EntryKind::Other;
+  }
+  if (std::filesystem::is_symlink(status)) {
+    return std::filesystem::is_regular_file(path, error) ? EntryKind::File : EntryKind::Other;
+  }
+  if (std::filesystem::is_directory(status)) {
+    return EntryKind::Directory;
+  }
+  return std::filesystem::is_regular_file(status) ? EntryKind::File : EntryKind::Other;
+#else
+  struct stat info {};
+  if (::lstat(path.c_str(), &info) != 0) {
+    return EntryKind::Other;
+  }
+  if (S_ISLNK(info.st_mode)) {
+    return ::stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode) ? EntryKind::File : EntryKind::Other;
+  }
+  if (S_ISDIR(info.st_mode)) {
+    return EntryKind::Directory;
+  }
+  return S_ISREG(info.st_mode) ? EntryKind::File : EntryKind::Other;
+#endif
+}
+
+#if defined(__linux__)
+// Record layout returned by getdents64, which glibc does not declare.
+struct LinuxDirent64 {
+  std::uint64_t d_ino;
+  std::int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[256];
+};
+
+class DirectoryFd {
+ public:
+  explicit DirectoryFd(const std::string& path)
+      : fd_(::open(path.empty() ? "." : path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)) {}
+  DirectoryFd(const DirectoryFd&) = delete;
+  DirectoryFd& operator=(const DirectoryFd&) = delete;
+  ~DirectoryFd() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+  int get() const { return fd_; }
+
+ private:
+  int fd_;
+};
+#endif
+
+// Calls `visit(name, kind)` for every entry of `directory` ("" is the working directory) other
+// than "." and "..". Throws std::runtime_error if it cannot be read.
+template <typename Visit>
+void list_directory(const std::string& directory, Visit&& visit) {
+#if defined(__linux__)
+  const DirectoryFd fd(directory);
+  if (fd.get() < 0) {
+    throw std::runtime_error("failed to read directory: " + directory);
+  }
+  // Batches of entries straight from the kernel, without readdir's per-entry calls.
+  alignas(LinuxDirent64) char buffer[32 * 1024];
+  while (true) {
+    const long bytes = ::syscall(SYS_getdents64, fd.get(), buffer, sizeof(buffer));
+    if (bytes < 0) {
+      throw std::runtime_error("failed to read directory: " + directory);
+    }
+    if (bytes == 0) {
+      return;
+    }
+    for (long offset = 0; offset < bytes;) {
+      const auto* entry = reinterpret_cast<const LinuxDirent64*>(buffer + offset);
+      offset += entry->d_reclen;
+      const std::string_view name(entry->d_name);
+      if (name == "." || name == "..") {
+        continue;
+      }
+      switch (entry->d_type) {
+        case DT_REG:
+          visit(name, EntryKind::File);
+          break;
+        case DT_DIR:
+          visit(name, EntryKind::Directory);
+          break;
+        case DT_LNK:
+        case DT_UNKNOWN:
+          visit(name, EntryKind::Unknown);
+          break;
+        default:
+          visit(name, EntryKind::Other);
+          break;
+      }
+    }
+  }
+#else
+  std::error_code error;
+  std::filesystem::directory_iterator it(directory.empty() ? "." : directory, error);
+  if (error) {
+    throw std::runtime_error("failed to read directory: " + directory);
+  }
+  for (; it != std::filesystem::directory_iterator(); it.increment(error)) {
+    const std::string name = it->path().filename().string();
+    visit(std::string_view(name), EntryKind::Unknown);
+  }
+  if (error) {
+    throw std::runtime_error("failed to read directory: " + directory);
+  }
+#endif
+}
+
+// Walks directories on a thread pool, one task per directory, collecting the files that match.
+class Walker {
+ public:
+  Walker(std::size_t threads, std::optional<std::time_t> modified_since)
+      : modified_since_(modified_since), pool_(threads) {}
+
+  // Queues `directory`, taking files whose names match `pattern` (all files when empty) and
+  // descending into subdirectories when `recursive`.
+  void add(std::string directory, std::string pattern, bool recursive) {
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      ++outstanding_;
+    }
+    pool_.submit([this, directory = std::move(directory), pattern = std::move(pattern), recursive] {
+      try {
+        walk(directory, pattern, recursive);
+      } catch (...) {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_) {
+          error_ = std::current_exception();
+        }
+      }
+      const std::lock_guard<std::mutex> lock(mutex_);
+      if (--outstanding_ == 0) {
+        done_.notify_all();
+      }
+    });
+  }
+
+  // Waits for every walk and returns what they found; rethrows the first error.
+  std::vector<std::string> finish() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return outstanding_ == 0; });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return std::move(found_);
+  }
+
+ private:
+  void walk(const std::string& directory, const std::string& pattern, bool recursive) {
+    std::vector<std::string> files;
+    list_directory(directory, [&](std::string_view name, EntryKind kind) {
+      const std::string path = join_path(directory, name);
+      if (kind == EntryKind::Unknown) {
+        kind = resolve_kind(path);
+      }
+      if (kind == EntryKind::Directory && recursive) {
+        // Queued before this directory finishes, so the outstanding count never drops to zero early.
+        add(path, pattern, true);
+      } else if (kind == EntryKind::File && (pattern.empty() || glob_match(pattern, name))) {
+        if (modified_since_.has_value()) {
+          const auto modified = file_modified_time(path);
+          if (modified.has_value() && *modified < *modified_since_) {
+            return;
+          }
+        }
+        files.push_back(path);
+      }
+    });
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    found_.insert(found_.end(), std::make_move_iterator(files.begin()), std::make_move_iterator(files.end()));
+  }
+
+  std::optional<std::time_t> modified_since_;
+  std::mutex mutex_;
+  std::condition_variable done_;
+  std::size_t outstanding_ = 0;
+  std::vector<std::string> found_;
+  std::exception_ptr error_;
+  // Last, so the workers are joined before the state they use goes away.
+  ThreadPool pool_;
+};
+
+}  // namespace
+
+bool glob_match(std::string_view pattern, std::string_view name) {
+  std::size_t p = 0;
+  std::size_t n = 0;
+  // Where the last '*' was and how much of the name it has taken, for backtracking.
+  std::size_t star = kNone;
+  std::size_t star_end = 0;
+  while (n < name.size()) {
+    if (p < pattern.size()) {
+      const char ch = pattern[p];
+      if (ch == '*') {
+        star = p++;
+        star_end = n;
+        continue;
+      }
+      if (ch == '?') {
+        ++p;
+        ++n;
+        continue;
+      }
+      std::size_t next = 0;
+      const std::optional<bool> in_set = ch == '[' ? match_set(pattern, p, name[n], next) : std::nullopt;
+      if (in_set.has_value() ? *in_set : ch == name[n]) {
+        p = in_set.has_value() ? next : p + 1;
+        ++n;
+        continue;
+      }
+    }
+    if (star == kNone) {
+      return false;
+    }
+    p = star + 1;
+    n = ++star_end;
+  }
+  while (p < pattern.size() && pattern[p] == '*') {
+    ++p;
+  }
+  return p == pattern.size();
+}
+
+std::optional<std::time_t> file_modified_time(const std::string& path) {
+#if defined(_WIN32)
+  struct _stat64 info {};
+  if (::_stat64(path.c_str(), &info) != 0) {
+    return std::nullopt;
+  }
+#else
+  struct stat info {};
+  if (::stat(path.c_str(), &info) != 0) {
+    return std::nullopt;
+  }
+#endif
+  return static_cast<std::time_t>(info.st_mtime);
+}
+
+std::vector<std::string> discover_inputs(const DiscoverOptions& options) {
+  std::vector<std::string> literal;
+  // Only started when something needs walking.
+  std::optional<Walker> walker;
+  const auto walk = [&](std::string directory, std::string pattern, bool recursive) {
+    if (!walker.has_value()) {
+      walker.emplace(options.threads, options.modified_since);
+    }
+    walker->add(std::move(directory), std::move(pattern), recursive);
+  };
+
+  for (const std::string& path : options.paths) {
+    if (!has_wildcard(path)) {
+      std::error_code error;
+      if (std::filesystem::is_directory(path, error)) {
+        throw std::runtime_error("input is a directory (use --recursive): " + path);
+      }
+      if (!std::filesystem::is_regular_file(path, error)) {
+        throw std::runtime_error("failed to open file: " + path);
+      }
+      literal.push_back(path);
+      continue;
+    }
+
+    const std::size_t slash = path.rfind('/');
+    std::string directory = slash == kNone ? std::string() : path.substr(0, slash == 0 ? 1 : slash);
+    std::string pattern = path.substr(slash == kNone ? 0 : slash + 1);
+    bool recursive = false;
+    if (directory == "**" || directory.ends_with("/**")) {
+      directory.resize(directory.size() - 2);
+      directory = directory.empty() ? std::string() : strip_trailing_slashes(directory);
+      recursive = true;
+    }
+    if (has_wildcard(directory)) {
+      throw std::invalid_argument("wildcards are only supported in the last path component or as **/: " + path);
+    }
+    walk(std::move(directory), std::move(pattern), recursive);
+  }
+  for (const std::string& directory : options.directories) {
+    walk(strip_trailing_slashes(directory), std::string(), true);
+  }
+
+  if (!walker.has_value()) {
+    return literal;
+  }
+  std::vector<std::string> found = walker->finish();
+  std::sort(found.begin(), found.end());
+  found.erase(std::unique(found.begin(), found.end()), found.end());
+  for (std::string& path : found) {
+    if (std::find(literal.begin(), literal.end(), path) == literal.end()) {
+      literal.push_back(std::move(path));
+    }
+  }
+  return literal;
+}
+
+}  // namespace log_sheriff
@@ -0,0 +1,143 @@
+#include "log_sheriff/json_fields.hpp"
+
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+
+namespace log_sheriff {
+namespace {
+
+constexpr std::size_t kNone = std::string_view::npos;
+
+std::size_t skip_whitespace(std::string_view text, std::size_t pos) {
+  while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])) != 0) {
+    ++pos;
+  }
+  return pos;
+}
+
+// Index just past the closing quote of the string opened at `open`, or kNone if unterminated.
+std::size_t skip_string(std::string_view text, std::size_t open) {
+  std::size_t pos = open + 1;
+  while (pos < text.size()) {
+    const auto* hit = static_cast<const char*>(std::memchr(text.data() + pos, '"', text.size() - pos));
+    if (hit == nullptr) {
+      return kNone;
+    }
+    const auto quote = static_cast<std::size_t>(hit - text.data());
+    // A quote after an odd run of backslashes is escaped.
+    std::size_t backslashes = 0;
+    while (quote - backslashes > open + 1 && text[quote - backslashes - 1] == '\\') {
+      ++backslashes;
+    }
+    if (backslashes % 2 == 0) {
+      return quote + 1;
+    }
+    pos = quote + 1;
+  }
+  return kNone;
+}
+
+// Index just past the value starting at `pos`, or kNone if it is malformed.
+std::size_t skip_value(std::string_view text, std::size_t pos) {
+  const char first = text[pos];
+  if (first == '"') {
+    return skip_string(text, pos);
+  }
+  if (first == '{' || first == '[') {
+    std::size_t depth = 0;
+    while (pos < text.size()) {
+      const char ch = text[pos];
+      if (ch == '"') {
+        pos = skip_string(text, pos);
+        if (pos == kNone) {
+          return kNone;
+        }
+        continue;
+      }
+      if (ch == '{' || ch == '[') {
+        ++depth;
+      } else if ((ch == '}' || ch == ']') && --depth == 0) {
+        return pos + 1;
+      }
+      ++pos;
+    }
+    return kNone;
+  }
+
+  const std::size_t start = pos;
+  while (pos < text.size() && text[pos] != ',' && text[pos] != '}' && text[pos] != ']' &&
+         std::isspace(static_cast<unsigned char>(text[pos])) == 0) {
+    ++pos;
+  }
+  return pos == start ? kNone : pos;
+}
+
+}  // namespace
+
+bool JsonFields::parse(std::string_view line) {
+  members_.clear();
+  const auto fail = [this] {
+    members_.clear();
+    return false;
+  };
+
+  std::size_t pos = skip_whitespace(line, 0);
+  if (pos >= line.size() || line[pos] != '{') {
+    return false;
+  }
+  pos = skip_whitespace(line, pos + 1);
+  if (pos < line.size() && line[pos] == '}') {
+    return skip_whitespace(line, pos + 1) == line.size();
+  }
+
+  while (true) {
+    if (pos >= line.size() || line[pos] != '"') {
+      return fail();
+    }
+    const std::size_t key_end = skip_string(line, pos);
+    if (key_end == kNone) {
+      return fail();
+    }
+    const std::string_view key = line.substr(pos + 1, key_end - pos - 2);
+
+    pos = skip_whitespace(line, key_end);
+    if (pos >= line.size() || line[pos] != ':') {
+      return fail();
+    }
+    pos = skip_whitespace(line, pos + 1);
+    if (pos >= line.size()) {
+      return fail();
+    }
+    const std::size_t value_end = skip_value(line, pos);
+    if (value_end == kNone) {
+      return fail();
+    }
+    Member member{key, line.substr(pos, value_end - pos), line[pos] == '"'};
+    if (member.is_string) {
+      member.value = member.value.substr(1, member.value.size() - 2);
+    }
+    members_.push_back(member);
+
+    pos = skip_whitespace(line, value_end);
+    if (pos < line.size() && line[pos] == ',') {
+      pos = skip_whitespace(line, pos + 1);
+      continue;
+    }
+    if (pos < line.size() && line[pos] == '}' && skip_whitespace(line, pos + 1) == line.size()) {
+      return true;
+    }
+    return fail();
+  }
+}
+
+const JsonFields::Member* JsonFields::find(std::string_view key) const {
+  for (const Member& member : members_) {
+    if (member.key == key) {
+      return &member;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace log_sheriff
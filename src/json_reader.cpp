@@ -0,0 +1,352 @@
+#include "log_sheriff/json_reader.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <stdexcept>
+
+namespace log_sheriff {
+namespace {
+
+class Parser {
+ public:
+  explicit Parser(std::string_view text) : text_(text) {}
+
+  JsonValue document() {
+    JsonValue value = parse_value(0);
+    skip_ws();
+    if (pos_ != text_.size()) {
+      fail("unexpected trailing characters");
+    }
+    return value;
+  }
+
+ private:
+  [[noreturn]] void fail(std::string_view what) const {
+    throw std::invalid_argument("invalid JSON at offset " + std::to_string(pos_) + ": " + std::string{what});
+  }
+
+  void skip_ws() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) {
+      ++pos_;
+    }
+  }
+
+  bool consume(char expected) {
+    skip_ws();
+    if (pos_ < text_.size() && text_[pos_] == expected) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  void expect_literal(std::string_view literal) {
+    if (text_.substr(pos_, literal.size()) != literal) {
+      fail("unknown literal");
+    }
+    pos_ += literal.size();
+  }
+
+  JsonValue parse_value(std::size_t depth) {
+    if (depth > kMaxJsonDepth) {
+      fail("nesting too deep");
+    }
+    skip_ws();
+    if (pos_ >= text_.size()) {
+      fail("unexpected end of input");
+    }
+    switch (text_[pos_]) {
+      case '{':
+        return parse_object(depth);
+      case '[':
+        return parse_array(depth);
+      case '"':
+        return JsonValue::string(parse_string());
+      case 't':
+        expect_literal("true");
+        return JsonValue::boolean(true);
+      case 'f':
+        expect_literal("false");
+        return JsonValue::boolean(false);
+      case 'n':
+        expect_literal("null");
+        return JsonValue{};
+      default:
+        return JsonValue::number(parse_number());
+    }
+  }
+
+  JsonValue parse_object(std::size_t depth) {
+    ++pos_;
+    std::vector<std::pair<std::string, JsonValue>> members;
+    if (consume('}')) {
+      return JsonValue::object(std::move(members));
+    }
+    do {
+      skip_ws();
+      if (pos_ >= text_.size() || text_[pos_] != '"') {
+        fail("expected member name");
+      }
+      std::string name = parse_string();
+      if (!consume(':')) {
+        fail("expected ':'");
+      }
+      members.emplace_back(std::move(name), parse_value(depth + 1));
+    } while (consume(','));
+    if (!consume('}')) {
+      fail("expected ',' or '}'");
+    }
+    return JsonValue::object(std::move(members));
+  }
+
+  JsonValue parse_array(std::size_t depth) {
+    ++pos_;
+    std::vector<JsonValue> items;
+    if (consume(']')) {
+      return JsonValue::array(std::move(items));
+    }
+    do {
+      items.push_back(parse_value(depth + 1));
+    } while (consume(','));
+    if (!consume(']')) {
+      fail("expected ',' or ']'");
+    }
+    return JsonValue::array(std::move(items));
+  }
+
+  std::uint32_t parse_hex4() {
+    if (text_.size() - pos_ < 4) {
+      fail("truncated \\u escape");
+    }
+    std::uint32_t code = 0;
+    const auto [end, error] = std::from_chars(text_.data() + pos_, text_.data() + pos_ + 4, code, 16);
+    if (error != std::errc{} || end != text_.data() + pos_ + 4) {
+      fail("invalid \\u escape");
+    }
+    pos_ += 4;
+    return code;
+  }
+
+  static void append_utf8(std::string& out, std::uint32_t code) {
+    if (code < 0x80) {
+      out.push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+      out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+      out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+      out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else {
+      out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+      out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+  }
+
+  std::string parse_string() {
+    ++pos_;
+    std::string out;
+    while (true) {
+      const std::size_t run = text_.find_first_of("\"\\", pos_);
+      if (run == std::string_view::npos) {
+        fail("unterminated string");
+      }
+      for (std::size_t i = pos_; i < run; ++i) {
+        if (static_cast<unsigned char>(text_[i]) < 0x20) {
+          pos_ = i;
+          fail("control character in string");
+        }
+      }
+      out.append(text_.substr(pos_, run - pos_));
+      pos_ = run + 1;
+      if (text_[run] == '"') {
+        return out;
+      }
+      if (pos_ >= text_.size()) {
+        fail("unterminated string");
+      }
+      const char escape = text_[pos_++];
+      switch (escape) {
+        case '"':
+        case '\\':
+        case '/':
+          out.push_back(escape);
+          break;
+        case 'b':
+          out.push_back('\b');
+          break;
+        case 'f':
+          out.push_back('\f');
+          break;
+        case 'n':
+          out.push_back('\n');
+          break;
+        case 'r':
+          out.push_back('\r');
+          break;
+        case 't':
+          out.push_back('\t');
+          break;
+        case 'u': {
+          std::uint32_t code = parse_hex4();
+          if (code >= 0xD800 && code <= 0xDBFF) {
+            if (text_.substr(pos_, 2) != "\\u") {
+              fail("unpaired surrogate");
+            }
+            pos_ += 2;
+            const std::uint32_t low = parse_hex4();
+            if (low < 0xDC00 || low > 0xDFFF) {
+              fail("unpaired surrogate");
+            }
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+          } else if (code >= 0xDC00 && code <= 0xDFFF) {
+            fail("unpaired surrogate");
+          }
+          append_utf8(out, code);
+          break;
+        }
+        default:
+          fail("invalid escape");
+      }
+    }
+  }
+
+  double parse_number() {
+    // Check the JSON grammar first; from_chars alone would also accept e.g. "inf" or "1.".
+    const std::size_t start = pos_;
+    const auto digits = [this] {
+      const std::size_t first = pos_;
+      while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') {
+        ++pos_;
+      }
+      return pos_ - first;
+    };
+    if (pos_ < text_.size() && text_[pos_] == '-') {
+      ++pos_;
+    }
+    const std::size_t integer_start = pos_;
+    const std::size_t integer_digits = digits();
+    if (integer_digits == 0 || (integer_digits > 1 && text_[integer_start] == '0')) {
+      pos_ = start;
+      fail("invalid number");
+    }
+    if (pos_ < text_.size() && text_[pos_] == '.') {
+      ++pos_;
+      if (digits() == 0) {
+        fail("invalid number");
+      }
+    }
+    if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+      ++pos_;
+      if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-')) {
+        ++pos_;
+      }
+      if (digits() == 0) {
+        fail("invalid number");
+      }
+    }
+
+    double value = 0.0;
+    const auto [end, error] = std::from_chars(text_.data() + start, text_.data() + pos_, value);
+    if (error != std::errc{} || end != text_.data() + pos_) {
+      pos_ = start;
+      fail("number out of range");
+    }
+    return value;
+  }
+
+  std::string_view text_;
+  std::size_t pos_ = 0;
+};
+
+[[noreturn]] void wrong_kind(std::string_view wanted) {
+  throw std::invalid_argument("expected a JSON " + std::string{wanted});
+}
+
+}  // namespace
+
+JsonValue JsonValue::boolean(bool flag) {
+  JsonValue value;
+  value.kind_ = Kind::Bool;
+  value.flag_ = flag;
+  return value;
+}
+
+JsonValue JsonValue::number(double number) {
+  JsonValue value;
+  value.kind_ = Kind::Number;
+  value.number_ = number;
+  return value;
+}
+
+JsonValue JsonValue::string(std::string text) {
+  JsonValue value;
+  value.kind_ = Kind::String;
+  value.text_ = std::move(text);
+  return value;
+}
+
+JsonValue JsonValue::array(std::vector<JsonValue> items) {
+  JsonValue value;
+  value.kind_ = Kind::Array;
+  value.items_ = std::move(items);
+  return value;
+}
+
+JsonValue JsonValue::object(std::vector<std::pair<std::string, JsonValue>> members) {
+  JsonValue value;
+  value.kind_ = Kind::Object;
+  value.members_ = std::move(members);
+  return value;
+}
+
+bool JsonValue::as_bool() const {
+  if (kind_ != Kind::Bool) {
+    wrong_kind("boolean");
+  }
+  return flag_;
+}
+
+double JsonValue::as_number() const {
+  if (kind_ != Kind::Number) {
+    wrong_kind("number");
+  }
+  return number_;
+}
+
+const std::string& JsonValue::as_string() const {
+  if (kind_ != Kind::String) {
+    wrong_kind("string");
+  }
+  return text_;
+}
+
+const std::vector<JsonValue>& JsonValue::items() const {
+  if (kind_ != Kind::Array) {
+    wrong_kind("array");
+  }
+  return items_;
+}
+
+const std::vector<std::pair<std::string, JsonValue>>& JsonValue::members() const {
+  if (kind_ != Kind::Object) {
+    wrong_kind("object");
+  }
+  return members_;
+}
+
+const JsonValue* JsonValue::find(std::string_view name) const {
+  for (const auto& [key, value] : members()) {
+    if (key == name) {
+      return &value;
+    }
+  }
+  return nullptr;
+}
+
+JsonValue parse_json(std::string_view text) { return Parser(text).document(); }
+
+}  // namespace log_sheriff
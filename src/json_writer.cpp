@@ -0,0 +1,274 @@
+#include "log_sheriff/json_writer.hpp"
+
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace log_sheriff {
+namespace {
+
+bool needs_escape(unsigned char ch) { return ch < 0x20 || ch == '"' || ch == '\\'; }
+
+// Offset of the first byte in [pos, size) that needs escaping, or `size`.
+std::size_t find_escape(std::string_view text, std::size_t pos) {
+  const char* data = text.data();
+  const std::size_t size = text.size();
+
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  // Control characters are the bytes below 0x20; saturating subtraction maps exactly those to 0.
+  const __m128i control_limit = _mm_set1_epi8(0x1F);
+  const __m128i zero = _mm_setzero_si128();
+  for (; pos + 16 <= size; pos += 16) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+    const __m128i control = _mm_cmpeq_epi8(_mm_subs_epu8(chunk, control_limit), zero);
+    const __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+    const int mask = _mm_movemask_epi8(_mm_or_si128(control, special));
+    if (mask != 0) {
+      return pos + static_cast<std::size_t>(std::countr_zero(static_cast<unsigned>(mask)));
+    }
+  }
+#else
+  // Portable fallback: test eight bytes per step with the classic has-zero-byte trick.
+  constexpr std::uint64_t kOnes = 0x0101010101010101ULL;
+  constexpr std::uint64_t kHighs = 0x8080808080808080ULL;
+  for (; pos + 8 <= size; pos += 8) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, data + pos, sizeof(word));
+    const std::uint64_t quote = word ^ (kOnes * '"');
+    const std::uint64_t backslash = word ^ (kOnes * '\\');
+    const std::uint64_t hits = ((quote - kOnes) & ~quote) | ((backslash - kOnes) & ~backslash) |
+                               ((word - kOnes * 0x20) & ~word);
+    if ((hits & kHighs) != 0) {
+      break;
+    }
+  }
+#endif
+
+  for (; pos < size; ++pos) {
+    if (needs_escape(static_cast<unsigned char>(data[pos]))) {
+      return pos;
+    }
+  }
+  return size;
+}
+
+}  // namespace
+
+void append_json_escaped(std::string& out, std::string_view text) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  std::size_t pos = 0;
+  while (pos < text.size()) {
+    const std::size_t stop = find_escape(text, pos);
+    out.append(text.data() + pos, stop - pos);
+    if (stop == text.size()) {
+      return;
+    }
+
+    const auto ch = static_cast<unsigned char>(text[stop]);
+    switch (ch) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\b':
+        out += "\\b";
+        break;
+      case '\f':
+        out += "\\f";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        out += "\\u00";
+        out.push_back(kHex[ch >> 4]);
+        out.push_back(kHex[ch & 0xF]);
+    }
+    pos = stop + 1;
+  }
+}
+
+JsonWriter::JsonWriter(std::FILE* out, int pretty_depth, std::size_t buffer_bytes)
+    : out_(out), pretty_depth_(pretty_depth), buffer_bytes_(buffer_bytes) {
+  buffer_.reserve(buffer_bytes_);
+}
+
+JsonWriter::JsonWriter(std::string& out, int pretty_depth)
+    : sink_(&out), pretty_depth_(pretty_depth), buffer_bytes_(kDefaultBufferBytes) {
+  buffer_.reserve(buffer_bytes_);
+}
+
+JsonWriter::~JsonWriter() {
+  if (sink_ != nullptr) {
+    sink_->append(buffer_);
+  } else if (!buffer_.empty()) {
+    std::fwrite(buffer_.data(), 1, buffer_.size(), out_);
+  }
+}
+
+void JsonWriter::flush() {
+  if (buffer_.empty()) {
+    return;
+  }
+  if (sink_ != nullptr) {
+    sink_->append(buffer_);
+    buffer_.clear();
+    return;
+  }
+  const std::size_t size = buffer_.size();
+  const std::size_t written = std::fwrite(buffer_.data(), 1, size, out_);
+  buffer_.clear();
+  if (written != size) {
+    throw std::runtime_error("failed to write JSON output");
+  }
+}
+
+void JsonWriter::maybe_flush() {
+  if (buffer_.size() >= buffer_bytes_) {
+    flush();
+  }
+}
+
+void JsonWriter::newline_indent(std::size_t depth) {
+  buffer_.push_back('\n');
+  buffer_.append(depth * 2, ' ');
+}
+
+void JsonWriter::separate() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+  if (frames_.empty()) {
+    return;
+  }
+
+  Frame& frame = frames_.back();
+  const bool pretty = frames_.size() <= static_cast<std::size_t>(pretty_depth_);
+  if (!frame.first) {
+    buffer_.push_back(',');
+  }
+  if (pretty) {
+    newline_indent(frames_.size());
+  } else if (!frame.first && pretty_depth_ > 0) {
+    buffer_.push_back(' ');
+  }
+  frame.first = false;
+}
+
+void JsonWriter::open(char bracket) {
+  separate();
+  buffer_.push_back(bracket);
+  frames_.push_back(Frame{});
+}
+
+void JsonWriter::close(char bracket) {
+  const bool pretty = frames_.size() <= static_cast<std::size_t>(pretty_depth_);
+  const bool empty = frames_.back().first;
+  frames_.pop_back();
+  if (pretty && !empty) {
+    newline_indent(frames_.size());
+  }
+  buffer_.push_back(bracket);
+  maybe_flush();
+}
+
+JsonWriter& JsonWriter::begin_object() {
+  open('{');
+  return *this;
+}
+
+JsonWriter& JsonWriter::end_object() {
+  close('}');
+  return *this;
+}
+
+JsonWriter& JsonWriter::begin_array() {
+  open('[');
+  return *this;
+}
+
+JsonWriter& JsonWriter::end_array() {
+  close(']');
+  return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+  separate();
+  buffer_.push_back('"');
+  append_json_escaped(buffer_, name);
+  buffer_ += pretty_depth_ > 0 ? "\": " : "\":";
+  after_key_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+  separate();
+  buffer_.push_back('"');
+  append_json_escaped(buffer_, text);
+  buffer_.push_back('"');
+  maybe_flush();
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+  separate();
+  buffer_ += flag ? "true" : "false";
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+  if (!std::isfinite(number)) {
+    return null();
+  }
+  char digits[32];
+  const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+  return this->number(std::string_view(digits, static_cast<std::size_t>(result.ptr - digits)));
+}
+
+JsonWriter& JsonWriter::signed_value(std::int64_t number) {
+  char digits[24];
+  const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+  return this->number(std::string_view(digits, static_cast<std::size_t>(result.ptr - digits)));
+}
+
+JsonWriter& JsonWriter::unsigned_value(std::uint64_t number) {
+  char digits[24];
+  const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+  return this->number(std::string_view(digits, static_cast<std::size_t>(result.ptr - digits)));
+}
+
+JsonWriter& JsonWriter::null() {
+  separate();
+  buffer_ += "null";
+  return *this;
+}
+
+JsonWriter& JsonWriter::number(std::string_view formatted) {
+  separate();
+  buffer_ += formatted;
+  return *this;
+}
+
+void JsonWriter::end_record() {
+  buffer_.push_back('\n');
+  maybe_flush();
+}
+
+}  // namespace log_sheriff
@@ -1,47 +1,71 @@
 #include <CLI/CLI.hpp>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
 
+#include "log_sheriff/diff.hpp"
+#include "log_sheriff/input_discovery.hpp"
+#include "log_sheriff/json_writer.hpp"
+#include "log_sheriff/novelty.hpp"
+#include "log_sheriff/partial_io.hpp"
+#include "log_sheriff/pattern_dictionary.hpp"
+#include "log_sheriff/query_server.hpp"
+#include "log_sheriff/range_writer.hpp"
+#include "log_sheriff/result_cache.hpp"
+#include "log_sheriff/result_json.hpp"
+#include "log_sheriff/table_export.hpp"
 #include "log_sheriff/summarizer.hpp"
 
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
 namespace {
 
-std::string escape_json_string(const std::string& value) {
+using log_sheriff::format_number;
+using log_sheriff::format_rate;
+using log_sheriff::format_timestamp_utc;
+
+std::string join(const std::vector<std::string>& values, std::string_view separator) {
   std::string out;
-  out.reserve(value.size());
-  for (const unsigned char ch : value) {
-    switch (ch) {
-      case '"':
-        out += "\\\"";
-        break;
-      case '\\':
-        out += "\\\\";
-        break;
-      case '\b':
-        out += "\\b";
-        break;
-      case '\f':
-        out += "\\f";
-        break;
-      case '\n':
-        out += "\\n";
-        break;
-      case '\r':
-        out += "\\r";
-        break;
-      case '\t':
-        out += "\\t";
-        break;
-      default:
-        if (ch < 0x20) {
-          out += "?";
-        } else {
-          out.push_back(static_cast<char>(ch));
-        }
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    if (i > 0) {
+      out += separator;
     }
+    out += values[i];
+  }
+  return out;
+}
+
+std::string sample_location(const log_sheriff::LineSample& sample) {
+  return sample.source.empty() ? std::to_string(sample.offset) : sample.source + ":" + std::to_string(sample.offset);
+}
+
+// The normalized line, led by its dictionary ID and previous count when it has them
+// (`#12 prev=40`, or `prev=new` for a pattern the dictionary did not know).
+std::string pattern_label(const log_sheriff::TopLine& entry, bool lines_as_ids) {
+  if (!entry.pattern_id.has_value()) {
+    return entry.normalized_line;
+  }
+  std::string out = '#' + std::to_string(*entry.pattern_id) + " prev=" +
+                    (entry.previous_count.has_value() ? std::to_string(*entry.previous_count) : "new");
+  if (!lines_as_ids) {
+    out += "  " + entry.normalized_line;
   }
   return out;
 }
@@ -56,45 +80,346 @@ void print_table(const log_sheriff::SummaryResult& result) {
             << " info=" << result.matched_by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Info)]
             << " debug=" << result.matched_by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Debug)]
             << '\n';
+  std::cout << "Distinct lines: ~" << result.distinct_patterns << '\n';
+  for (const auto& distinct : result.distinct_values) {
+    std::cout << "Distinct " << distinct.field << ": ~" << distinct.estimate << '\n';
+  }
 
   std::cout << "\nTop lines:\n";
   if (result.top_lines.empty()) {
     std::cout << "(no matching lines)\n";
+  } else {
+    const bool has_times = std::any_of(result.top_lines.begin(), result.top_lines.end(),
+                                       [](const auto& entry) { return entry.first_seen.has_value(); });
+    std::cout << (has_times ? "Rank  Count  Per min  First seen            Last seen             Normalized line\n"
+                            : "Rank  Count  Normalized line\n");
+    for (std::size_t i = 0; i < result.top_lines.size(); ++i) {
+      const auto& entry = result.top_lines[i];
+      std::cout << (i + 1) << "     " << entry.count << "      ";
+      if (has_times) {
+        if (entry.first_seen.has_value()) {
+          std::cout << format_rate(entry.per_minute) << "    " << format_timestamp_utc(*entry.first_seen) << "  "
+                    << format_timestamp_utc(*entry.last_seen) << "  ";
+        } else {
+          std::cout << "-       -                     -                     ";
+        }
+      }
+      std::cout << pattern_label(entry, result.lines_as_ids) << '\n';
+    }
+  }
+
+  if (std::any_of(result.top_lines.begin(), result.top_lines.end(),
+                  [](const auto& entry) { return !entry.samples.empty(); })) {
+    std::cout << "\nExamples:\n";
+    for (std::size_t i = 0; i < result.top_lines.size(); ++i) {
+      for (const auto& sample : result.top_lines[i].samples) {
+        std::cout << '#' << (i + 1) << "  " << sample_location(sample) << "  " << sample.line << '\n';
+      }
+    }
+  }
+
+  if (!result.group_by.empty()) {
+    std::cout << "\nGroups by " << join(result.group_by, ",") << ":\n";
+    if (result.groups.empty()) {
+      std::cout << "(no matching lines)\n";
+    } else {
+      std::cout << "Rank  Count  Values\n";
+    }
+    for (std::size_t i = 0; i < result.groups.size(); ++i) {
+      const auto& group = result.groups[i];
+      std::cout << (i + 1) << "     " << group.count << "      " << join(group.values, " ") << '\n';
+      for (const auto& entry : group.top_lines) {
+        std::cout << "      " << entry.count << "      " << pattern_label(entry, result.lines_as_ids) << '\n';
+      }
+    }
+    if (result.ungrouped_lines > 0) {
+      std::cout << "Ungrouped lines: " << result.ungrouped_lines << '\n';
+    }
+  }
+
+  if (result.stat_field.has_value()) {
+    std::cout << "\nField " << *result.stat_field << ":\n";
+    std::cout << "Rank  Count  Min  P50  P90  P99  Max\n";
+    const auto print_stats = [](const std::optional<log_sheriff::FieldStats>& stats) {
+      if (!stats.has_value()) {
+        std::cout << "0      -    -    -    -    -\n";
+        return;
+      }
+      std::cout << stats->count << "      " << format_number(stats->min) << "  " << format_number(stats->p50) << "  "
+                << format_number(stats->p90) << "  " << format_number(stats->p99) << "  "
+                << format_number(stats->max) << '\n';
+    };
+    std::cout << "all   ";
+    print_stats(result.stats);
+    for (std::size_t i = 0; i < result.top_lines.size(); ++i) {
+      std::cout << (i + 1) << "     ";
+      print_stats(result.top_lines[i].stats);
+    }
+  }
+
+  if (result.bucket_seconds == 0) {
     return;
   }
 
-  std::cout << "Rank  Count  Normalized line\n";
-  for (std::size_t i = 0; i < result.top_lines.size(); ++i) {
-    const auto& entry = result.top_lines[i];
-    std::cout << (i + 1) << "     " << entry.count << "      " << entry.normalized_line << '\n';
+  std::cout << "\nBuckets (" << result.bucket_seconds << "s):\n";
+  std::cout << "Start                 Matched  Error  Warn  Info  Debug";
+  for (std::size_t rank = 1; rank <= result.top_lines.size(); ++rank) {
+    if (!result.top_lines[rank - 1].buckets.empty()) {
+      std::cout << "  #" << rank;
+    }
+  }
+  std::cout << '\n';
+  for (std::size_t i = 0; i < result.buckets.size(); ++i) {
+    const auto& bucket = result.buckets[i];
+    std::cout << format_timestamp_utc(bucket.start) << "  " << bucket.matched << "  "
+              << bucket.by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Error)] << "  "
+              << bucket.by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Warn)] << "  "
+              << bucket.by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Info)] << "  "
+              << bucket.by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Debug)];
+    for (const auto& entry : result.top_lines) {
+      if (!entry.buckets.empty()) {
+        std::cout << "  " << entry.buckets[i];
+      }
+    }
+    std::cout << '\n';
+  }
+  if (result.unbucketed_lines > 0) {
+    std::cout << "Unbucketed lines: " << result.unbucketed_lines << '\n';
   }
 }
 
 void print_json(const log_sheriff::SummaryResult& result) {
-  std::cout << "{\n";
-  std::cout << "  \"files_processed\": " << result.files_processed << ",\n";
-  std::cout << "  \"total_lines\": " << result.total_lines << ",\n";
-  std::cout << "  \"matched_lines\": " << result.matched_lines << ",\n";
-  std::cout << "  \"matched_by_level\": {\n";
-  std::cout << "    \"error\": " << result.matched_by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Error)] << ",\n";
-  std::cout << "    \"warn\": " << result.matched_by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Warn)] << ",\n";
-  std::cout << "    \"info\": " << result.matched_by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Info)] << ",\n";
-  std::cout << "    \"debug\": " << result.matched_by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Debug)] << "\n";
-  std::cout << "  },\n";
-  std::cout << "  \"top_lines\": [\n";
-
-  for (std::size_t i = 0; i < result.top_lines.size(); ++i) {
-    const auto& entry = result.top_lines[i];
-    std::cout << "    {\"line\": \"" << escape_json_string(entry.normalized_line) << "\", \"count\": "
-              << entry.count << "}";
-    if (i + 1 < result.top_lines.size()) {
-      std::cout << ',';
+  // Top-level members and list entries on their own lines; each entry stays on one line.
+  log_sheriff::JsonWriter json(stdout, 2);
+  log_sheriff::write_result_json(json, result);
+  json.end_record();
+  json.flush();
+}
+
+void print_ndjson(const log_sheriff::SummaryResult& result) {
+  log_sheriff::JsonWriter json(stdout);
+  log_sheriff::write_result_ndjson(json, result);
+  json.flush();
+}
+
+enum class OutputFormat { Table, Json, Ndjson, Csv, Arrow };
+
+struct OutputOptions {
+  bool json = false;
+  bool ndjson = false;
+  std::string format = "table";
+  std::string table = "top";
+};
+
+void add_output_options(CLI::App* command, OutputOptions& output) {
+  command->add_flag("--json", output.json, "Print JSON output (same as --format json).");
+  command->add_flag("--ndjson", output.ndjson, "Print one JSON record per line (same as --format ndjson).");
+  command->add_option("--format", output.format, "Output format: table|json|ndjson|csv|arrow.")
+      ->default_val("table")
+      ->check(CLI::IsMember({"table", "json", "ndjson", "csv", "arrow"}));
+  command->add_option("--table", output.table, "Table exported by csv/arrow: top|buckets|groups.")
+      ->default_val("top")
+      ->check(CLI::IsMember({"top", "buckets", "groups"}));
+}
+
+OutputFormat output_format(const OutputOptions& output) {
+  std::string format = output.format;
+  for (const auto& [flag, name] : {std::pair{output.json, "json"}, std::pair{output.ndjson, "ndjson"}}) {
+    if (!flag) {
+      continue;
     }
-    std::cout << '\n';
+    if (format != "table" && format != name) {
+      throw std::invalid_argument("conflicting output formats: --" + std::string{name} + " and --format " + format);
+    }
+    format = name;
+  }
+
+  if (format == "json") {
+    return OutputFormat::Json;
+  }
+  if (format == "ndjson") {
+    return OutputFormat::Ndjson;
+  }
+  if (format == "csv") {
+    return OutputFormat::Csv;
+  }
+  if (format == "arrow") {
+    return OutputFormat::Arrow;
   }
+  return OutputFormat::Table;
+}
+
+void write_stdout(const std::string& bytes) {
+#if defined(_WIN32)
+  _setmode(_fileno(stdout), _O_BINARY);
+#endif
+  if (std::fwrite(bytes.data(), 1, bytes.size(), stdout) != bytes.size()) {
+    throw std::runtime_error("failed to write output");
+  }
+}
+
+void print_result(const log_sheriff::SummaryResult& result, const OutputOptions& output) {
+  // Table output goes through std::cout; make sure nothing is pending before stdio writes.
+  std::cout.flush();
+  const auto table = log_sheriff::parse_result_table(output.table).value_or(log_sheriff::ResultTable::Top);
+  switch (output_format(output)) {
+    case OutputFormat::Table:
+      print_table(result);
+      break;
+    case OutputFormat::Json:
+      print_json(result);
+      break;
+    case OutputFormat::Ndjson:
+      print_ndjson(result);
+      break;
+    case OutputFormat::Csv:
+      write_stdout(log_sheriff::to_csv(log_sheriff::result_table(result, table)));
+      break;
+    case OutputFormat::Arrow:
+      write_stdout(log_sheriff::to_arrow_stream(log_sheriff::result_table(result, table)));
+      break;
+  }
+}
 
-  std::cout << "  ]\n";
-  std::cout << "}\n";
+struct FilterArgs {
+  std::vector<std::string> recursive;
+  std::string input_format = "text";
+  std::string contains;
+  std::string level;
+  std::string where;
+  std::string since;
+  std::string until;
+  CLI::Option* contains_opt = nullptr;
+  CLI::Option* level_opt = nullptr;
+  CLI::Option* where_opt = nullptr;
+  CLI::Option* since_opt = nullptr;
+  CLI::Option* until_opt = nullptr;
+};
+
+void add_filter_options(CLI::App* command, FilterArgs& args, bool with_recursive = true) {
+  if (with_recursive) {
+    command->add_option("--recursive", args.recursive, "Also read every file below these directories.")
+        ->check(CLI::ExistingDirectory);
+  }
+  command->add_option("--input-format", args.input_format, "How lines are read: text|json|logfmt|syslog|auto.")
+      ->default_val("text")
+      ->check(CLI::IsMember({"text", "json", "logfmt", "syslog", "auto"}, CLI::ignore_case));
+  args.contains_opt = command->add_option("--contains", args.contains, "Filter lines containing this substring.");
+  args.level_opt = command->add_option("--level", args.level, "Filter by level: error|warn|info|debug.")
+                       ->check(CLI::IsMember({"error", "warn", "info", "debug"}, CLI::ignore_case));
+  args.where_opt = command->add_option(
+      "--where", args.where, "Filter by key=value fields, e.g. 'status>=500 and shard=3'.");
+  args.since_opt = command->add_option(
+      "--since",
+      args.since,
+      "Keep lines at or after timestamp (YYYY-MM-DDTHH:MM:SSZ or YYYY-MM-DD HH:MM:SS).");
+  args.until_opt = command->add_option(
+      "--until",
+      args.until,
+      "Keep lines at or before timestamp (YYYY-MM-DDTHH:MM:SSZ or YYYY-MM-DD HH:MM:SS).");
+}
+
+void apply_filters(const FilterArgs& args, log_sheriff::SummarizeOptions& options) {
+  options.input_format = *log_sheriff::parse_input_format(args.input_format);
+  if (args.contains_opt->count() > 0) {
+    options.contains = args.contains;
+  }
+  if (args.level_opt->count() > 0) {
+    options.level = log_sheriff::parse_level(args.level);
+    if (!options.level.has_value()) {
+      throw std::invalid_argument("invalid --level value");
+    }
+  }
+  if (args.where_opt->count() > 0) {
+    options.where = args.where;
+  }
+  if (args.since_opt->count() > 0) {
+    options.since = args.since;
+  }
+  if (args.until_opt->count() > 0) {
+    options.until = args.until;
+  }
+}
+
+void expand_inputs(const FilterArgs& args, log_sheriff::SummarizeOptions& options) {
+  // Expand globs and directories; files found that were last written before --since cannot match.
+  if (options.files.empty() && args.recursive.empty()) {
+    throw std::invalid_argument("no input files supplied");
+  }
+  log_sheriff::DiscoverOptions discover;
+  discover.paths = std::move(options.files);
+  discover.directories = args.recursive;
+  if (options.since.has_value()) {
+    discover.modified_since = log_sheriff::parse_timestamp(*options.since);
+  }
+  options.files = log_sheriff::discover_inputs(discover);
+}
+
+void apply_filter_options(const FilterArgs& args, log_sheriff::SummarizeOptions& options) {
+  apply_filters(args, options);
+  expand_inputs(args, options);
+}
+
+// One side of a diff: a file, a glob or a directory (read recursively), with the shared filters
+// and the side's own time window where given.
+log_sheriff::SummarizeOptions diff_side(const std::string& input, const FilterArgs& filters,
+                                        const std::string& since, const std::string& until) {
+  log_sheriff::SummarizeOptions options;
+  apply_filters(filters, options);
+  if (!since.empty()) {
+    options.since = since;
+  }
+  if (!until.empty()) {
+    options.until = until;
+  }
+  FilterArgs args = filters;
+  std::error_code error;
+  if (std::filesystem::is_directory(input, error)) {
+    args.recursive = {input};
+  } else {
+    options.files = {input};
+  }
+  expand_inputs(args, options);
+  return options;
+}
+
+void print_changes(const std::vector<log_sheriff::PatternChange>& changes) {
+  if (changes.empty()) {
+    std::cout << "(none)\n";
+    return;
+  }
+  std::cout << "Rank  Baseline  Current  Delta  Ratio  z  p  Normalized line\n";
+  for (std::size_t i = 0; i < changes.size(); ++i) {
+    const auto& change = changes[i];
+    std::cout << (i + 1) << "     " << change.baseline_count << "  " << change.current_count << "  "
+              << (change.delta > 0 ? "+" : "") << change.delta << "  " << format_number(change.ratio) << "  "
+              << format_number(change.z_score) << "  " << format_number(change.p_value) << "  "
+              << change.normalized_line << '\n';
+  }
+}
+
+void print_diff(const log_sheriff::DiffResult& diff, bool json_output) {
+  if (json_output) {
+    log_sheriff::JsonWriter json(stdout, 2);
+    log_sheriff::write_diff_json(json, diff);
+    json.end_record();
+    json.flush();
+    return;
+  }
+  std::cout << "Baseline: " << diff.baseline_matched << " matched lines in " << diff.baseline_files << " files\n";
+  std::cout << "Current:  " << diff.current_matched << " matched lines in " << diff.current_files << " files\n";
+  std::cout << "\nIncreased:\n";
+  print_changes(diff.increased);
+  std::cout << "\nDecreased:\n";
+  print_changes(diff.decreased);
+}
+
+int stdout_fd() {
+#if defined(_WIN32)
+  return _fileno(stdout);
+#else
+  return fileno(stdout);
+#endif
 }
 
 }  // namespace
@@ -104,59 +429,271 @@ int main(int argc, char** argv) {
   app.require_subcommand(1);
 
   log_sheriff::SummarizeOptions summarize_options;
-  bool print_json_output = false;
-  std::string level_raw;
-  std::string contains_raw;
-  std::string since_raw;
-  std::string until_raw;
+  OutputOptions summarize_output;
+  FilterArgs summarize_filter;
 
   CLI::App* summarize = app.add_subcommand("summarize", "Summarize one or more log files.");
-  summarize->add_option("files", summarize_options.files, "Input log files.")->required()->check(CLI::ExistingFile);
+  summarize->add_option("files", summarize_options.files, "Input log files or globs such as 'logs/**/*.log'.");
 
-  auto* contains_opt = summarize->add_option("--contains", contains_raw, "Filter lines containing this substring.");
-  auto* level_opt = summarize->add_option("--level", level_raw, "Filter by level: error|warn|info|debug.")
-                        ->check(CLI::IsMember({"error", "warn", "info", "debug"}, CLI::ignore_case));
-  auto* since_opt = summarize->add_option(
-      "--since",
-      since_raw,
-      "Keep lines at or after timestamp (YYYY-MM-DDTHH:MM:SSZ or YYYY-MM-DD HH:MM:SS).");
-  auto* until_opt = summarize->add_option(
-      "--until",
-      until_raw,
-      "Keep lines at or before timestamp (YYYY-MM-DDTHH:MM:SSZ or YYYY-MM-DD HH:MM:SS).");
+  add_filter_options(summarize, summarize_filter);
   summarize->add_option("--top", summarize_options.top_n, "Show top N normalized lines.")
       ->default_val(10)
       ->check(CLI::PositiveNumber);
-  summarize->add_flag("--json", print_json_output, "Print JSON output.");
+  add_output_options(summarize, summarize_output);
+  std::string bucket_raw;
+  auto* bucket_opt = summarize->add_option(
+      "--bucket", bucket_raw, "Histogram matched lines per time bucket of this width (e.g. 30s, 1m, 1h).");
+  std::string stat_field_raw;
+  auto* stat_field_opt = summarize->add_option(
+      "--stat-field", stat_field_raw, "Report p50/p90/p99 of this numeric key=value field per top line.");
+  summarize->add_option("--group-by", summarize_options.group_by, "Count matched lines per value of these fields.");
+  summarize->add_option("--group-top", summarize_options.group_top_n, "Show top N normalized lines per group.")
+      ->default_val(0);
+  summarize->add_option(
+      "--distinct-field", summarize_options.distinct_fields, "Estimate the number of distinct values of these fields.");
+  unsigned hll_precision = log_sheriff::HyperLogLog::kDefaultPrecision;
+  summarize->add_option("--hll-precision", hll_precision, "Precision of distinct-count sketches (4-18).")
+      ->default_val(log_sheriff::HyperLogLog::kDefaultPrecision)
+      ->check(CLI::Range(static_cast<unsigned>(log_sheriff::HyperLogLog::kMinPrecision),
+                         static_cast<unsigned>(log_sheriff::HyperLogLog::kMaxPrecision)));
+  summarize->add_option(
+      "--samples", summarize_options.samples_per_pattern, "Keep N example raw lines per top line.")
+      ->default_val(0)
+      ->check(CLI::Range(static_cast<std::size_t>(0), log_sheriff::ReservoirSampler::kMaxPerKey));
+  summarize->add_flag(
+      "--bucket-patterns", summarize_options.bucket_patterns, "Also show per-bucket counts for the top lines.");
+  summarize->add_option(
+      "--threads", summarize_options.threads, "Summarize N files at a time, largest first (0: one per CPU).")
+      ->default_val(1);
+  std::string multiline_raw = "none";
+  summarize->add_option(
+      "--multiline", multiline_raw, "Join continuation lines into one record: none|indent|timestamp.")
+      ->default_val("none")
+      ->check(CLI::IsMember({"none", "indent", "timestamp"}, CLI::ignore_case));
+
+  std::string save_partial_path;
+  summarize->add_option(
+      "--save-partial", save_partial_path, "Also write a mergeable summary partial to this path.");
+  std::string cache_dir;
+  summarize->add_option(
+      "--cache-dir", cache_dir, "Reuse per-file results cached in this directory; appended files read only new bytes.");
+  bool resume = false;
+  summarize->add_flag(
+      "--resume", resume, "Resume from per-file checkpoints (in --cache-dir or the user cache), reading only new bytes.");
+  std::string dictionary_path;
+  summarize->add_option(
+      "--dictionary", dictionary_path, "Give top lines stable IDs from this pattern dictionary, updating it.");
+  bool ids_only = false;
+  summarize->add_flag("--ids-only", ids_only, "Name top lines by dictionary ID only (needs --dictionary).");
+
+  std::vector<std::string> merge_inputs;
+  std::size_t merge_top_n = 10;
+  std::size_t merge_group_top_n = 0;
+  OutputOptions merge_output;
+  std::string merge_save_partial_path;
+
+  CLI::App* merge = app.add_subcommand("merge", "Merge summary partials written by --save-partial.");
+  merge->add_option("partials", merge_inputs, "Input summary partials.")->required()->check(CLI::ExistingFile);
+  merge->add_option("--top", merge_top_n, "Show top N normalized lines.")
+      ->default_val(10)
+      ->check(CLI::PositiveNumber);
+  merge->add_option("--group-top", merge_group_top_n, "Show top N normalized lines per group.")->default_val(0);
+  add_output_options(merge, merge_output);
+  merge->add_option("--save-partial", merge_save_partial_path, "Also write the merged partial to this path.");
+
+  log_sheriff::SummarizeOptions filter_options;
+  FilterArgs filter_args;
+  bool filter_count_only = false;
+
+  CLI::App* filter = app.add_subcommand("filter", "Print the lines that match the filters.");
+  filter->add_option("files", filter_options.files, "Input log files or globs such as 'logs/**/*.log'.");
+  add_filter_options(filter, filter_args);
+  filter->add_flag("--count", filter_count_only, "Print only the number of matching lines.");
+  bool filter_time_order = false;
+  filter->add_flag(
+      "--time-order", filter_time_order, "Interleave the files' lines by timestamp instead of one file after another.");
+
+  std::string diff_baseline;
+  std::string diff_current;
+  FilterArgs diff_filter;
+  std::string diff_baseline_since;
+  std::string diff_baseline_until;
+  std::string diff_current_since;
+  std::string diff_current_until;
+  std::size_t diff_top_n = 10;
+  double diff_max_p = 1.0;
+  std::size_t diff_threads = 1;
+  bool diff_json = false;
+
+  CLI::App* diff = app.add_subcommand("diff", "Compare pattern frequencies between two file sets or time windows.");
+  diff->add_option("baseline", diff_baseline, "Baseline file, quoted glob or directory.")->required();
+  diff->add_option("current", diff_current, "Current file, quoted glob or directory.")->required();
+  add_filter_options(diff, diff_filter, false);
+  diff->add_option("--baseline-since", diff_baseline_since, "Baseline window start (overrides --since).");
+  diff->add_option("--baseline-until", diff_baseline_until, "Baseline window end (overrides --until).");
+  diff->add_option("--current-since", diff_current_since, "Current window start (overrides --since).");
+  diff->add_option("--current-until", diff_current_until, "Current window end (overrides --until).");
+  diff->add_option("--top", diff_top_n, "Show top N increased and decreased patterns.")
+      ->default_val(10)
+      ->check(CLI::PositiveNumber);
+  diff->add_option("--max-p", diff_max_p, "Only show changes with a p-value at or below this.")
+      ->default_val(1.0)
+      ->check(CLI::Range(0.0, 1.0));
+  diff->add_option("--threads", diff_threads, "Summarize N files at a time per side (0: one per CPU).")
+      ->default_val(1);
+  diff->add_flag("--json", diff_json, "Print JSON output.");
+
+  log_sheriff::SummarizeOptions novel_options;
+  FilterArgs novel_filter;
+  std::string novel_dictionary;
+  std::string novel_partial;
+  bool novel_follow = false;
+  std::size_t novel_poll_ms = 500;
+  bool novel_json = false;
+
+  CLI::App* novel = app.add_subcommand("novel", "Print lines whose pattern is not in a baseline, as they appear.");
+  novel->add_option("files", novel_options.files, "Input log files or globs such as 'logs/**/*.log'.");
+  add_filter_options(novel, novel_filter);
+  novel->add_option(
+      "--baseline-dictionary", novel_dictionary, "Known patterns: a dictionary written by summarize --dictionary.")
+      ->check(CLI::ExistingFile);
+  novel->add_option("--baseline-partial", novel_partial, "Known patterns: a partial written by --save-partial.")
+      ->check(CLI::ExistingFile);
+  novel->add_flag("--follow", novel_follow, "Keep watching the files for appended lines.");
+  novel->add_option("--poll-ms", novel_poll_ms, "How often --follow checks the files, in milliseconds.")
+      ->default_val(500)
+      ->check(CLI::PositiveNumber);
+  novel->add_flag("--json", novel_json, "Print one JSON record per new pattern.");
+
+  std::string socket_path;
+  std::size_t serve_threads = 0;
+  log_sheriff::QueryEngine::Limits serve_limits;
+
+  CLI::App* serve = app.add_subcommand("serve", "Answer JSON summarize queries over a Unix domain socket.");
+  serve->add_option("--socket", socket_path, "Path of the socket to listen on.")->required();
+  serve->add_option("--threads", serve_threads, "Worker threads (0: one per CPU).")->default_val(0);
+  serve->add_option("--max-cached-partials", serve_limits.cached_partials, "Per-file summaries kept in memory.")
+      ->default_val(serve_limits.cached_partials)
+      ->check(CLI::PositiveNumber);
 
   CLI11_PARSE(app, argc, argv);
 
   if (*summarize) {
-    if (contains_opt->count() > 0) {
-      summarize_options.contains = contains_raw;
+    // Reject conflicting format flags before doing any work.
+    output_format(summarize_output);
+    if (ids_only && dictionary_path.empty()) {
+      throw std::invalid_argument("--ids-only needs --dictionary");
     }
-    if (level_opt->count() > 0) {
-      summarize_options.level = log_sheriff::parse_level(level_raw);
-      if (!summarize_options.level.has_value()) {
-        throw std::invalid_argument("invalid --level value");
+    apply_filter_options(summarize_filter, summarize_options);
+    if (stat_field_opt->count() > 0) {
+      summarize_options.stat_field = stat_field_raw;
+    }
+    summarize_options.hll_precision = static_cast<std::uint8_t>(hll_precision);
+    summarize_options.multiline = *log_sheriff::parse_multiline_mode(multiline_raw);
+    if (bucket_opt->count() > 0) {
+      const auto width = log_sheriff::parse_duration(bucket_raw);
+      if (!width.has_value()) {
+        throw std::invalid_argument("invalid --bucket value; expected e.g. 30s, 1m, 1h or 1d");
       }
+      summarize_options.bucket_seconds = *width;
     }
-    if (since_opt->count() > 0) {
-      summarize_options.since = since_raw;
+
+    log_sheriff::SummaryPartial partial;
+    if (resume || !cache_dir.empty()) {
+      log_sheriff::ResultCache cache(cache_dir.empty() ? log_sheriff::default_cache_directory()
+                                                         : std::filesystem::path(cache_dir));
+      partial = cache.summarize_partial(summarize_options);
+    } else {
+      const log_sheriff::Summarizer analyzer;
+      partial = analyzer.summarize_partial(summarize_options);
     }
-    if (until_opt->count() > 0) {
-      summarize_options.until = until_raw;
+    if (!save_partial_path.empty()) {
+      log_sheriff::write_partial_file(save_partial_path, partial);
     }
 
-    const log_sheriff::Summarizer analyzer;
-    const log_sheriff::SummaryResult result = analyzer.summarize(summarize_options);
+    log_sheriff::SummaryResult result =
+        log_sheriff::finalize(partial, summarize_options.top_n, summarize_options.group_top_n);
+    if (!dictionary_path.empty()) {
+      log_sheriff::apply_pattern_dictionary(dictionary_path, partial, result);
+      result.lines_as_ids = ids_only;
+    }
+    print_result(result, summarize_output);
+  }
 
-    if (print_json_output) {
-      print_json(result);
+  if (*merge) {
+    // Reject conflicting format flags before doing any work.
+    output_format(merge_output);
+    log_sheriff::SummaryPartial merged;
+    for (const std::string& path : merge_inputs) {
+      log_sheriff::merge(merged, log_sheriff::read_partial_file(path));
+    }
+    if (!merge_save_partial_path.empty()) {
+      log_sheriff::write_partial_file(merge_save_partial_path, merged);
+    }
+
+    print_result(log_sheriff::finalize(merged, merge_top_n, merge_group_top_n), merge_output);
+  }
+
+  if (*filter) {
+    apply_filter_options(filter_args, filter_options);
+    const log_sheriff::LineFilter line_filter(filter_options);
+
+    // Matched lines are written straight from the mapped input, one file at a time.
+    log_sheriff::RangeWriter out(stdout_fd());
+    std::uint64_t matched = 0;
+    if (filter_time_order) {
+      matched = log_sheriff::emit_matching_file_lines_by_time(filter_options.files, line_filter,
+                                                              filter_count_only ? nullptr : &out);
     } else {
-      print_table(result);
+      for (const std::string& path : filter_options.files) {
+        matched += log_sheriff::emit_matching_file_lines(path, line_filter, filter_count_only ? nullptr : &out);
+      }
+    }
+    if (filter_count_only) {
+      std::cout << matched << '\n';
     }
   }
 
+  if (*diff) {
+    log_sheriff::SummarizeOptions baseline =
+        diff_side(diff_baseline, diff_filter, diff_baseline_since, diff_baseline_until);
+    log_sheriff::SummarizeOptions current =
+        diff_side(diff_current, diff_filter, diff_current_since, diff_current_until);
+    baseline.threads = diff_threads;
+    current.threads = diff_threads;
+    print_diff(log_sheriff::diff_summaries(baseline, current, diff_top_n, diff_max_p), diff_json);
+  }
+
+  if (*novel) {
+    apply_filter_options(novel_filter, novel_options);
+    const log_sheriff::PatternDictionary dictionary =
+        novel_dictionary.empty() ? log_sheriff::PatternDictionary() : log_sheriff::PatternDictionary(novel_dictionary);
+    const log_sheriff::SummaryPartial baseline =
+        novel_partial.empty() ? log_sheriff::SummaryPartial() : log_sheriff::read_partial_file(novel_partial);
+    log_sheriff::NoveltyDetector detector(novel_options, dictionary, baseline.patterns);
+
+    log_sheriff::WatchOptions watch;
+    watch.follow = novel_follow;
+    watch.poll_interval = std::chrono::milliseconds(novel_poll_ms);
+    log_sheriff::JsonWriter json(stdout);
+    // Each new pattern is written out at once, so it can be alerted on while following.
+    log_sheriff::watch_novelties(detector, novel_options.files, watch, [&](const log_sheriff::Novelty& novelty) {
+      if (novel_json) {
+        json.begin_object().key("source").value(novelty.source).key("offset").value(novelty.offset);
+        json.key("pattern").value(novelty.pattern).key("line").value(novelty.line);
+        json.end_object().end_record();
+        json.flush();
+      } else {
+        std::cout << novelty.source << ':' << novelty.offset << "  " << novelty.pattern << "\n  " << novelty.line
+                  << std::endl;
+      }
+    });
+  }
+
+  if (*serve) {
+    log_sheriff::QueryEngine engine(serve_limits);
+    log_sheriff::serve_unix_socket(socket_path, engine, serve_threads);
+  }
+
   return 0;
 }
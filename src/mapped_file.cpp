@@ -0,0 +1,95 @@
+#include "log_sheriff/mapped_file.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace log_sheriff {
+namespace {
+
+#if !defined(_WIN32)
+bool same_state(const struct stat& lhs, const struct stat& rhs) {
+#if defined(__APPLE__)
+  return lhs.st_size == rhs.st_size && lhs.st_mtimespec.tv_sec == rhs.st_mtimespec.tv_sec &&
+         lhs.st_mtimespec.tv_nsec == rhs.st_mtimespec.tv_nsec;
+#else
+  return lhs.st_size == rhs.st_size && lhs.st_mtim.tv_sec == rhs.st_mtim.tv_sec &&
+         lhs.st_mtim.tv_nsec == rhs.st_mtim.tv_nsec;
+#endif
+}
+#endif
+
+}  // namespace
+
+std::optional<MappedFile> MappedFile::map(const std::string& path) {
+#if defined(_WIN32)
+  if (!std::ifstream(path, std::ios::in | std::ios::binary).is_open()) {
+    throw std::runtime_error("failed to open file: " + path);
+  }
+  return std::nullopt;
+#else
+  // Pipes are not opened here: that open would pair with the writer's, and closing it again
+  // would leave the writer failing and the real reader waiting for another writer.
+  struct stat named {};
+  if (::stat(path.c_str(), &named) != 0) {
+    throw std::runtime_error("failed to open file: " + path);
+  }
+  if (!S_ISREG(named.st_mode) || named.st_size == 0) {
+    return std::nullopt;
+  }
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("failed to open file: " + path);
+  }
+  std::optional<MappedFile> out;
+  struct stat before {};
+  if (::fstat(fd, &before) == 0 && S_ISREG(before.st_mode) && before.st_size > 0) {
+    const auto size = static_cast<std::size_t>(before.st_size);
+    void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address != MAP_FAILED) {
+      out.emplace(MappedFile(static_cast<const char*>(address), size));
+      // A file truncated or rewritten in the meantime may already be shorter than the mapping.
+      struct stat after {};
+      if (::fstat(fd, &after) != 0 || !same_state(before, after)) {
+        out.reset();
+      } else {
+        ::madvise(address, size, MADV_SEQUENTIAL);
+      }
+    }
+  }
+  ::close(fd);
+  return out;
+#endif
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    release();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() { release(); }
+
+void MappedFile::release() noexcept {
+#if !defined(_WIN32)
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+#endif
+  data_ = nullptr;
+  size_ = 0;
+}
+
+}  // namespace log_sheriff
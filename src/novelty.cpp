@@ -0,0 +1,220 @@
+#include "log_sheriff/novelty.hpp"
+
+#include "log_sheriff/binary_io.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <sys/stat.h>
+
+namespace log_sheriff {
+namespace {
+
+// Device and inode of the file a path names; both zero on Windows, where only a shrinking file
+// reveals a replacement.
+struct FileIdentity {
+  std::uint64_t device = 0;
+  std::uint64_t inode = 0;
+
+  bool operator==(const FileIdentity&) const = default;
+};
+
+std::optional<FileIdentity> file_identity(const std::string& path) {
+#if defined(_WIN32)
+  struct _stat64 info {};
+  if (::_stat64(path.c_str(), &info) != 0) {
+    return std::nullopt;
+  }
+  return FileIdentity{};
+#else
+  struct stat info {};
+  if (::stat(path.c_str(), &info) != 0) {
+    return std::nullopt;
+  }
+  return FileIdentity{static_cast<std::uint64_t>(info.st_dev), static_cast<std::uint64_t>(info.st_ino)};
+#endif
+}
+
+// Opens the file `path` names into `in`, along with its identity. The path is identified before
+// and after the open; when the two differ it was rotated in between, and the open is retried.
+// False if the path names no file or it cannot be opened.
+bool open_identified(const std::string& path, std::ifstream& in, FileIdentity& identity) {
+  while (true) {
+    const std::optional<FileIdentity> before = file_identity(path);
+    if (!before.has_value()) {
+      return false;
+    }
+    std::ifstream opened(path, std::ios::in | std::ios::binary);
+    if (!opened.is_open()) {
+      return false;
+    }
+    if (file_identity(path) == before) {
+      in = std::move(opened);
+      identity = *before;
+      return true;
+    }
+  }
+}
+
+// Read position in one watched file. `offset` counts the bytes consumed, `pending` included.
+// The file stays open, so what is written to it after it is renamed away is still read.
+struct Tail {
+  const std::string* path = nullptr;
+  std::ifstream in;
+  FileIdentity identity;
+  std::uint64_t offset = 0;
+  std::string pending;
+};
+
+class Watcher {
+ public:
+  Watcher(NoveltyDetector& detector, const std::function<void(const Novelty&)>& emit)
+      : detector_(detector), emit_(emit), buffer_(kReadChunkBytes) {}
+
+  // Reads what the tail's open file holds past the tail's offset, checking each complete line.
+  // When the path now names another file (rotation), the old file is first read to its end and
+  // its unterminated last line checked, then the new file is read from its beginning. A file
+  // shorter than the offset (truncation) is read again from its beginning. A path that names no
+  // file, or one that cannot be opened, throws std::runtime_error unless `missing_ok`, in which
+  // case only the old file, if any, is read.
+  void read(Tail& tail, bool missing_ok) {
+    if (tail.in.is_open()) {
+      drain(tail);
+      if (file_identity(*tail.path) == tail.identity) {
+        return;
+      }
+    }
+    std::ifstream in;
+    FileIdentity identity;
+    if (!open_identified(*tail.path, in, identity)) {
+      if (missing_ok) {
+        return;
+      }
+      throw std::runtime_error("failed to open file: " + *tail.path);
+    }
+    if (tail.in.is_open()) {
+      finish(tail);
+    }
+    tail.in = std::move(in);
+    tail.identity = identity;
+    tail.offset = 0;
+    drain(tail);
+  }
+
+  // Checks the tail's unterminated last line as if it were complete.
+  void finish(Tail& tail) {
+    if (!tail.pending.empty()) {
+      check(tail, tail.pending, tail.offset - tail.pending.size());
+      tail.pending.clear();
+    }
+  }
+
+ private:
+  // Reads the tail's open file from its offset to its current end.
+  void drain(Tail& tail) {
+    tail.in.clear();
+    tail.in.seekg(0, std::ios::end);
+    const auto size = static_cast<std::uint64_t>(std::max<std::streamoff>(tail.in.tellg(), 0));
+    if (size < tail.offset) {
+      tail.offset = 0;
+      tail.pending.clear();
+    }
+    if (size == tail.offset) {
+      return;
+    }
+    tail.in.seekg(static_cast<std::streamoff>(tail.offset));
+    read_stream_chunks(tail.in, buffer_, [this, &tail](std::span<const char> chunk) { feed(tail, chunk); });
+  }
+
+  void feed(Tail& tail, std::span<const char> data) {
+    const char* cursor = data.data();
+    const char* const end = data.data() + data.size();
+    const std::uint64_t base = tail.offset;
+    tail.offset += data.size();
+
+    if (!tail.pending.empty()) {
+      const auto* newline = static_cast<const char*>(std::memchr(cursor, '\n', data.size()));
+      if (newline == nullptr) {
+        tail.pending.append(cursor, end);
+        return;
+      }
+      const std::uint64_t offset = base - tail.pending.size();
+      tail.pending.append(cursor, newline);
+      check(tail, tail.pending, offset);
+      tail.pending.clear();
+      cursor = newline + 1;
+    }
+    while (cursor < end) {
+      const auto* newline =
+          static_cast<const char*>(std::memchr(cursor, '\n', static_cast<std::size_t>(end - cursor)));
+      if (newline == nullptr) {
+        tail.pending.assign(cursor, end);
+        return;
+      }
+      check(tail, std::string_view(cursor, static_cast<std::size_t>(newline - cursor)),
+            base + static_cast<std::uint64_t>(cursor - data.data()));
+      cursor = newline + 1;
+    }
+  }
+
+  void check(const Tail& tail, std::string_view line, std::uint64_t offset) {
+    if (std::optional<std::string> pattern = detector_.check(line)) {
+      emit_(Novelty{*tail.path, offset, std::move(*pattern), std::string(line)});
+    }
+  }
+
+  NoveltyDetector& detector_;
+  const std::function<void(const Novelty&)>& emit_;
+  std::vector<char> buffer_;
+};
+
+}  // namespace
+
+NoveltyDetector::NoveltyDetector(const SummarizeOptions& options, const PatternDictionary& dictionary,
+                                 const PatternTable& baseline)
+    : filter_(options), record_(options.input_format), dictionary_(dictionary), baseline_(baseline) {}
+
+std::optional<std::string> NoveltyDetector::check(std::string_view line) {
+  ++lines_checked_;
+  std::optional<std::time_t> timestamp;
+  if (!filter_.matches(record_.parse(line), timestamp)) {
+    return std::nullopt;
+  }
+  std::string pattern = normalize_line(record_.message());
+  if (baseline_.find(pattern).has_value() || dictionary_.find(pattern).has_value() || seen_.find(pattern).has_value()) {
+    return std::nullopt;
+  }
+  seen_.add(pattern);
+  return pattern;
+}
+
+void watch_novelties(NoveltyDetector& detector, const std::vector<std::string>& files, const WatchOptions& options,
+                     const std::function<void(const Novelty&)>& emit) {
+  Watcher watcher(detector, emit);
+  std::vector<Tail> tails(files.size());
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    tails[i].path = &files[i];
+    watcher.read(tails[i], false);
+  }
+  if (!options.follow) {
+    for (Tail& tail : tails) {
+      watcher.finish(tail);
+    }
+    return;
+  }
+  while (!options.stop || !options.stop()) {
+    std::this_thread::sleep_for(options.poll_interval);
+    // A rotated file may be missing for a moment before its replacement appears.
+    for (Tail& tail : tails) {
+      watcher.read(tail, true);
+    }
+  }
+}
+
+}  // namespace log_sheriff
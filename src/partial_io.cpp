@@ -0,0 +1,544 @@
+#include "log_sheriff/partial_io.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace log_sheriff {
+namespace {
+
+constexpr std::string_view kMagic = "LSHPART";
+constexpr std::uint64_t kFormatVersion = 8;
+
+void put_varint(std::string& out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+void put_signed(std::string& out, std::int64_t value) {
+  put_varint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+void put_double(std::string& out, double value) {
+  std::uint64_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(bits));
+  for (int i = 0; i < 8; ++i) {
+    out.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+  }
+}
+
+void put_bytes(std::string& out, std::string_view bytes) {
+  put_varint(out, bytes.size());
+  out.append(bytes);
+}
+
+class Reader {
+ public:
+  explicit Reader(std::string_view bytes) : bytes_(bytes) {}
+
+  std::uint64_t varint() {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (pos_ >= bytes_.size()) {
+        fail();
+      }
+      const auto byte = static_cast<unsigned char>(bytes_[pos_++]);
+      value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    fail();
+  }
+
+  std::int64_t signed_varint() {
+    const std::uint64_t raw = varint();
+    return static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1);
+  }
+
+  double fixed_double() {
+    const std::string_view encoded = raw(8);
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i) {
+      bits |= static_cast<std::uint64_t>(static_cast<unsigned char>(encoded[i])) << (8 * i);
+    }
+    double value = 0.0;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  std::string_view bytes() {
+    const std::uint64_t size = varint();
+    if (size > bytes_.size() - pos_) {
+      fail();
+    }
+    const std::string_view out = bytes_.substr(pos_, size);
+    pos_ += size;
+    return out;
+  }
+
+  std::string_view raw(std::size_t size) {
+    if (size > bytes_.size() - pos_) {
+      fail();
+    }
+    const std::string_view out = bytes_.substr(pos_, size);
+    pos_ += size;
+    return out;
+  }
+
+  bool done() const { return pos_ == bytes_.size(); }
+
+  [[noreturn]] static void fail() { throw std::runtime_error("truncated or corrupt summary partial"); }
+
+ private:
+  std::string_view bytes_;
+  std::size_t pos_ = 0;
+};
+
+// The counted buckets in order: the first by its index, each later one by its distance from the
+// one before.
+template <typename T, typename PutValue>
+void put_series(std::string& out, const BucketSeries<T>& series, PutValue put_value) {
+  put_varint(out, series.size());
+  std::optional<std::int64_t> previous;
+  for (const auto& [bucket, value] : series.buckets()) {
+    if (previous.has_value()) {
+      put_varint(out, static_cast<std::uint64_t>(bucket - *previous));
+    } else {
+      put_signed(out, bucket);
+    }
+    previous = bucket;
+    put_value(value);
+  }
+}
+
+// Before version 8 a series was a first index and a dense run of at most kMaxBuckets values.
+template <typename T, typename ReadValue>
+BucketSeries<T> read_series(Reader& reader, std::uint64_t version, ReadValue read_value) {
+  BucketSeries<T> series;
+  if (version < 8) {
+    const std::int64_t first = reader.signed_varint();
+    const std::uint64_t size = reader.varint();
+    if (size > BucketSeries<T>::kMaxBuckets) {
+      Reader::fail();
+    }
+    for (std::uint64_t i = 0; i < size; ++i) {
+      series.at(first + static_cast<std::int64_t>(i)) = read_value();
+    }
+    return series;
+  }
+  const std::uint64_t size = reader.varint();
+  std::int64_t bucket = 0;
+  for (std::uint64_t i = 0; i < size; ++i) {
+    if (i == 0) {
+      bucket = reader.signed_varint();
+    } else {
+      // Unsigned, so the room left above `bucket` is exact even when it is negative.
+      const std::uint64_t gap = reader.varint();
+      const std::uint64_t room =
+          static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) - static_cast<std::uint64_t>(bucket);
+      if (gap == 0 || gap > room) {
+        Reader::fail();
+      }
+      bucket = static_cast<std::int64_t>(static_cast<std::uint64_t>(bucket) + gap);
+    }
+    series.at(bucket) = read_value();
+  }
+  return series;
+}
+
+void put_store(std::string& out, const DDSketch::Store& store) {
+  put_signed(out, store.offset);
+  put_varint(out, store.bins.size());
+  for (const std::uint64_t count : store.bins) {
+    put_varint(out, count);
+  }
+}
+
+DDSketch::Store read_store(Reader& reader) {
+  DDSketch::Store store;
+  store.offset = static_cast<std::int32_t>(reader.signed_varint());
+  const std::uint64_t size = reader.varint();
+  if (size > DDSketch::kMaxBins) {
+    Reader::fail();
+  }
+  store.bins.resize(size);
+  for (std::uint64_t& count : store.bins) {
+    count = reader.varint();
+  }
+  return store;
+}
+
+void put_sketch(std::string& out, const DDSketch& sketch) {
+  put_varint(out, sketch.count());
+  if (sketch.count() == 0) {
+    return;
+  }
+  put_double(out, sketch.min());
+  put_double(out, sketch.max());
+  put_varint(out, sketch.zero_count());
+  put_store(out, sketch.positive());
+  put_store(out, sketch.negative());
+}
+
+DDSketch read_sketch(Reader& reader) {
+  const std::uint64_t count = reader.varint();
+  if (count == 0) {
+    return DDSketch{};
+  }
+  const double min = reader.fixed_double();
+  const double max = reader.fixed_double();
+  const std::uint64_t zero_count = reader.varint();
+  DDSketch::Store positive = read_store(reader);
+  DDSketch::Store negative = read_store(reader);
+  return DDSketch::restore(count, min, max, zero_count, std::move(positive), std::move(negative));
+}
+
+void put_hll(std::string& out, const HyperLogLog& sketch) {
+  put_varint(out, sketch.precision());
+  put_varint(out, sketch.is_sparse() ? 0 : 1);
+  if (!sketch.is_sparse()) {
+    const std::vector<std::uint8_t>& registers = sketch.registers();
+    out.append(reinterpret_cast<const char*>(registers.data()), registers.size());
+    return;
+  }
+  // Entries are sorted, so deltas stay small.
+  const std::vector<std::uint32_t> entries = sketch.sparse_entries();
+  put_varint(out, entries.size());
+  std::uint32_t previous = 0;
+  for (const std::uint32_t entry : entries) {
+    put_varint(out, entry - previous);
+    previous = entry;
+  }
+}
+
+HyperLogLog read_hll(Reader& reader) {
+  const std::uint64_t precision = reader.varint();
+  const std::uint64_t dense = reader.varint();
+  if (precision < HyperLogLog::kMinPrecision || precision > HyperLogLog::kMaxPrecision || dense > 1) {
+    Reader::fail();
+  }
+  try {
+    if (dense == 1) {
+      const std::string_view raw = reader.raw(std::size_t{1} << precision);
+      return HyperLogLog::restore_dense(static_cast<std::uint8_t>(precision),
+                                        std::vector<std::uint8_t>(raw.begin(), raw.end()));
+    }
+    const std::uint64_t size = reader.varint();
+    if (size > (std::size_t{1} << precision)) {
+      Reader::fail();
+    }
+    std::vector<std::uint32_t> entries(size);
+    std::uint64_t previous = 0;
+    for (std::uint32_t& entry : entries) {
+      previous += reader.varint();
+      if (previous > std::numeric_limits<std::uint32_t>::max()) {
+        Reader::fail();
+      }
+      entry = static_cast<std::uint32_t>(previous);
+    }
+    return HyperLogLog::restore_sparse(static_cast<std::uint8_t>(precision), std::move(entries));
+  } catch (const std::invalid_argument&) {
+    Reader::fail();
+  }
+}
+
+}  // namespace
+
+std::string serialize_partial(const SummaryPartial& partial) {
+  std::string out;
+  out.append(kMagic);
+  put_varint(out, kFormatVersion);
+
+  put_varint(out, partial.files_processed);
+  put_varint(out, partial.total_lines);
+  put_varint(out, partial.matched_lines);
+  for (const std::uint64_t count : partial.matched_by_level) {
+    put_varint(out, count);
+  }
+
+  put_varint(out, partial.patterns.size());
+  for (std::size_t i = 0; i < partial.patterns.size(); ++i) {
+    put_bytes(out, partial.patterns.pattern(i));
+    put_varint(out, partial.patterns.count(i));
+  }
+
+  put_varint(out, partial.bucket_seconds);
+  put_varint(out, partial.unbucketed_lines);
+  put_series(out, partial.level_buckets, [&out](const LevelBucket& bucket) {
+    put_varint(out, bucket.matched);
+    for (const std::uint64_t count : bucket.by_level) {
+      put_varint(out, count);
+    }
+  });
+  put_varint(out, partial.pattern_buckets.size());
+  for (const BucketSeries<std::uint64_t>& series : partial.pattern_buckets) {
+    put_series(out, series, [&out](std::uint64_t count) { put_varint(out, count); });
+  }
+
+  std::uint64_t timed_patterns = 0;
+  for (std::size_t i = 0; i < partial.patterns.size(); ++i) {
+    timed_patterns += partial.patterns.first_seen(i).has_value() ? 1 : 0;
+  }
+  put_varint(out, timed_patterns);
+  for (std::size_t i = 0; i < partial.patterns.size(); ++i) {
+    if (const auto first = partial.patterns.first_seen(i); first.has_value()) {
+      put_varint(out, i);
+      put_signed(out, *first);
+      put_varint(out, static_cast<std::uint64_t>(*partial.patterns.last_seen(i) - *first));
+    }
+  }
+
+  put_bytes(out, partial.stat_field.value_or(""));
+  put_sketch(out, partial.stats);
+  put_varint(out, partial.pattern_stats.size());
+  for (const DDSketch& sketch : partial.pattern_stats) {
+    put_sketch(out, sketch);
+  }
+
+  put_varint(out, partial.group_by.size());
+  for (const std::string& key : partial.group_by) {
+    put_bytes(out, key);
+  }
+  put_varint(out, partial.ungrouped_lines);
+  put_varint(out, partial.groups.size());
+  for (std::size_t group = 0; group < partial.groups.size(); ++group) {
+    for (const std::string& value : partial.groups.values(group)) {
+      put_bytes(out, value);
+    }
+    put_varint(out, partial.groups.count(group));
+    put_varint(out, partial.groups.patterns(group).size());
+    for (const auto& [pattern, count] : partial.groups.patterns(group)) {
+      put_varint(out, pattern);
+      put_varint(out, count);
+    }
+  }
+
+  put_hll(out, partial.distinct_patterns);
+  put_varint(out, partial.distinct_fields.size());
+  for (std::size_t i = 0; i < partial.distinct_fields.size(); ++i) {
+    put_bytes(out, partial.distinct_fields[i]);
+    put_hll(out, partial.distinct_values[i]);
+  }
+
+  put_varint(out, partial.sources.size());
+  for (const std::string& source : partial.sources) {
+    put_bytes(out, source);
+  }
+  put_varint(out, partial.samples.per_key());
+  std::uint64_t sampled_patterns = 0;
+  for (std::size_t i = 0; i < partial.samples.keys(); ++i) {
+    sampled_patterns += partial.samples.seen(i) != 0 ? 1 : 0;
+  }
+  put_varint(out, sampled_patterns);
+  for (std::size_t i = 0; i < partial.samples.keys(); ++i) {
+    if (partial.samples.seen(i) == 0) {
+      continue;
+    }
+    const std::vector<ReservoirSampler::Sample> samples = partial.samples.samples(i);
+    put_varint(out, i);
+    put_varint(out, partial.samples.seen(i));
+    put_varint(out, samples.size());
+    for (const ReservoirSampler::Sample& sample : samples) {
+      put_varint(out, sample.source);
+      put_varint(out, sample.offset);
+      put_bytes(out, sample.line);
+    }
+  }
+
+  return out;
+}
+
+bool looks_like_partial(std::string_view bytes) { return bytes.substr(0, kMagic.size()) == kMagic; }
+
+SummaryPartial deserialize_partial(std::string_view bytes) {
+  if (!looks_like_partial(bytes)) {
+    throw std::runtime_error("input is not a log-sheriff summary partial");
+  }
+
+  Reader reader(bytes);
+  reader.raw(kMagic.size());
+  const std::uint64_t version = reader.varint();
+  if (version == 0 || version > kFormatVersion) {
+    throw std::runtime_error("unsupported summary partial version: " + std::to_string(version));
+  }
+
+  SummaryPartial partial;
+  partial.files_processed = reader.varint();
+  partial.total_lines = reader.varint();
+  partial.matched_lines = reader.varint();
+  for (std::uint64_t& count : partial.matched_by_level) {
+    count = reader.varint();
+  }
+
+  const std::uint64_t pattern_count = reader.varint();
+  for (std::uint64_t i = 0; i < pattern_count; ++i) {
+    const std::string_view pattern = reader.bytes();
+    partial.patterns.add(pattern, reader.varint());
+  }
+
+  if (version >= 2) {
+    partial.bucket_seconds = static_cast<std::uint32_t>(reader.varint());
+    partial.unbucketed_lines = reader.varint();
+    partial.level_buckets = read_series<LevelBucket>(reader, version, [&reader] {
+      LevelBucket bucket;
+      bucket.matched = reader.varint();
+      for (std::uint64_t& count : bucket.by_level) {
+        count = reader.varint();
+      }
+      return bucket;
+    });
+    const std::uint64_t series_count = reader.varint();
+    if (series_count > partial.patterns.size()) {
+      Reader::fail();
+    }
+    partial.pattern_buckets.resize(series_count);
+    for (BucketSeries<std::uint64_t>& series : partial.pattern_buckets) {
+      series = read_series<std::uint64_t>(reader, version, [&reader] { return reader.varint(); });
+    }
+  }
+
+  if (version >= 3) {
+    const std::uint64_t timed_patterns = reader.varint();
+    for (std::uint64_t i = 0; i < timed_patterns; ++i) {
+      const std::uint64_t index = reader.varint();
+      if (index >= partial.patterns.size()) {
+        Reader::fail();
+      }
+      const auto first = static_cast<std::time_t>(reader.signed_varint());
+      partial.patterns.observe_time(index, first);
+      partial.patterns.observe_time(index, first + static_cast<std::time_t>(reader.varint()));
+    }
+  }
+
+  if (version >= 4) {
+    if (const std::string_view field = reader.bytes(); !field.empty()) {
+      partial.stat_field = std::string{field};
+    }
+    partial.stats = read_sketch(reader);
+    const std::uint64_t sketch_count = reader.varint();
+    if (sketch_count > partial.patterns.size()) {
+      Reader::fail();
+    }
+    partial.pattern_stats.resize(sketch_count);
+    for (DDSketch& sketch : partial.pattern_stats) {
+      sketch = read_sketch(reader);
+    }
+  }
+
+  if (version >= 5) {
+    const std::uint64_t key_count = reader.varint();
+    for (std::uint64_t i = 0; i < key_count; ++i) {
+      partial.group_by.emplace_back(reader.bytes());
+    }
+    partial.ungrouped_lines = reader.varint();
+    const std::uint64_t group_count = reader.varint();
+    std::vector<std::string_view> values(partial.group_by.size());
+    for (std::uint64_t i = 0; i < group_count; ++i) {
+      for (std::string_view& value : values) {
+        value = reader.bytes();
+      }
+      const std::size_t group = partial.groups.add(values, reader.varint());
+      const std::uint64_t pattern_count = reader.varint();
+      for (std::uint64_t j = 0; j < pattern_count; ++j) {
+        const std::uint64_t pattern = reader.varint();
+        if (pattern >= partial.patterns.size()) {
+          Reader::fail();
+        }
+        partial.groups.add_pattern(group, pattern, reader.varint());
+      }
+    }
+  }
+
+  if (version >= 6) {
+    partial.distinct_patterns = read_hll(reader);
+    const std::uint64_t field_count = reader.varint();
+    for (std::uint64_t i = 0; i < field_count; ++i) {
+      partial.distinct_fields.emplace_back(reader.bytes());
+      partial.distinct_values.push_back(read_hll(reader));
+      if (partial.distinct_values.back().precision() != partial.distinct_patterns.precision()) {
+        Reader::fail();
+      }
+    }
+  } else {
+    // Older partials carry every pattern, so the sketch can be rebuilt exactly.
+    for (std::size_t i = 0; i < partial.patterns.size(); ++i) {
+      partial.distinct_patterns.add(partial.patterns.pattern(i));
+    }
+  }
+
+  if (version >= 7) {
+    const std::uint64_t source_count = reader.varint();
+    for (std::uint64_t i = 0; i < source_count; ++i) {
+      partial.sources.emplace_back(reader.bytes());
+    }
+    const std::uint64_t per_key = reader.varint();
+    if (per_key > ReservoirSampler::kMaxPerKey) {
+      Reader::fail();
+    }
+    partial.samples = ReservoirSampler(per_key);
+    const std::uint64_t sampled_patterns = reader.varint();
+    std::vector<ReservoirSampler::Sample> samples;
+    for (std::uint64_t i = 0; i < sampled_patterns; ++i) {
+      const std::uint64_t pattern = reader.varint();
+      const std::uint64_t seen = reader.varint();
+      const std::uint64_t sample_count = reader.varint();
+      if (pattern >= partial.patterns.size() || sample_count > per_key) {
+        Reader::fail();
+      }
+      samples.resize(sample_count);
+      for (ReservoirSampler::Sample& sample : samples) {
+        const std::uint64_t source = reader.varint();
+        if (source >= partial.sources.size()) {
+          Reader::fail();
+        }
+        sample.source = static_cast<std::uint32_t>(source);
+        sample.offset = reader.varint();
+        sample.line = reader.bytes();
+      }
+      try {
+        partial.samples.restore(pattern, seen, samples);
+      } catch (const std::invalid_argument&) {
+        Reader::fail();
+      }
+    }
+  }
+
+  if (!reader.done()) {
+    Reader::fail();
+  }
+  return partial;
+}
+
+void write_partial_file(const std::string& path, const SummaryPartial& partial) {
+  std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    throw std::runtime_error("failed to open file for writing: " + path);
+  }
+  const std::string bytes = serialize_partial(partial);
+  out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  if (!out) {
+    throw std::runtime_error("failed to write file: " + path);
+  }
+}
+
+SummaryPartial read_partial_file(const std::string& path) {
+  std::ifstream in(path, std::ios::in | std::ios::binary);
+  if (!in.is_open()) {
+    throw std::runtime_error("failed to open file: " + path);
+  }
+  const std::string bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+  return deserialize_partial(bytes);
+}
+
+}  // namespace log_sheriff
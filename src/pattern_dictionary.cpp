@@ -0,0 +1,281 @@
+#include "log_sheriff/pattern_dictionary.hpp"
+
+#include "log_sheriff/binary_io.hpp"
+#include "log_sheriff/hash.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_set>
+#include <vector>
+
+namespace log_sheriff {
+namespace {
+
+constexpr std::string_view kMagic = "LSHPDICT";
+constexpr std::uint64_t kFormatVersion = 1;
+// Magic, then version, size, seed, bucket count, slot count and text size.
+constexpr std::size_t kHeaderBytes = 8 + 6 * 8;
+constexpr std::uint32_t kEmptySlot = std::numeric_limits<std::uint32_t>::max();
+// Displacements tried per bucket, and hash seeds tried, before giving up.
+constexpr std::uint32_t kMaxDisplacement = 1U << 20;
+constexpr std::uint64_t kMaxSeeds = 64;
+
+std::uint64_t align8(std::uint64_t bytes) { return (bytes + 7) & ~std::uint64_t{7}; }
+
+std::uint64_t bucket_of(std::uint64_t hash, std::uint64_t bucket_count) { return (hash >> 32) % bucket_count; }
+
+std::uint64_t slot_of(std::uint64_t hash, std::uint32_t displacement, std::uint64_t slot_count) {
+  return mix64(hash + displacement * 0x9E3779B97F4A7C15ULL) % slot_count;
+}
+
+void pad8(std::string& out) { out.resize(align8(out.size()), '\0'); }
+
+// Displacement per bucket placing every hash in its own slot, or false if some bucket found
+// none (or two hashes are equal) and another seed is needed.
+bool place(const std::vector<std::uint64_t>& hashes, std::uint64_t bucket_count, std::uint64_t slot_count,
+           std::vector<std::uint32_t>& displacements, std::vector<std::uint32_t>& slots) {
+  std::vector<std::vector<std::uint32_t>> buckets(bucket_count);
+  for (std::size_t id = 0; id < hashes.size(); ++id) {
+    buckets[bucket_of(hashes[id], bucket_count)].push_back(static_cast<std::uint32_t>(id));
+  }
+  // Fullest buckets first, while most slots are still free.
+  std::vector<std::uint64_t> order(bucket_count);
+  std::iota(order.begin(), order.end(), std::uint64_t{0});
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::uint64_t lhs, std::uint64_t rhs) { return buckets[lhs].size() > buckets[rhs].size(); });
+
+  displacements.assign(bucket_count, 0);
+  slots.assign(slot_count, kEmptySlot);
+  std::vector<std::uint64_t> taken;
+  for (const std::uint64_t bucket : order) {
+    const std::vector<std::uint32_t>& members = buckets[bucket];
+    if (members.empty()) {
+      break;
+    }
+    bool placed = false;
+    for (std::uint32_t displacement = 0; displacement < kMaxDisplacement && !placed; ++displacement) {
+      taken.clear();
+      placed = true;
+      for (const std::uint32_t id : members) {
+        const std::uint64_t slot = slot_of(hashes[id], displacement, slot_count);
+        if (slots[slot] != kEmptySlot || std::find(taken.begin(), taken.end(), slot) != taken.end()) {
+          placed = false;
+          break;
+        }
+        taken.push_back(slot);
+      }
+      if (placed) {
+        displacements[bucket] = displacement;
+        for (std::size_t i = 0; i < members.size(); ++i) {
+          slots[taken[i]] = members[i];
+        }
+      }
+    }
+    if (!placed) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+PatternDictionary::PatternDictionary(const std::string& path) : file_(MappedFile::map(path)) {
+  if (!file_.has_value()) {
+    // Unmappable here (other platforms, or being replaced right now): an index, not a log, so
+    // it is read whole.
+    std::vector<char> buffer(kReadChunkBytes);
+    read_file_chunks(path, buffer, [this](std::span<const char> chunk) {
+      contents_.insert(contents_.end(), chunk.begin(), chunk.end());
+    });
+  }
+  const std::span<const char> data = file_.has_value() ? file_->data() : std::span<const char>(contents_);
+  const auto invalid = [&path] { return std::runtime_error("invalid pattern dictionary: " + path); };
+  if (data.size() < kHeaderBytes || std::string_view(data.data(), kMagic.size()) != kMagic ||
+      load_u64(data.data() + 8) != kFormatVersion) {
+    throw invalid();
+  }
+  const std::uint64_t size = load_u64(data.data() + 16);
+  seed_ = load_u64(data.data() + 24);
+  bucket_count_ = load_u64(data.data() + 32);
+  slot_count_ = load_u64(data.data() + 40);
+  text_size_ = load_u64(data.data() + 48);
+  // Bounded by the file size first, so the section sizes below cannot overflow.
+  if (size >= kEmptySlot || bucket_count_ == 0 || slot_count_ == 0 || bucket_count_ > data.size() ||
+      slot_count_ > data.size() || text_size_ > data.size()) {
+    throw invalid();
+  }
+  const std::uint64_t displacement_offset = kHeaderBytes;
+  const std::uint64_t slot_offset = displacement_offset + align8(4 * bucket_count_);
+  const std::uint64_t count_offset = slot_offset + align8(4 * slot_count_);
+  const std::uint64_t offset_offset = count_offset + 8 * size;
+  const std::uint64_t text_offset = offset_offset + 8 * (size + 1);
+  if (text_offset + text_size_ != data.size()) {
+    throw invalid();
+  }
+  size_ = static_cast<std::size_t>(size);
+  displacements_ = data.data() + displacement_offset;
+  slots_ = data.data() + slot_offset;
+  counts_ = data.data() + count_offset;
+  offsets_ = data.data() + offset_offset;
+  text_ = data.data() + text_offset;
+  if (load_u64(offsets_) != 0 || load_u64(offsets_ + 8 * size_) != text_size_) {
+    throw invalid();
+  }
+}
+
+std::optional<std::uint32_t> PatternDictionary::find(std::string_view pattern) const {
+  if (size_ == 0) {
+    return std::nullopt;
+  }
+  const std::uint64_t hash = hash_bytes(pattern, seed_);
+  const std::uint32_t displacement = load_u32(displacements_ + 4 * bucket_of(hash, bucket_count_));
+  const std::uint32_t id = load_u32(slots_ + 4 * slot_of(hash, displacement, slot_count_));
+  // The slot of a pattern not in the dictionary holds some other pattern, or nothing.
+  if (id >= size_ || this->pattern(id) != pattern) {
+    return std::nullopt;
+  }
+  return id;
+}
+
+std::string_view PatternDictionary::pattern(std::uint32_t id) const {
+  if (id >= size_) {
+    throw std::out_of_range("pattern id out of range");
+  }
+  const std::uint64_t begin = load_u64(offsets_ + 8 * static_cast<std::size_t>(id));
+  const std::uint64_t end = load_u64(offsets_ + 8 * (static_cast<std::size_t>(id) + 1));
+  if (begin > end || end > text_size_) {
+    throw std::runtime_error("invalid pattern dictionary offsets");
+  }
+  return {text_ + begin, static_cast<std::size_t>(end - begin)};
+}
+
+std::uint64_t PatternDictionary::count(std::uint32_t id) const {
+  if (id >= size_) {
+    throw std::out_of_range("pattern id out of range");
+  }
+  return load_u64(counts_ + 8 * static_cast<std::size_t>(id));
+}
+
+std::string build_pattern_dictionary(std::span<const std::string_view> patterns,
+                                     std::span<const std::uint64_t> counts) {
+  if (patterns.size() != counts.size()) {
+    throw std::invalid_argument("pattern dictionary needs one count per pattern");
+  }
+  if (patterns.size() >= kEmptySlot) {
+    throw std::invalid_argument("too many patterns for a pattern dictionary");
+  }
+  std::unordered_set<std::string_view> unique(patterns.begin(), patterns.end());
+  if (unique.size() != patterns.size()) {
+    throw std::invalid_argument("pattern dictionary patterns must be unique");
+  }
+
+  // About four patterns per bucket, and a little slack in the slots so displacements are found
+  // quickly.
+  const std::uint64_t bucket_count = std::max<std::uint64_t>(1, (patterns.size() + 3) / 4);
+  const std::uint64_t slot_count = patterns.size() + patterns.size() / 16 + 1;
+  std::vector<std::uint64_t> hashes(patterns.size());
+  std::vector<std::uint32_t> displacements;
+  std::vector<std::uint32_t> slots;
+  std::uint64_t seed = 0;
+  for (;; ++seed) {
+    if (seed == kMaxSeeds) {
+      throw std::runtime_error("failed to build pattern dictionary hash");
+    }
+    for (std::size_t id = 0; id < patterns.size(); ++id) {
+      hashes[id] = hash_bytes(patterns[id], seed);
+    }
+    if (place(hashes, bucket_count, slot_count, displacements, slots)) {
+      break;
+    }
+  }
+
+  std::uint64_t text_size = 0;
+  for (const std::string_view pattern : patterns) {
+    text_size += pattern.size();
+  }
+  std::string out{kMagic};
+  put_u64(out, kFormatVersion);
+  put_u64(out, patterns.size());
+  put_u64(out, seed);
+  put_u64(out, bucket_count);
+  put_u64(out, slot_count);
+  put_u64(out, text_size);
+  for (const std::uint32_t displacement : displacements) {
+    put_u32(out, displacement);
+  }
+  pad8(out);
+  for (const std::uint32_t slot : slots) {
+    put_u32(out, slot);
+  }
+  pad8(out);
+  for (const std::uint64_t count : counts) {
+    put_u64(out, count);
+  }
+  std::uint64_t offset = 0;
+  put_u64(out, offset);
+  for (const std::string_view pattern : patterns) {
+    offset += pattern.size();
+    put_u64(out, offset);
+  }
+  for (const std::string_view pattern : patterns) {
+    out.append(pattern);
+  }
+  return out;
+}
+
+void apply_pattern_dictionary(const std::filesystem::path& path, const SummaryPartial& partial,
+                              SummaryResult& result) {
+  const PatternTable& table = partial.patterns;
+  std::string bytes;
+  {
+    std::error_code error;
+    // Mapped until the new file is built from it; released before it is replaced.
+    const PatternDictionary previous =
+        std::filesystem::exists(path, error) ? PatternDictionary(path.string()) : PatternDictionary();
+
+    std::vector<std::string_view> patterns;
+    std::vector<std::uint64_t> counts(previous.size(), 0);
+    patterns.reserve(previous.size() + table.size());
+    for (std::uint32_t id = 0; id < previous.size(); ++id) {
+      patterns.push_back(previous.pattern(id));
+    }
+    // Dictionary ID of each table index.
+    std::vector<std::uint32_t> ids(table.size());
+    for (std::size_t index = 0; index < table.size(); ++index) {
+      if (const auto id = previous.find(table.pattern(index))) {
+        ids[index] = *id;
+        counts[*id] = table.count(index);
+      } else {
+        ids[index] = static_cast<std::uint32_t>(patterns.size());
+        patterns.push_back(table.pattern(index));
+        counts.push_back(table.count(index));
+      }
+    }
+
+    const auto label = [&](TopLine& entry) {
+      if (const auto index = table.find(entry.normalized_line)) {
+        entry.pattern_id = ids[*index];
+      }
+      if (const auto id = previous.find(entry.normalized_line)) {
+        entry.previous_count = previous.count(*id);
+      }
+    };
+    for (TopLine& entry : result.top_lines) {
+      label(entry);
+    }
+    for (GroupCount& group : result.groups) {
+      for (TopLine& entry : group.top_lines) {
+        label(entry);
+      }
+    }
+    bytes = build_pattern_dictionary(patterns, counts);
+  }
+
+  replace_file(path, bytes, "pattern dictionary");
+}
+
+}  // namespace log_sheriff
@@ -0,0 +1,117 @@
+#include "log_sheriff/pattern_table.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace log_sheriff {
+namespace {
+
+constexpr std::time_t kNoTime = std::numeric_limits<std::time_t>::min();
+
+}  // namespace
+
+PatternTable::PatternTable(const PatternTable& other)
+    : index_(other.index_),
+      counts_(other.counts_),
+      first_seen_(other.first_seen_),
+      last_seen_(other.last_seen_) {
+  rebuild_keys();
+}
+
+PatternTable& PatternTable::operator=(const PatternTable& other) {
+  if (this != &other) {
+    index_ = other.index_;
+    counts_ = other.counts_;
+    first_seen_ = other.first_seen_;
+    last_seen_ = other.last_seen_;
+    rebuild_keys();
+  }
+  return *this;
+}
+
+void PatternTable::rebuild_keys() {
+  keys_.assign(index_.size(), nullptr);
+  for (const auto& [key, index] : index_) {
+    keys_[index] = &key;
+  }
+}
+
+std::size_t PatternTable::add(std::string_view pattern, std::uint64_t count) {
+  if (const auto it = index_.find(pattern); it != index_.end()) {
+    counts_[it->second] += count;
+    return it->second;
+  }
+
+  const std::size_t index = keys_.size();
+  const auto [it, inserted] = index_.emplace(std::string{pattern}, index);
+  keys_.push_back(&it->first);
+  counts_.push_back(count);
+  first_seen_.push_back(kNoTime);
+  last_seen_.push_back(kNoTime);
+  return index;
+}
+
+void PatternTable::observe_time(std::size_t index, std::time_t epoch_seconds) {
+  if (first_seen_[index] == kNoTime || epoch_seconds < first_seen_[index]) {
+    first_seen_[index] = epoch_seconds;
+  }
+  if (last_seen_[index] == kNoTime || epoch_seconds > last_seen_[index]) {
+    last_seen_[index] = epoch_seconds;
+  }
+}
+
+std::optional<std::time_t> PatternTable::first_seen(std::size_t index) const {
+  if (first_seen_[index] == kNoTime) {
+    return std::nullopt;
+  }
+  return first_seen_[index];
+}
+
+std::optional<std::time_t> PatternTable::last_seen(std::size_t index) const {
+  if (last_seen_[index] == kNoTime) {
+    return std::nullopt;
+  }
+  return last_seen_[index];
+}
+
+std::optional<std::size_t> PatternTable::find(std::string_view pattern) const {
+  if (const auto it = index_.find(pattern); it != index_.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+std::vector<std::size_t> PatternTable::merge(const PatternTable& other) {
+  std::vector<std::size_t> mapping(other.size());
+  for (std::size_t i = 0; i < other.size(); ++i) {
+    const std::size_t index = add(other.pattern(i), other.count(i));
+    if (other.first_seen_[i] != kNoTime) {
+      observe_time(index, other.first_seen_[i]);
+      observe_time(index, other.last_seen_[i]);
+    }
+    mapping[i] = index;
+  }
+  return mapping;
+}
+
+std::vector<std::size_t> PatternTable::top(std::size_t limit) const {
+  std::vector<std::size_t> order(size());
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+
+  const auto cmp = [this](std::size_t lhs, std::size_t rhs) {
+    if (counts_[lhs] != counts_[rhs]) {
+      return counts_[lhs] > counts_[rhs];
+    }
+    return *keys_[lhs] < *keys_[rhs];
+  };
+
+  limit = std::min(limit, order.size());
+  std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(limit), order.end(), cmp);
+  order.resize(limit);
+  return order;
+}
+
+}  // namespace log_sheriff
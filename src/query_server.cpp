@@ -0,0 +1,501 @@
+#include "log_sheriff/query_server.hpp"
+
+#include "log_sheriff/binary_io.hpp"
+#include "log_sheriff/json_writer.hpp"
+#include "log_sheriff/result_cache.hpp"
+#include "log_sheriff/result_json.hpp"
+#include "log_sheriff/thread_pool.hpp"
+#include "log_sheriff/time_histogram.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace log_sheriff {
+namespace {
+
+// Requests longer than this are answered with an error and the connection is closed.
+constexpr std::size_t kMaxRequestBytes = 1024 * 1024;
+// A client that accepts no response bytes for this long is disconnected.
+constexpr int kSendTimeoutSeconds = 30;
+
+std::string member_error(std::string_view name, std::string_view expected) {
+  return "query member \"" + std::string{name} + "\" must be " + std::string{expected};
+}
+
+const std::string& string_member(std::string_view name, const JsonValue& value) {
+  if (value.kind() != JsonValue::Kind::String) {
+    throw std::invalid_argument(member_error(name, "a string"));
+  }
+  return value.as_string();
+}
+
+std::vector<std::string> strings_member(std::string_view name, const JsonValue& value) {
+  if (value.kind() != JsonValue::Kind::Array) {
+    throw std::invalid_argument(member_error(name, "an array of strings"));
+  }
+  std::vector<std::string> out;
+  for (const JsonValue& item : value.items()) {
+    out.push_back(string_member(name, item));
+  }
+  return out;
+}
+
+std::uint64_t count_member(std::string_view name, const JsonValue& value, std::uint64_t min, std::uint64_t max) {
+  const std::string expected = "an integer from " + std::to_string(min) + " to " + std::to_string(max);
+  if (value.kind() != JsonValue::Kind::Number) {
+    throw std::invalid_argument(member_error(name, expected));
+  }
+  const double number = value.as_number();
+  if (number != std::floor(number) || number < static_cast<double>(min) || number > static_cast<double>(max)) {
+    throw std::invalid_argument(member_error(name, expected));
+  }
+  return static_cast<std::uint64_t>(number);
+}
+
+std::string error_response(std::string_view message) {
+  std::string out;
+  JsonWriter json(out);
+  json.begin_object().key("error").value(message).end_object();
+  json.flush();
+  return out;
+}
+
+#if !defined(_WIN32)
+// Atomic rather than volatile sig_atomic_t: the signal may be handled on another thread than the
+// polling one.
+std::atomic<bool> stop_requested{false};
+static_assert(std::atomic<bool>::is_always_lock_free, "the stop flag is set from a signal handler");
+
+void request_stop(int) { stop_requested = true; }
+
+void write_all(int fd, std::string_view bytes) {
+  while (!bytes.empty()) {
+    const ssize_t written = ::send(fd, bytes.data(), bytes.size(), 0);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("failed to write response: ") + std::strerror(errno));
+    }
+    bytes.remove_prefix(static_cast<std::size_t>(written));
+  }
+}
+
+// One client connection. Its bytes are read on the polling thread; each batch of complete
+// requests is answered on the pool. While a batch is out the connection is not polled, so its
+// responses keep the request order and at most one worker serves it.
+struct Connection {
+  explicit Connection(int client) : fd(client) {}
+
+  int fd;
+  // Bytes after the last complete request; polling thread only.
+  std::string pending;
+  // Guarded by the server's mutex.
+  bool busy = false;
+  bool failed = false;
+};
+
+void answer_requests(int fd, std::string_view batch, QueryEngine& engine) {
+  std::size_t start = 0;
+  for (std::size_t newline = batch.find('\n'); newline != std::string_view::npos;
+       newline = batch.find('\n', start)) {
+    const std::string_view request = batch.substr(start, newline - start);
+    start = newline + 1;
+    if (request.find_first_not_of(" \t\r") == std::string_view::npos) {
+      continue;
+    }
+    write_all(fd, engine.handle(request) + '\n');
+  }
+}
+
+// Receives what `connection` sent and moves its complete requests to `batch`; false once the
+// client hung up.
+bool receive_requests(Connection& connection, std::string& batch) {
+  char buffer[16 * 1024];
+  const ssize_t received = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+  if (received < 0 && errno == EINTR) {
+    return true;
+  }
+  if (received <= 0) {
+    return false;
+  }
+  connection.pending.append(buffer, static_cast<std::size_t>(received));
+  const std::size_t last_newline = connection.pending.rfind('\n');
+  if (last_newline != std::string::npos) {
+    batch = connection.pending.substr(0, last_newline + 1);
+    connection.pending.erase(0, last_newline + 1);
+  }
+  return true;
+}
+#endif
+
+}  // namespace
+
+SummarizeOptions parse_query(const JsonValue& query) {
+  if (query.kind() != JsonValue::Kind::Object) {
+    throw std::invalid_argument("query must be a JSON object");
+  }
+
+  SummarizeOptions options;
+  bool has_files = false;
+  for (const auto& [name, value] : query.members()) {
+    if (name == "op") {
+      if (string_member(name, value) != "summarize") {
+        throw std::invalid_argument("unknown op: " + value.as_string());
+      }
+    } else if (name == "files") {
+      options.files = strings_member(name, value);
+      has_files = true;
+    } else if (name == "input_format") {
+      const auto format = parse_input_format(string_member(name, value));
+      if (!format.has_value()) {
+        throw std::invalid_argument(member_error(name, "one of text, json, logfmt, syslog, auto"));
+      }
+      options.input_format = *format;
+    } else if (name == "multiline") {
+      const auto mode = parse_multiline_mode(string_member(name, value));
+      if (!mode.has_value()) {
+        throw std::invalid_argument(member_error(name, "one of none, indent, timestamp"));
+      }
+      options.multiline = *mode;
+    } else if (name == "contains") {
+      options.contains = string_member(name, value);
+    } else if (name == "level") {
+      options.level = parse_level(string_member(name, value));
+      if (!options.level.has_value()) {
+        throw std::invalid_argument(member_error(name, "one of error, warn, info, debug"));
+      }
+    } else if (name == "where") {
+      options.where = string_member(name, value);
+    } else if (name == "since") {
+      options.since = string_member(name, value);
+    } else if (name == "until") {
+      options.until = string_member(name, value);
+    } else if (name == "top") {
+      options.top_n = count_member(name, value, 1, 1'000'000);
+    } else if (name == "group_by") {
+      options.group_by = strings_member(name, value);
+    } else if (name == "group_top") {
+      options.group_top_n = count_member(name, value, 0, 1'000'000);
+    } else if (name == "bucket") {
+      const auto width = parse_duration(string_member(name, value));
+      if (!width.has_value()) {
+        throw std::invalid_argument(member_error(name, "a duration such as 30s, 1m, 1h or 1d"));
+      }
+      options.bucket_seconds = *width;
+    } else if (name == "bucket_patterns") {
+      if (value.kind() != JsonValue::Kind::Bool) {
+        throw std::invalid_argument(member_error(name, "a boolean"));
+      }
+      options.bucket_patterns = value.as_bool();
+    } else if (name == "stat_field") {
+      options.stat_field = string_member(name, value);
+    } else if (name == "distinct_fields") {
+      options.distinct_fields = strings_member(name, value);
+    } else if (name == "hll_precision") {
+      options.hll_precision = static_cast<std::uint8_t>(
+          count_member(name, value, HyperLogLog::kMinPrecision, HyperLogLog::kMaxPrecision));
+    } else if (name == "samples") {
+      options.samples_per_pattern = count_member(name, value, 0, ReservoirSampler::kMaxPerKey);
+    } else {
+      throw std::invalid_argument("unknown query member: " + name);
+    }
+  }
+  if (!has_files || options.files.empty()) {
+    throw std::invalid_argument("query must name at least one file");
+  }
+  return options;
+}
+
+QueryEngine::QueryEngine(Limits limits) : limits_(limits) {}
+
+std::string QueryEngine::handle(std::string_view request) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.queries;
+  }
+  try {
+    const JsonValue query = parse_json(request);
+    std::string out;
+    JsonWriter json(out);
+    if (query.kind() == JsonValue::Kind::Object) {
+      if (const JsonValue* op = query.find("op"); op != nullptr && op->kind() == JsonValue::Kind::String &&
+                                                  op->as_string() == "stats") {
+        const Stats current = stats();
+        json.begin_object();
+        json.key("queries").value(current.queries);
+        json.key("partial_hits").value(current.partial_hits);
+        json.key("partial_misses").value(current.partial_misses);
+        json.key("cached_partials").value(current.cached_partials);
+        json.end_object();
+        json.flush();
+        return out;
+      }
+    }
+
+    const SummarizeOptions options = parse_query(query);
+    write_result_json(json, finalize(summarize(options), options.top_n, options.group_top_n));
+    json.flush();
+    return out;
+  } catch (const std::exception& error) {
+    return error_response(error.what());
+  }
+}
+
+SummaryPartial QueryEngine::summarize(const SummarizeOptions& options) {
+  return merge_file_partials(options, [this, &options](const std::string& path, const std::string& fingerprint) {
+    return file_partial(path, options, fingerprint);
+  });
+}
+
+QueryEngine::Stats QueryEngine::stats() const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  Stats out = stats_;
+  out.cached_partials = partials_.size();
+  return out;
+}
+
+template <typename Value>
+std::shared_ptr<const Value> QueryEngine::lookup(std::unordered_map<std::string, CacheEntry<Value>>& cache,
+                                                 const std::string& key, const FileIdentity& identity) {
+  const auto found = cache.find(key);
+  if (found == cache.end()) {
+    return nullptr;
+  }
+  if (found->second.identity != identity) {
+    cache.erase(found);
+    return nullptr;
+  }
+  found->second.last_used = ++clock_;
+  return found->second.value;
+}
+
+template <typename Value>
+void QueryEngine::insert(std::unordered_map<std::string, CacheEntry<Value>>& cache, std::size_t limit,
+                         const std::string& key, const FileIdentity& identity, std::shared_ptr<const Value> value) {
+  cache[key] = CacheEntry<Value>{identity, std::move(value), ++clock_};
+  // Eviction scans the cache; it only runs once the cache is full and the limits are small.
+  while (cache.size() > limit) {
+    auto oldest = cache.begin();
+    for (auto it = cache.begin(); it != cache.end(); ++it) {
+      if (it->second.last_used < oldest->second.last_used) {
+        oldest = it;
+      }
+    }
+    cache.erase(oldest);
+  }
+}
+
+std::shared_ptr<const SummaryPartial> QueryEngine::file_partial(const std::string& path,
+                                                                const SummarizeOptions& options,
+                                                                const std::string& fingerprint) {
+  std::error_code error;
+  FileIdentity identity;
+  identity.size = std::filesystem::file_size(path, error);
+  if (!error) {
+    identity.modified = std::filesystem::last_write_time(path, error);
+  }
+  if (error) {
+    throw std::runtime_error("failed to open file: " + path);
+  }
+
+  const std::string key = path + '\n' + fingerprint;
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (auto cached = lookup(partials_, key, identity); cached != nullptr) {
+      ++stats_.partial_hits;
+      return cached;
+    }
+    ++stats_.partial_misses;
+  }
+
+  // Reading and summarizing run unlocked, so concurrent queries only contend on the cache.
+  IncrementalSummarizer summarizer(options);
+  summarizer.begin_source(path);
+  std::vector<char> buffer(kReadChunkBytes);
+  read_file_chunks(path, buffer, [&summarizer](std::span<const char> chunk) { summarizer.feed(chunk); });
+  summarizer.flush();
+  // take_partial() compacts the sketches, so queries on other threads can merge from the cached
+  // partial without writing to it.
+  auto partial = std::make_shared<SummaryPartial>(summarizer.take_partial());
+  partial->files_processed = 1;
+
+  const std::lock_guard<std::mutex> lock(mutex_);
+  insert<SummaryPartial>(partials_, limits_.cached_partials, key, identity, partial);
+  return partial;
+}
+
+void serve_unix_socket(const std::string& socket_path, QueryEngine& engine, std::size_t threads) {
+#if defined(_WIN32)
+  (void)socket_path;
+  (void)engine;
+  (void)threads;
+  throw std::runtime_error("serve requires Unix domain sockets, which this platform lacks");
+#else
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+    throw std::invalid_argument("socket path must be 1 to " + std::to_string(sizeof(address.sun_path) - 1) +
+                                " bytes long");
+  }
+  std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+  struct stat existing {};
+  if (::lstat(socket_path.c_str(), &existing) == 0) {
+    if (!S_ISSOCK(existing.st_mode)) {
+      throw std::runtime_error("refusing to replace non-socket file: " + socket_path);
+    }
+    ::unlink(socket_path.c_str());
+  }
+
+  const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    throw std::runtime_error(std::string("failed to create socket: ") + std::strerror(errno));
+  }
+  if (::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+      ::chmod(socket_path.c_str(), 0600) != 0 || ::listen(listener, 64) != 0) {
+    const std::string reason = std::strerror(errno);
+    ::close(listener);
+    throw std::runtime_error("failed to listen on " + socket_path + ": " + reason);
+  }
+
+  // No SA_RESTART: a signal interrupts poll() so the loop notices the stop promptly.
+  struct sigaction action {};
+  action.sa_handler = request_stop;
+  sigemptyset(&action.sa_mask);
+  ::sigaction(SIGINT, &action, nullptr);
+  ::sigaction(SIGTERM, &action, nullptr);
+  // A client hanging up mid-response must not kill the daemon.
+  std::signal(SIGPIPE, SIG_IGN);
+  stop_requested = false;
+
+  // Workers write a byte here when they finish a batch, so the poll picks their connection up
+  // again without waiting for the timeout.
+  int wake[2];
+  if (::pipe(wake) != 0) {
+    const std::string reason = std::strerror(errno);
+    ::close(listener);
+    throw std::runtime_error("failed to create pipe: " + reason);
+  }
+  ::fcntl(wake[0], F_SETFL, O_NONBLOCK);
+  ::fcntl(wake[1], F_SETFL, O_NONBLOCK);
+
+  std::mutex mutex;
+  std::unordered_map<int, std::shared_ptr<Connection>> connections;
+  {
+    ThreadPool pool(threads);
+    std::vector<pollfd> entries;
+    while (!stop_requested) {
+      entries.assign({pollfd{wake[0], POLLIN, 0}, pollfd{listener, POLLIN, 0}});
+      {
+        const std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = connections.begin(); it != connections.end();) {
+          if (it->second->busy) {
+            ++it;
+          } else if (it->second->failed) {
+            ::close(it->first);
+            it = connections.erase(it);
+          } else {
+            entries.push_back(pollfd{it->first, POLLIN, 0});
+            ++it;
+          }
+        }
+      }
+
+      const int ready = ::poll(entries.data(), entries.size(), 250);
+      if (ready < 0 && errno != EINTR) {
+        throw std::runtime_error(std::string("poll failed: ") + std::strerror(errno));
+      }
+      if (ready <= 0) {
+        continue;
+      }
+      if (entries[0].revents != 0) {
+        char drained[64];
+        while (::read(wake[0], drained, sizeof(drained)) > 0) {
+        }
+      }
+      if ((entries[1].revents & POLLIN) != 0) {
+        if (const int client = ::accept(listener, nullptr, nullptr); client >= 0) {
+          // A client that stops reading its responses would otherwise hold a worker forever.
+          timeval timeout{};
+          timeout.tv_sec = kSendTimeoutSeconds;
+          ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+          connections.emplace(client, std::make_shared<Connection>(client));
+        }
+      }
+
+      for (std::size_t i = 2; i < entries.size(); ++i) {
+        if (entries[i].revents == 0) {
+          continue;
+        }
+        const std::shared_ptr<Connection> connection = connections.at(entries[i].fd);
+        std::string batch;
+        if (!receive_requests(*connection, batch)) {
+          ::close(connection->fd);
+          connections.erase(connection->fd);
+          continue;
+        }
+        const bool too_large = connection->pending.size() > kMaxRequestBytes;
+        if (batch.empty() && !too_large) {
+          continue;
+        }
+        {
+          const std::lock_guard<std::mutex> lock(mutex);
+          connection->busy = true;
+        }
+        pool.submit([&engine, &mutex, connection, batch = std::move(batch), too_large, wake_fd = wake[1]] {
+          bool failed = too_large;
+          try {
+            answer_requests(connection->fd, batch, engine);
+            if (too_large) {
+              write_all(connection->fd, error_response("request too large") + '\n');
+            }
+          } catch (const std::runtime_error&) {
+            // The client went away; nothing to report to.
+            failed = true;
+          }
+          {
+            const std::lock_guard<std::mutex> lock(mutex);
+            connection->busy = false;
+            connection->failed = failed;
+          }
+          const char byte = 0;
+          [[maybe_unused]] const ssize_t written = ::write(wake_fd, &byte, 1);
+        });
+      }
+    }
+  }
+
+  for (const auto& [fd, connection] : connections) {
+    ::close(fd);
+  }
+  ::close(wake[0]);
+  ::close(wake[1]);
+  ::close(listener);
+  ::unlink(socket_path.c_str());
+#endif
+}
+
+}  // namespace log_sheriff
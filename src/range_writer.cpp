@@ -0,0 +1,224 @@
+#include "log_sheriff/range_writer.hpp"
+
+#include "log_sheriff/binary_io.hpp"
+#include "log_sheriff/mapped_file.hpp"
+#include "log_sheriff/time_merge.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace log_sheriff {
+namespace {
+
+constexpr char kNewline[] = "\n";
+
+void queue_line(RangeWriter& out, std::string_view line, bool terminated) {
+  if (terminated) {
+    out.add(std::span<const char>(line.data(), line.size() + 1));
+  } else {
+    out.add(std::span<const char>(line.data(), line.size()));
+    out.add(std::span<const char>(kNewline, 1));
+  }
+}
+
+#if defined(_WIN32)
+void write_ranges(int fd, std::span<const std::span<const char>> ranges) {
+  for (std::span<const char> range : ranges) {
+    while (!range.empty()) {
+      const unsigned chunk = static_cast<unsigned>(std::min<std::size_t>(range.size(), 1U << 30));
+      const int written = _write(fd, range.data(), chunk);
+      if (written <= 0) {
+        throw std::runtime_error("failed to write output");
+      }
+      range = range.subspan(static_cast<std::size_t>(written));
+    }
+  }
+}
+#else
+void write_ranges(int fd, std::span<const std::span<const char>> ranges) {
+  std::vector<iovec> iov(ranges.size());
+  for (std::size_t i = 0; i < ranges.size(); ++i) {
+    iov[i].iov_base = const_cast<char*>(ranges[i].data());
+    iov[i].iov_len = ranges[i].size();
+  }
+
+  std::size_t first = 0;
+  while (first < iov.size()) {
+    const ssize_t written = ::writev(fd, iov.data() + first, static_cast<int>(iov.size() - first));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("failed to write output: ") + std::strerror(errno));
+    }
+    // Skip fully written ranges and trim a partially written one.
+    auto remaining = static_cast<std::size_t>(written);
+    while (first < iov.size() && remaining >= iov[first].iov_len) {
+      remaining -= iov[first].iov_len;
+      ++first;
+    }
+    if (first < iov.size()) {
+      iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + remaining;
+      iov[first].iov_len -= remaining;
+    }
+  }
+}
+#endif
+
+}  // namespace
+
+RangeWriter::RangeWriter(int fd) : fd_(fd) { pending_.reserve(kMaxPending); }
+
+RangeWriter::~RangeWriter() {
+  try {
+    flush();
+  } catch (const std::runtime_error&) {
+  }
+}
+
+void RangeWriter::add(std::span<const char> bytes) {
+  if (bytes.empty()) {
+    return;
+  }
+  if (!pending_.empty() && pending_.back().data() + pending_.back().size() == bytes.data()) {
+    pending_.back() = std::span<const char>(pending_.back().data(), pending_.back().size() + bytes.size());
+    return;
+  }
+  if (pending_.size() == kMaxPending) {
+    flush();
+  }
+  pending_.push_back(bytes);
+}
+
+void RangeWriter::flush() {
+  if (pending_.empty()) {
+    return;
+  }
+  // Drop the batch before writing so a failed write is not retried by the destructor.
+  std::vector<std::span<const char>> ranges;
+  ranges.swap(pending_);
+  pending_.reserve(kMaxPending);
+  write_ranges(fd_, ranges);
+}
+
+std::uint64_t emit_matching_lines(std::span<const char> data, const LineFilter& filter, RangeWriter* out) {
+  std::uint64_t matched = 0;
+  Record record(filter.format());
+  std::optional<std::time_t> timestamp;
+  const char* cursor = data.data();
+  const char* const end = data.data() + data.size();
+  while (cursor < end) {
+    const auto* newline =
+        static_cast<const char*>(std::memchr(cursor, '\n', static_cast<std::size_t>(end - cursor)));
+    const char* const line_end = newline == nullptr ? end : newline;
+    record.parse(std::string_view(cursor, static_cast<std::size_t>(line_end - cursor)));
+    if (filter.matches(record, timestamp)) {
+      ++matched;
+      if (out != nullptr) {
+        queue_line(*out, record.line(), newline != nullptr);
+      }
+    }
+    cursor = line_end + 1;
+  }
+  return matched;
+}
+
+std::uint64_t emit_matching_file_lines(const std::string& path, const LineFilter& filter, RangeWriter* out) {
+  const auto flush = [out] {
+    if (out != nullptr) {
+      out->flush();
+    }
+  };
+  if (const std::optional<MappedFile> file = MappedFile::map(path)) {
+    const std::uint64_t matched = emit_matching_lines(file->data(), filter, out);
+    flush();
+    return matched;
+  }
+
+  std::uint64_t matched = 0;
+  std::vector<char> buffer(kReadChunkBytes);
+  // The unterminated end of the previous block.
+  std::string carry;
+  read_file_chunks(path, buffer, [&](std::span<const char> chunk) {
+    const std::string_view block(chunk.data(), chunk.size());
+    const std::size_t last_newline = block.rfind('\n');
+    if (last_newline == std::string_view::npos) {
+      carry.append(block);
+      return;
+    }
+    std::string_view complete = block.substr(0, last_newline + 1);
+    if (!carry.empty()) {
+      const std::size_t first_newline = complete.find('\n');
+      carry.append(complete.substr(0, first_newline + 1));
+      matched += emit_matching_lines(carry, filter, out);
+      flush();
+      carry.clear();
+      complete.remove_prefix(first_newline + 1);
+    }
+    matched += emit_matching_lines(complete, filter, out);
+    flush();
+    carry.assign(block.substr(last_newline + 1));
+  });
+  matched += emit_matching_lines(carry, filter, out);
+  flush();
+  return matched;
+}
+
+std::uint64_t emit_matching_lines_by_time(const std::vector<std::span<const char>>& inputs, const LineFilter& filter,
+                                          RangeWriter* out) {
+  std::uint64_t matched = 0;
+  TimeMerger merger(inputs, filter.format());
+  TimeMerger::Line line;
+  std::optional<std::time_t> timestamp;
+  while (merger.next(line)) {
+    if (filter.matches(*line.record, timestamp)) {
+      ++matched;
+      if (out != nullptr) {
+        queue_line(*out, line.text, line.terminated);
+      }
+    }
+  }
+  return matched;
+}
+
+std::uint64_t emit_matching_file_lines_by_time(const std::vector<std::string>& paths, const LineFilter& filter,
+                                               RangeWriter* out) {
+  // Every input stays mapped or copied until the merged output is flushed.
+  std::vector<MappedFile> files;
+  std::vector<std::vector<char>> copies;
+  std::vector<std::span<const char>> inputs;
+  files.reserve(paths.size());
+  copies.reserve(paths.size());
+  std::vector<char> buffer(kReadChunkBytes);
+  for (const std::string& path : paths) {
+    if (std::optional<MappedFile> file = MappedFile::map(path)) {
+      inputs.push_back(files.emplace_back(std::move(*file)).data());
+      continue;
+    }
+    std::vector<char>& copy = copies.emplace_back();
+    read_file_chunks(path, buffer,
+                     [&copy](std::span<const char> chunk) { copy.insert(copy.end(), chunk.begin(), chunk.end()); });
+    if (!copy.empty()) {
+      inputs.push_back(copy);
+    }
+  }
+  const std::uint64_t matched = emit_matching_lines_by_time(inputs, filter, out);
+  if (out != nullptr) {
+    out->flush();
+  }
+  return matched;
+}
+
+}  // namespace log_sheriff
@@ -0,0 +1,737 @@
+#include "log_sheriff/record.hpp"
+
+#include "log_sheriff/fields.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <string>
+
+namespace log_sheriff {
+namespace {
+
+std::string to_lower_copy(std::string_view input) {
+  std::string out;
+  out.reserve(input.size());
+  for (unsigned char ch : input) {
+    out.push_back(static_cast<char>(std::tolower(ch)));
+  }
+  return out;
+}
+
+bool line_has_level(std::string_view line, LogLevel wanted) {
+  const std::string lower = to_lower_copy(line);
+  switch (wanted) {
+    case LogLevel::Error:
+      return lower.find("error") != std::string::npos;
+    case LogLevel::Warn:
+      return lower.find("warn") != std::string::npos;
+    case LogLevel::Info:
+      return lower.find("info") != std::string::npos;
+    case LogLevel::Debug:
+      return lower.find("debug") != std::string::npos;
+  }
+  return false;
+}
+
+std::optional<LogLevel> detect_level(std::string_view line) {
+  const std::string lower = to_lower_copy(line);
+  if (lower.find("error") != std::string::npos) {
+    return LogLevel::Error;
+  }
+  if (lower.find("warn") != std::string::npos) {
+    return LogLevel::Warn;
+  }
+  if (lower.find("info") != std::string::npos) {
+    return LogLevel::Info;
+  }
+  if (lower.find("debug") != std::string::npos) {
+    return LogLevel::Debug;
+  }
+  return std::nullopt;
+}
+
+bool parse_fixed_int(std::string_view input, std::size_t pos, std::size_t len, int& value) {
+  if (pos + len > input.size()) {
+    return false;
+  }
+
+  int out = 0;
+  for (std::size_t i = 0; i < len; ++i) {
+    const unsigned char ch = static_cast<unsigned char>(input[pos + i]);
+    if (std::isdigit(ch) == 0) {
+      return false;
+    }
+    out = out * 10 + (ch - static_cast<unsigned char>('0'));
+  }
+
+  value = out;
+  return true;
+}
+
+bool is_leap_year(int year) {
+  if (year % 400 == 0) {
+    return true;
+  }
+  if (year % 100 == 0) {
+    return false;
+  }
+  return year % 4 == 0;
+}
+
+int days_in_month(int year, int month) {
+  static constexpr int kDaysByMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  if (month < 1 || month > 12) {
+    return 0;
+  }
+  if (month == 2 && is_leap_year(year)) {
+    return 29;
+  }
+  return kDaysByMonth[month - 1];
+}
+
+std::time_t to_time_utc(std::tm tm) {
+#if defined(_WIN32)
+  return _mkgmtime(&tm);
+#else
+  return timegm(&tm);
+#endif
+}
+
+std::string_view trim(std::string_view input) {
+  std::size_t start = 0;
+  while (start < input.size() && std::isspace(static_cast<unsigned char>(input[start])) != 0) {
+    ++start;
+  }
+
+  std::size_t end = input.size();
+  while (end > start && std::isspace(static_cast<unsigned char>(input[end - 1])) != 0) {
+    --end;
+  }
+
+  return input.substr(start, end - start);
+}
+
+// The `YYYY-MM-DD?HH:MM:SS` that starts `input`, whatever the separator at index 10.
+bool parse_date_time(std::string_view input, std::tm& tm) {
+  if (input.size() < 19 || input[4] != '-' || input[7] != '-' || input[13] != ':' || input[16] != ':') {
+    return false;
+  }
+
+  int year = 0;
+  int month = 0;
+  int day = 0;
+  int hour = 0;
+  int minute = 0;
+  int second = 0;
+
+  if (!parse_fixed_int(input, 0, 4, year) || !parse_fixed_int(input, 5, 2, month) ||
+      !parse_fixed_int(input, 8, 2, day) || !parse_fixed_int(input, 11, 2, hour) ||
+      !parse_fixed_int(input, 14, 2, minute) || !parse_fixed_int(input, 17, 2, second)) {
+    return false;
+  }
+
+  if (month < 1 || month > 12) {
+    return false;
+  }
+  if (day < 1 || day > days_in_month(year, month)) {
+    return false;
+  }
+  if (hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59) {
+    return false;
+  }
+
+  tm = std::tm{};
+  tm.tm_year = year - 1900;
+  tm.tm_mon = month - 1;
+  tm.tm_mday = day;
+  tm.tm_hour = hour;
+  tm.tm_min = minute;
+  tm.tm_sec = second;
+  tm.tm_isdst = -1;
+  return true;
+}
+
+// Characters taken by the parse_timestamp_prefix timestamp starting `input`, or 0 if there is
+// none. Fills `tm` but leaves the (comparatively slow) conversion to epoch seconds to callers.
+std::size_t timestamp_prefix_length(std::string_view input, std::tm& tm) {
+  if (!parse_date_time(input, tm)) {
+    return 0;
+  }
+
+  const char separator = input[10];
+  if (separator != 'T' && separator != ' ') {
+    return 0;
+  }
+
+  std::size_t consumed_chars = 19;
+  if (separator == 'T') {
+    if (input.size() < 20 || input[19] != 'Z') {
+      return 0;
+    }
+    consumed_chars = 20;
+  }
+
+  if (input.size() > consumed_chars &&
+      std::isspace(static_cast<unsigned char>(input[consumed_chars])) == 0) {
+    return 0;
+  }
+  return consumed_chars;
+}
+
+// RFC 3339 date-time starting `input`: date, 'T' or ' ', time, optional fractional seconds
+// (dropped), then 'Z', a `+HH:MM` or `+HHMM` offset, or nothing for local time.
+std::optional<TimestampPrefix> parse_rfc3339_prefix(std::string_view input) {
+  std::tm tm{};
+  if (!parse_date_time(input, tm) || (input[10] != 'T' && input[10] != 't' && input[10] != ' ')) {
+    return std::nullopt;
+  }
+
+  std::size_t pos = 19;
+  if (pos < input.size() && input[pos] == '.') {
+    const std::size_t digits = ++pos;
+    while (pos < input.size() && std::isdigit(static_cast<unsigned char>(input[pos])) != 0) {
+      ++pos;
+    }
+    if (pos == digits) {
+      return std::nullopt;
+    }
+  }
+
+  std::time_t epoch_seconds = 0;
+  if (pos < input.size() && (input[pos] == 'Z' || input[pos] == 'z')) {
+    epoch_seconds = to_time_utc(tm);
+    ++pos;
+  } else if (pos < input.size() && (input[pos] == '+' || input[pos] == '-')) {
+    const bool colon = pos + 3 < input.size() && input[pos + 3] == ':';
+    int hours = 0;
+    int minutes = 0;
+    if (!parse_fixed_int(input, pos + 1, 2, hours) || !parse_fixed_int(input, pos + (colon ? 4 : 3), 2, minutes) ||
+        hours > 23 || minutes > 59) {
+      return std::nullopt;
+    }
+    const std::time_t offset = (static_cast<std::time_t>(hours) * 60 + minutes) * 60;
+    epoch_seconds = to_time_utc(tm);
+    epoch_seconds = input[pos] == '+' ? epoch_seconds - offset : epoch_seconds + offset;
+    pos += colon ? 6 : 5;
+  } else {
+    epoch_seconds = std::mktime(&tm);
+  }
+
+  if (epoch_seconds == static_cast<std::time_t>(-1)) {
+    return std::nullopt;
+  }
+  return TimestampPrefix{epoch_seconds, pos};
+}
+
+constexpr std::array<std::string_view, 2> kMessageKeys{"msg", "message"};
+constexpr std::array<std::string_view, 3> kLevelKeys{"level", "lvl", "severity"};
+constexpr std::array<std::string_view, 4> kTimeKeys{"ts", "time", "timestamp", "@timestamp"};
+
+template <std::size_t N>
+const JsonFields::Member* find_any(const JsonFields& json, const std::array<std::string_view, N>& keys) {
+  for (const std::string_view key : keys) {
+    if (const JsonFields::Member* member = json.find(key); member != nullptr) {
+      return member;
+    }
+  }
+  return nullptr;
+}
+
+template <std::size_t N>
+std::optional<std::string_view> find_any_field(std::string_view line, const std::array<std::string_view, N>& keys) {
+  for (const std::string_view key : keys) {
+    if (auto value = find_field(line, key); value.has_value()) {
+      return value;
+    }
+  }
+  return std::nullopt;
+}
+
+// Level names used by common structured loggers, case-insensitive.
+std::optional<LogLevel> level_from_name(std::string_view name) {
+  const std::string lower = to_lower_copy(name);
+  if (lower == "error" || lower == "err" || lower == "fatal" || lower == "critical" || lower == "crit" ||
+      lower == "panic" || lower == "alert" || lower == "emerg") {
+    return LogLevel::Error;
+  }
+  if (lower == "warn" || lower == "warning") {
+    return LogLevel::Warn;
+  }
+  if (lower == "info" || lower == "notice") {
+    return LogLevel::Info;
+  }
+  if (lower == "debug" || lower == "trace") {
+    return LogLevel::Debug;
+  }
+  return std::nullopt;
+}
+
+// The level named by the token right after a leading timestamp, as in `<ts> ERROR ...`,
+// `<ts> [warn] ...` or `<ts> info: ...`; nullopt when the line has no such token.
+std::optional<LogLevel> positional_level(std::string_view line) {
+  std::tm tm{};
+  std::size_t pos = timestamp_prefix_length(line, tm);
+  if (pos == 0) {
+    return std::nullopt;
+  }
+  while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) {
+    ++pos;
+  }
+  std::size_t end = pos;
+  while (end < line.size() && std::isspace(static_cast<unsigned char>(line[end])) == 0) {
+    ++end;
+  }
+  std::string_view token = line.substr(pos, end - pos);
+  if (!token.empty() && token.back() == ':') {
+    token.remove_suffix(1);
+  }
+  if (token.empty()) {
+    return std::nullopt;
+  }
+  const bool bracketed = (token.front() == '[' && token.back() == ']') || (token.front() == '<' && token.back() == '>');
+  if (token.size() >= 2 && bracketed) {
+    token = token.substr(1, token.size() - 2);
+  }
+  // Longest level name is "critical"; anything longer is an ordinary word.
+  if (token.size() > 8) {
+    return std::nullopt;
+  }
+  return level_from_name(token);
+}
+
+// A structured timestamp value: an RFC 3339 string or epoch seconds or milliseconds.
+std::optional<std::time_t> timestamp_from_value(std::string_view value) {
+  if (const auto parsed = parse_rfc3339_prefix(value); parsed.has_value()) {
+    return parsed->length == value.size() ? std::optional<std::time_t>(parsed->epoch_seconds) : std::nullopt;
+  }
+  const auto number = parse_number(value);
+  if (!number.has_value() || !std::isfinite(*number) || *number < 0) {
+    return std::nullopt;
+  }
+  // No log is 30,000 years in the future: values this large are milliseconds.
+  return static_cast<std::time_t>(*number >= 1e12 ? *number / 1000.0 : *number);
+}
+
+// Syslog severities 0 (emergency) through 3 (error) are errors; 5 (notice) and 6 are info.
+LogLevel level_from_severity(int severity) {
+  if (severity <= 3) {
+    return LogLevel::Error;
+  }
+  if (severity == 4) {
+    return LogLevel::Warn;
+  }
+  return severity == 7 ? LogLevel::Debug : LogLevel::Info;
+}
+
+constexpr std::array<std::string_view, 12> kMonths{"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                                   "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+bool has_bsd_timestamp_layout(std::string_view input) {
+  return input.size() >= 15 && input[3] == ' ' && input[6] == ' ' && input[9] == ':' && input[12] == ':';
+}
+
+// RFC 3164 `Mmm dd hh:mm:ss` (day space-padded) in local time. It carries no year: take the one
+// that puts it at most a day after `now`, so December lines read in January land last year.
+std::optional<std::time_t> parse_bsd_timestamp(std::string_view input, std::time_t now) {
+  if (!has_bsd_timestamp_layout(input)) {
+    return std::nullopt;
+  }
+  int month = 0;
+  while (month < 12 && kMonths[month] != input.substr(0, 3)) {
+    ++month;
+  }
+  int day = 0;
+  int hour = 0;
+  int minute = 0;
+  int second = 0;
+  const bool padded = input[4] == ' ';
+  if (month == 12 || !parse_fixed_int(input, padded ? 5 : 4, padded ? 1 : 2, day) ||
+      !parse_fixed_int(input, 7, 2, hour) || !parse_fixed_int(input, 10, 2, minute) ||
+      !parse_fixed_int(input, 13, 2, second) || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59) {
+    return std::nullopt;
+  }
+
+  std::tm local{};
+#if defined(_WIN32)
+  localtime_s(&local, &now);
+#else
+  localtime_r(&now, &local);
+#endif
+  std::tm tm{};
+  tm.tm_year = local.tm_year;
+  tm.tm_mon = month;
+  tm.tm_mday = day;
+  tm.tm_hour = hour;
+  tm.tm_min = minute;
+  tm.tm_sec = second;
+  tm.tm_isdst = -1;
+  std::tm copy = tm;
+  std::time_t epoch_seconds = std::mktime(&copy);
+  if (epoch_seconds != static_cast<std::time_t>(-1) && epoch_seconds > now + 86400) {
+    --tm.tm_year;
+    epoch_seconds = std::mktime(&tm);
+  }
+  if (epoch_seconds == static_cast<std::time_t>(-1)) {
+    return std::nullopt;
+  }
+  return epoch_seconds;
+}
+
+struct SyslogHeader {
+  std::optional<int> priority;
+  std::optional<std::time_t> timestamp;
+  std::string_view message;
+};
+
+// `<PRI>1 TIMESTAMP HOST APP PROCID MSGID SD MSG` (RFC 5424) or `[<PRI>]TIMESTAMP HOST MSG`
+// (RFC 3164, also as written to files without the priority). Nil values are `-`.
+std::optional<SyslogHeader> parse_syslog(std::string_view line, std::time_t now) {
+  SyslogHeader header;
+  std::size_t pos = 0;
+  if (!line.empty() && line[0] == '<') {
+    const std::size_t close = line.find('>');
+    int priority = 0;
+    if (close == std::string_view::npos || close < 2 || close > 4 || !parse_fixed_int(line, 1, close - 1, priority) ||
+        priority > 191) {
+      return std::nullopt;
+    }
+    header.priority = priority;
+    pos = close + 1;
+
+    if (pos + 1 < line.size() && std::isdigit(static_cast<unsigned char>(line[pos])) != 0 && line[pos + 1] == ' ') {
+      pos += 2;
+      if (pos < line.size() && line[pos] == '-') {
+        ++pos;
+      } else {
+        const auto parsed = parse_rfc3339_prefix(line.substr(pos));
+        if (!parsed.has_value()) {
+          return std::nullopt;
+        }
+        header.timestamp = parsed->epoch_seconds;
+        pos += parsed->length;
+      }
+      // HOSTNAME, APP-NAME, PROCID and MSGID.
+      for (int i = 0; i < 4; ++i) {
+        if (pos >= line.size() || line[pos] != ' ') {
+          return std::nullopt;
+        }
+        pos = line.find(' ', pos + 1);
+        if (pos == std::string_view::npos) {
+          return std::nullopt;
+        }
+      }
+      ++pos;
+      if (pos < line.size() && line[pos] == '-') {
+        ++pos;
+      } else {
+        while (pos < line.size() && line[pos] == '[') {
+          bool quoted = false;
+          for (++pos; pos < line.size() && (quoted || line[pos] != ']'); ++pos) {
+            if (line[pos] == '\\') {
+              ++pos;
+            } else if (line[pos] == '"') {
+              quoted = !quoted;
+            }
+          }
+          if (pos >= line.size()) {
+            return std::nullopt;
+          }
+          ++pos;
+        }
+      }
+      if (pos < line.size() && line[pos] == ' ') {
+        ++pos;
+      }
+      header.message = line.substr(std::min(pos, line.size()));
+      if (header.message.substr(0, 3) == "\xEF\xBB\xBF") {
+        header.message.remove_prefix(3);
+      }
+      return header;
+    }
+  }
+
+  const std::string_view rest = line.substr(pos);
+  if (const auto bsd = parse_bsd_timestamp(rest, now); bsd.has_value()) {
+    header.timestamp = bsd;
+    pos += 15;
+  } else if (const auto iso = parse_rfc3339_prefix(rest); iso.has_value()) {
+    header.timestamp = iso->epoch_seconds;
+    pos += iso->length;
+  } else if (header.priority.has_value()) {
+    header.message = rest;
+    return header;
+  } else {
+    return std::nullopt;
+  }
+  if (pos >= line.size() || line[pos] != ' ') {
+    return std::nullopt;
+  }
+  // Skip the hostname.
+  const std::size_t host_end = line.find(' ', pos + 1);
+  header.message = host_end == std::string_view::npos ? std::string_view() : line.substr(host_end + 1);
+  return header;
+}
+
+// The format a line's first bytes indicate: `{` JSON, `<PRI>` or a month-day timestamp syslog,
+// a leading `key=` logfmt, anything else text.
+InputFormat detect_format(std::string_view line) {
+  std::size_t pos = 0;
+  while (pos < line.size() && std::isspace(static_cast<unsigned char>(line[pos])) != 0) {
+    ++pos;
+  }
+  if (pos == line.size()) {
+    return InputFormat::Text;
+  }
+  if (line[pos] == '{') {
+    return InputFormat::JsonLines;
+  }
+  if (line[pos] == '<') {
+    return InputFormat::Syslog;
+  }
+  if (has_bsd_timestamp_layout(line) && std::find(kMonths.begin(), kMonths.end(), line.substr(0, 3)) != kMonths.end()) {
+    return InputFormat::Syslog;
+  }
+  const std::size_t key_start = pos;
+  while (pos < line.size() && (std::isalnum(static_cast<unsigned char>(line[pos])) != 0 || line[pos] == '_' ||
+                               line[pos] == '.' || line[pos] == '-' || line[pos] == '@')) {
+    ++pos;
+  }
+  return pos > key_start && pos < line.size() && line[pos] == '=' ? InputFormat::Logfmt : InputFormat::Text;
+}
+}  // namespace
+
+std::optional<LogLevel> parse_level(std::string_view raw) {
+  const std::string lower = to_lower_copy(raw);
+  if (lower == "error") {
+    return LogLevel::Error;
+  }
+  if (lower == "warn") {
+    return LogLevel::Warn;
+  }
+  if (lower == "info") {
+    return LogLevel::Info;
+  }
+  if (lower == "debug") {
+    return LogLevel::Debug;
+  }
+  return std::nullopt;
+}
+
+std::string_view level_name(LogLevel level) {
+  switch (level) {
+    case LogLevel::Error:
+      return "error";
+    case LogLevel::Warn:
+      return "warn";
+    case LogLevel::Info:
+      return "info";
+    case LogLevel::Debug:
+      return "debug";
+  }
+  return "unknown";
+}
+
+std::optional<TimestampPrefix> parse_timestamp_prefix(std::string_view input) {
+  std::tm tm{};
+  const std::size_t consumed_chars = timestamp_prefix_length(input, tm);
+  if (consumed_chars == 0) {
+    return std::nullopt;
+  }
+
+  std::time_t epoch_seconds = 0;
+  if (input[10] == 'T') {
+    epoch_seconds = to_time_utc(tm);
+  } else {
+    epoch_seconds = std::mktime(&tm);
+  }
+
+  if (epoch_seconds == static_cast<std::time_t>(-1)) {
+    return std::nullopt;
+  }
+
+  return TimestampPrefix{epoch_seconds, consumed_chars};
+}
+
+std::optional<std::time_t> parse_timestamp(std::string_view input) {
+  const std::string_view trimmed = trim(input);
+  const auto parsed = parse_timestamp_prefix(trimmed);
+  if (!parsed.has_value()) {
+    return std::nullopt;
+  }
+  if (parsed->length != trimmed.size()) {
+    return std::nullopt;
+  }
+  return parsed->epoch_seconds;
+}
+
+
+std::size_t timestamp_prefix_length(std::string_view line) {
+  std::tm tm{};
+  return timestamp_prefix_length(line, tm);
+}
+
+std::optional<InputFormat> parse_input_format(std::string_view raw) {
+  const std::string lower = to_lower_copy(raw);
+  if (lower == "text") {
+    return InputFormat::Text;
+  }
+  if (lower == "json") {
+    return InputFormat::JsonLines;
+  }
+  if (lower == "logfmt") {
+    return InputFormat::Logfmt;
+  }
+  if (lower == "syslog") {
+    return InputFormat::Syslog;
+  }
+  if (lower == "auto") {
+    return InputFormat::Auto;
+  }
+  return std::nullopt;
+}
+
+std::string_view input_format_name(InputFormat format) {
+  switch (format) {
+    case InputFormat::Text:
+      return "text";
+    case InputFormat::JsonLines:
+      return "json";
+    case InputFormat::Logfmt:
+      return "logfmt";
+    case InputFormat::Syslog:
+      return "syslog";
+    case InputFormat::Auto:
+      return "auto";
+  }
+  return "unknown";
+}
+
+std::optional<MultilineMode> parse_multiline_mode(std::string_view raw) {
+  const std::string lower = to_lower_copy(raw);
+  if (lower == "none") {
+    return MultilineMode::None;
+  }
+  if (lower == "indent") {
+    return MultilineMode::Indent;
+  }
+  if (lower == "timestamp") {
+    return MultilineMode::Timestamp;
+  }
+  return std::nullopt;
+}
+
+std::string_view multiline_mode_name(MultilineMode mode) {
+  switch (mode) {
+    case MultilineMode::None:
+      return "none";
+    case MultilineMode::Indent:
+      return "indent";
+    case MultilineMode::Timestamp:
+      return "timestamp";
+  }
+  return "unknown";
+}
+
+Record::Record(InputFormat format) : format_(format), created_(std::time(nullptr)) {}
+
+const Record& Record::parse(std::string_view line) {
+  line_ = line;
+  kind_ = format_ == InputFormat::Auto ? detect_format(line) : format_;
+  token_level_.reset();
+  if (kind_ == InputFormat::JsonLines && !json_.parse(line)) {
+    kind_ = InputFormat::Text;
+  } else if (kind_ == InputFormat::Syslog) {
+    const auto header = parse_syslog(line, created_);
+    if (header.has_value()) {
+      message_ = header->message;
+      priority_level_ = header->priority.has_value()
+                            ? std::optional<LogLevel>(level_from_severity(*header->priority % 8))
+                            : std::nullopt;
+      header_time_ = header->timestamp;
+    } else {
+      kind_ = InputFormat::Text;
+    }
+  }
+  if (kind_ == InputFormat::Text) {
+    token_level_ = positional_level(line);
+  }
+  return *this;
+}
+
+std::string_view Record::message() const {
+  switch (kind_) {
+    case InputFormat::JsonLines:
+      if (const auto* member = find_any(json_, kMessageKeys); member != nullptr && member->is_string) {
+        return member->value;
+      }
+      break;
+    case InputFormat::Logfmt:
+      return find_any_field(line_, kMessageKeys).value_or(line_);
+    case InputFormat::Syslog:
+      return message_;
+    default:
+      break;
+  }
+  return line_;
+}
+
+std::optional<LogLevel> Record::level() const {
+  switch (kind_) {
+    case InputFormat::JsonLines: {
+      const auto* member = find_any(json_, kLevelKeys);
+      return member != nullptr ? level_from_name(member->value) : std::nullopt;
+    }
+    case InputFormat::Logfmt: {
+      const auto value = find_any_field(line_, kLevelKeys);
+      return value.has_value() ? level_from_name(*value) : std::nullopt;
+    }
+    case InputFormat::Syslog:
+      return priority_level_.has_value() ? priority_level_ : detect_level(message_);
+    default:
+      return token_level_.has_value() ? token_level_ : detect_level(line_);
+  }
+}
+
+bool Record::has_level(LogLevel wanted) const {
+  switch (kind_) {
+    case InputFormat::Text:
+      return token_level_.has_value() ? token_level_ == wanted : line_has_level(line_, wanted);
+    case InputFormat::Syslog:
+      return priority_level_.has_value() ? priority_level_ == wanted : line_has_level(message_, wanted);
+    default:
+      return level() == wanted;
+  }
+}
+
+std::optional<std::time_t> Record::timestamp() const {
+  switch (kind_) {
+    case InputFormat::JsonLines: {
+      const auto* member = find_any(json_, kTimeKeys);
+      return member != nullptr ? timestamp_from_value(member->value) : std::nullopt;
+    }
+    case InputFormat::Logfmt: {
+      const auto value = find_any_field(line_, kTimeKeys);
+      return value.has_value() ? timestamp_from_value(*value) : std::nullopt;
+    }
+    case InputFormat::Syslog:
+      return header_time_;
+    default:
+      if (const auto parsed = parse_timestamp_prefix(line_); parsed.has_value()) {
+        return parsed->epoch_seconds;
+      }
+      return std::nullopt;
+  }
+}
+
+std::optional<std::string_view> Record::field(std::string_view key) const {
+  if (kind_ == InputFormat::JsonLines) {
+    if (const auto* member = json_.find(key); member != nullptr) {
+      return member->value;
+    }
+    return std::nullopt;
+  }
+  return find_field(line_, key);
+}
+}  // namespace log_sheriff
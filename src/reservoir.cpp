@@ -0,0 +1,217 @@
+#include "log_sheriff/reservoir.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace log_sheriff {
+namespace {
+
+// Compaction is skipped for small arenas; rewriting them would cost more than it frees.
+constexpr std::size_t kMinCompactBytes = 64 * 1024;
+
+struct OwnedSample {
+  std::string line;
+  std::uint32_t source = 0;
+  std::uint64_t offset = 0;
+};
+
+// Cuts `line` to at most `limit` bytes without splitting a UTF-8 sequence.
+std::string_view truncate_line(std::string_view line, std::size_t limit) {
+  if (line.size() <= limit) {
+    return line;
+  }
+  std::size_t size = limit;
+  while (size > 0 && (static_cast<unsigned char>(line[size]) & 0xC0) == 0x80) {
+    --size;
+  }
+  return line.substr(0, size);
+}
+
+}  // namespace
+
+ReservoirSampler::ReservoirSampler(std::size_t per_key) : per_key_(per_key) {
+  if (per_key > kMaxPerKey) {
+    throw std::invalid_argument("sample size must be at most " + std::to_string(kMaxPerKey));
+  }
+}
+
+void ReservoirSampler::offer(std::size_t key, std::string_view line, std::uint32_t source, std::uint64_t offset) {
+  if (per_key_ == 0) {
+    return;
+  }
+  reserve_key(key);
+  const std::uint64_t seen = ++seen_[key];
+  if (seen <= per_key_) {
+    store(slots_[key * per_key_ + (seen - 1)], line, source, offset);
+    return;
+  }
+  if (const std::uint64_t slot = below(seen); slot < per_key_) {
+    store(slots_[key * per_key_ + slot], line, source, offset);
+  }
+}
+
+void ReservoirSampler::merge(const ReservoirSampler& other, std::span<const std::size_t> key_mapping,
+                             std::span<const std::uint32_t> source_mapping) {
+  if (&other == this) {
+    const ReservoirSampler copy = other;
+    merge(copy, key_mapping, source_mapping);
+    return;
+  }
+  if (other.seen_.empty()) {
+    return;
+  }
+  if (per_key_ != other.per_key_) {
+    if (!seen_.empty()) {
+      throw std::invalid_argument("cannot merge samples of different sizes");
+    }
+    per_key_ = other.per_key_;
+  }
+
+  std::vector<OwnedSample> mine;
+  std::vector<OwnedSample> theirs;
+  for (std::size_t key = 0; key < other.seen_.size(); ++key) {
+    const std::uint64_t their_seen = other.seen_[key];
+    if (their_seen == 0) {
+      continue;
+    }
+    const std::size_t target = key_mapping[key];
+    reserve_key(target);
+    const std::uint64_t my_seen = seen_[target];
+
+    mine.clear();
+    for (const Sample& sample : samples(target)) {
+      mine.push_back(OwnedSample{std::string{sample.line}, sample.source, sample.offset});
+    }
+    theirs.clear();
+    for (const Sample& sample : other.samples(key)) {
+      theirs.push_back(OwnedSample{std::string{sample.line}, source_mapping[sample.source], sample.offset});
+    }
+
+    // Drawing each slot from a side with probability proportional to the lines that side has
+    // left unrepresented gives a hypergeometric split, i.e. a uniform sample of the union.
+    // Neither side is ever asked for more lines than its own sample holds.
+    std::uint64_t my_left = my_seen;
+    std::uint64_t their_left = their_seen;
+    const std::uint64_t total = my_seen + their_seen;
+    const std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(per_key_, total));
+    std::vector<OwnedSample> chosen;
+    chosen.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      const bool from_mine = below(my_left + their_left) < my_left;
+      std::vector<OwnedSample>& pool = from_mine ? mine : theirs;
+      const std::size_t pick = static_cast<std::size_t>(below(pool.size()));
+      chosen.push_back(std::move(pool[pick]));
+      pool[pick] = std::move(pool.back());
+      pool.pop_back();
+      --(from_mine ? my_left : their_left);
+    }
+
+    for (std::size_t i = 0; i < per_key_; ++i) {
+      Slot& slot = slots_[target * per_key_ + i];
+      garbage_ += slot.size;
+      slot = Slot{};
+    }
+    seen_[target] = total;
+    for (std::size_t i = 0; i < chosen.size(); ++i) {
+      store(slots_[target * per_key_ + i], chosen[i].line, chosen[i].source, chosen[i].offset);
+    }
+  }
+}
+
+std::vector<ReservoirSampler::Sample> ReservoirSampler::samples(std::size_t key) const {
+  std::vector<Sample> out;
+  if (key >= seen_.size()) {
+    return out;
+  }
+  const std::size_t used = static_cast<std::size_t>(std::min<std::uint64_t>(seen_[key], per_key_));
+  out.reserve(used);
+  for (std::size_t i = 0; i < used; ++i) {
+    const Slot& slot = slots_[key * per_key_ + i];
+    out.push_back(Sample{std::string_view(arena_).substr(slot.begin, slot.size), slot.source, slot.offset});
+  }
+  std::sort(out.begin(), out.end(), [](const Sample& lhs, const Sample& rhs) {
+    return std::pair(lhs.source, lhs.offset) < std::pair(rhs.source, rhs.offset);
+  });
+  return out;
+}
+
+void ReservoirSampler::restore(std::size_t key, std::uint64_t seen, std::span<const Sample> samples) {
+  if (samples.size() != std::min<std::uint64_t>(seen, per_key_)) {
+    throw std::invalid_argument("a reservoir holds min(seen, per-key size) samples");
+  }
+  if (per_key_ == 0) {
+    return;
+  }
+  reserve_key(key);
+  for (std::size_t i = 0; i < per_key_; ++i) {
+    Slot& slot = slots_[key * per_key_ + i];
+    garbage_ += slot.size;
+    slot = Slot{};
+  }
+  seen_[key] = seen;
+  for (std::size_t i = 0; i < samples.size(); ++i) {
+    store(slots_[key * per_key_ + i], samples[i].line, samples[i].source, samples[i].offset);
+  }
+}
+
+void ReservoirSampler::reserve_key(std::size_t key) {
+  if (key >= seen_.size()) {
+    seen_.resize(key + 1, 0);
+    slots_.resize((key + 1) * per_key_);
+  }
+}
+
+void ReservoirSampler::store(Slot& slot, std::string_view line, std::uint32_t source, std::uint64_t offset) {
+  line = truncate_line(line, kMaxLineBytes);
+  slot.source = source;
+  slot.offset = offset;
+  if (line.size() <= slot.size) {
+    // Reuse the replaced line's bytes.
+    arena_.replace(slot.begin, line.size(), line);
+    garbage_ += slot.size - line.size();
+    slot.size = static_cast<std::uint32_t>(line.size());
+    return;
+  }
+  garbage_ += slot.size;
+  slot.begin = arena_.size();
+  slot.size = static_cast<std::uint32_t>(line.size());
+  arena_.append(line);
+  if (arena_.size() >= kMinCompactBytes && garbage_ * 2 > arena_.size()) {
+    compact();
+  }
+}
+
+void ReservoirSampler::compact() {
+  std::string arena;
+  arena.reserve(arena_.size() - garbage_);
+  for (std::size_t key = 0; key < seen_.size(); ++key) {
+    const std::size_t used = static_cast<std::size_t>(std::min<std::uint64_t>(seen_[key], per_key_));
+    for (std::size_t i = 0; i < used; ++i) {
+      Slot& slot = slots_[key * per_key_ + i];
+      const std::size_t begin = arena.size();
+      arena.append(arena_, slot.begin, slot.size);
+      slot.begin = begin;
+    }
+  }
+  arena_ = std::move(arena);
+  garbage_ = 0;
+}
+
+std::uint64_t ReservoirSampler::next_random() {
+  // splitmix64.
+  std::uint64_t z = (rng_state_ += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+std::uint64_t ReservoirSampler::below(std::uint64_t bound) {
+  // 53 random mantissa bits scaled to the bound: no division, and the bias is negligible for
+  // the line counts a reservoir sees.
+  const double unit = static_cast<double>(next_random() >> 11) * 0x1.0p-53;
+  return std::min(static_cast<std::uint64_t>(unit * static_cast<double>(bound)), bound - 1);
+}
+
+}  // namespace log_sheriff
@@ -0,0 +1,304 @@
+#include "log_sheriff/result_cache.hpp"
+
+#include "log_sheriff/binary_io.hpp"
+#include "log_sheriff/hash.hpp"
+#include "log_sheriff/mapped_file.hpp"
+#include "log_sheriff/partial_io.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+
+namespace log_sheriff {
+namespace {
+
+constexpr std::string_view kMagic = "LSHCACHE";
+constexpr std::uint64_t kFormatVersion = 2;
+// Size of the leading and trailing blocks whose hashes guard against rewritten content.
+constexpr std::uint64_t kBlockBytes = 4096;
+
+struct FileState {
+  std::uint64_t device = 0;
+  std::uint64_t inode = 0;
+  std::uint64_t size = 0;
+  std::uint64_t modified_ns = 0;
+
+  bool operator==(const FileState&) const = default;
+};
+
+// Checkpoint of one file: `state.size` bytes were consumed, the trailing unterminated line among
+// them is held back in `pending`, and `partial` covers every line before it.
+struct Entry {
+  FileState state;
+  std::uint64_t head_hash = 0;
+  std::uint64_t tail_hash = 0;
+  std::string pending;
+  SummaryPartial partial;
+};
+
+// Device, inode and modification time; the size is taken from the mapping.
+FileState stat_file(const std::string& path) {
+  FileState state;
+  std::error_code error;
+  const auto modified = std::filesystem::last_write_time(path, error);
+  if (error) {
+    throw std::runtime_error("failed to open file: " + path);
+  }
+  state.modified_ns = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(modified.time_since_epoch()).count());
+#if !defined(_WIN32)
+  struct stat info {};
+  if (::stat(path.c_str(), &info) != 0) {
+    throw std::runtime_error("failed to open file: " + path);
+  }
+  state.device = static_cast<std::uint64_t>(info.st_dev);
+  state.inode = static_cast<std::uint64_t>(info.st_ino);
+#endif
+  return state;
+}
+
+std::uint64_t head_hash(std::span<const char> data, std::uint64_t size) {
+  const std::uint64_t length = std::min(size, kBlockBytes);
+  return hash_bytes(std::string_view(data.data(), static_cast<std::size_t>(length)));
+}
+
+std::uint64_t tail_hash(std::span<const char> data, std::uint64_t size) {
+  const std::uint64_t length = std::min(size, kBlockBytes);
+  return hash_bytes(std::string_view(data.data() + (size - length), static_cast<std::size_t>(length)));
+}
+
+// Whether the first `entry.state.size` bytes of `data` still hold what the entry was built from.
+bool blocks_unchanged(const Entry& entry, std::span<const char> data) {
+  return data.size() >= entry.state.size && head_hash(data, entry.state.size) == entry.head_hash &&
+         tail_hash(data, entry.state.size) == entry.tail_hash;
+}
+
+// Reads a little-endian u64 at `pos`, advancing it; false if the input is too short.
+bool get_u64(std::string_view bytes, std::size_t& pos, std::uint64_t& value) {
+  if (bytes.size() - pos < 8) {
+    return false;
+  }
+  value = load_u64(bytes.data() + pos);
+  pos += 8;
+  return true;
+}
+
+std::string entry_file_name(std::string_view key) {
+  constexpr char kHex[] = "0123456789abcdef";
+  const std::uint64_t hash = hash_bytes(key);
+  std::string out;
+  for (int shift = 60; shift >= 0; shift -= 4) {
+    out.push_back(kHex[(hash >> shift) & 0xF]);
+  }
+  return out + ".lsc";
+}
+
+// The entry at `path` if it exists, is intact and belongs to `key` (and not to a key whose
+// file name hash collides).
+std::optional<Entry> read_entry(const std::filesystem::path& path, std::string_view key) {
+  std::ifstream in(path, std::ios::in | std::ios::binary);
+  if (!in.is_open()) {
+    return std::nullopt;
+  }
+  const std::string bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+  if (in.bad() || bytes.compare(0, kMagic.size(), kMagic) != 0) {
+    return std::nullopt;
+  }
+
+  std::size_t pos = kMagic.size();
+  std::uint64_t version = 0;
+  std::uint64_t key_size = 0;
+  if (!get_u64(bytes, pos, version) || version != kFormatVersion || !get_u64(bytes, pos, key_size) ||
+      bytes.size() - pos < key_size || std::string_view(bytes).substr(pos, key_size) != key) {
+    return std::nullopt;
+  }
+  pos += key_size;
+
+  Entry entry;
+  std::uint64_t pending_size = 0;
+  if (!get_u64(bytes, pos, entry.state.device) || !get_u64(bytes, pos, entry.state.inode) ||
+      !get_u64(bytes, pos, entry.state.size) || !get_u64(bytes, pos, entry.state.modified_ns) ||
+      !get_u64(bytes, pos, entry.head_hash) || !get_u64(bytes, pos, entry.tail_hash) ||
+      !get_u64(bytes, pos, pending_size) || bytes.size() - pos < pending_size || pending_size > entry.state.size) {
+    return std::nullopt;
+  }
+  entry.pending = bytes.substr(pos, pending_size);
+  pos += pending_size;
+  try {
+    entry.partial = deserialize_partial(std::string_view(bytes).substr(pos));
+  } catch (const std::exception&) {
+    return std::nullopt;
+  }
+  return entry;
+}
+
+// Replaces any entry at `path` atomically, so readers never see half an entry.
+void write_entry(const std::filesystem::path& path, std::string_view key, const Entry& entry) {
+  std::string out{kMagic};
+  put_u64(out, kFormatVersion);
+  put_u64(out, key.size());
+  out.append(key);
+  put_u64(out, entry.state.device);
+  put_u64(out, entry.state.inode);
+  put_u64(out, entry.state.size);
+  put_u64(out, entry.state.modified_ns);
+  put_u64(out, entry.head_hash);
+  put_u64(out, entry.tail_hash);
+  put_u64(out, entry.pending.size());
+  out += entry.pending;
+  out += serialize_partial(entry.partial);
+
+  replace_file(path, out, "cache entry");
+}
+
+}  // namespace
+
+std::string options_fingerprint(const SummarizeOptions& options) {
+  std::string out;
+  const auto put = [&out](std::string_view text) {
+    out += std::to_string(text.size());
+    out.push_back(':');
+    out.append(text);
+  };
+  const auto put_optional = [&](const std::optional<std::string>& text) {
+    out.push_back(text.has_value() ? '1' : '0');
+    if (text.has_value()) {
+      put(*text);
+    }
+  };
+  const auto put_list = [&](const std::vector<std::string>& values) {
+    put(std::to_string(values.size()));
+    for (const std::string& value : values) {
+      put(value);
+    }
+  };
+
+  put(input_format_name(options.input_format));
+  put(multiline_mode_name(options.multiline));
+  put_optional(options.contains);
+  put(options.level.has_value() ? level_name(*options.level) : "");
+  put_optional(options.since);
+  put_optional(options.until);
+  put_optional(options.where);
+  put(std::to_string(options.bucket_seconds));
+  put(options.bucket_patterns ? "1" : "0");
+  put_optional(options.stat_field);
+  put_list(options.group_by);
+  // Per-group pattern counts are only collected when some are requested.
+  put(options.group_top_n > 0 ? "1" : "0");
+  put_list(options.distinct_fields);
+  put(std::to_string(options.hll_precision));
+  put(std::to_string(options.samples_per_pattern));
+  return out;
+}
+
+std::filesystem::path default_cache_directory() {
+#if defined(_WIN32)
+  if (const char* local = std::getenv("LOCALAPPDATA"); local != nullptr && *local != '\0') {
+    return std::filesystem::path(local) / "log-sheriff";
+  }
+#else
+  if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && *xdg != '\0') {
+    return std::filesystem::path(xdg) / "log-sheriff";
+  }
+  if (const char* home = std::getenv("HOME"); home != nullptr && *home != '\0') {
+    return std::filesystem::path(home) / ".cache" / "log-sheriff";
+  }
+#endif
+  throw std::runtime_error("cannot locate a cache directory; pass --cache-dir");
+}
+
+ResultCache::ResultCache(std::filesystem::path directory) : directory_(std::move(directory)) {
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+  if (error) {
+    throw std::runtime_error("failed to create cache directory: " + directory_.string());
+  }
+}
+
+SummaryPartial ResultCache::summarize_partial(const SummarizeOptions& options) {
+  return merge_file_partials(options, [this, &options](const std::string& path, const std::string& fingerprint) {
+    return file_partial(path, options, fingerprint);
+  });
+}
+
+SummaryPartial ResultCache::file_partial(const std::string& path, const SummarizeOptions& options,
+                                         const std::string& fingerprint) {
+  FileState state = stat_file(path);
+  const std::optional<MappedFile> file = MappedFile::map(path);
+  if (!file.has_value()) {
+    // Empty, not a regular file, or changing right now: read it through without a checkpoint.
+    ++stats_.misses;
+    IncrementalSummarizer summarizer(options);
+    summarizer.begin_source(path);
+    std::vector<char> buffer(kReadChunkBytes);
+    read_file_chunks(path, buffer, [&summarizer](std::span<const char> chunk) { summarizer.feed(chunk); });
+    summarizer.flush();
+    SummaryPartial partial = summarizer.take_partial();
+    partial.files_processed = 1;
+    return partial;
+  }
+  const std::span<const char> data = file->data();
+  state.size = data.size();
+
+  std::error_code error;
+  const std::string key = std::filesystem::absolute(path, error).string() + '\n' + fingerprint;
+  const std::filesystem::path entry_path = directory_ / entry_file_name(key);
+  std::optional<Entry> cached = read_entry(entry_path, key);
+  // Checkpoints name the file as spelled on the run that wrote them.
+  if (cached.has_value() && cached->partial.sources.size() == 1) {
+    cached->partial.sources.front() = path;
+  }
+
+  IncrementalSummarizer summarizer(options);
+  if (cached.has_value() && cached->state == state && blocks_unchanged(*cached, data)) {
+    ++stats_.hits;
+    summarizer.resume(path, state.size, std::move(cached->partial), cached->pending);
+  } else {
+    // Only an append keeps the inode and the bytes already read; rotation, truncation and
+    // rewrites start over.
+    const bool appended = cached.has_value() && cached->state.device == state.device &&
+                          cached->state.inode == state.inode && cached->state.size < state.size &&
+                          blocks_unchanged(*cached, data);
+    if (appended) {
+      ++stats_.appends;
+      summarizer.resume(path, cached->state.size, std::move(cached->partial), cached->pending);
+      summarizer.feed(data.subspan(static_cast<std::size_t>(cached->state.size)));
+    } else {
+      ++stats_.misses;
+      summarizer.begin_source(path);
+      summarizer.feed(data);
+    }
+
+    Entry updated;
+    updated.state = state;
+    updated.head_hash = head_hash(data, state.size);
+    updated.tail_hash = tail_hash(data, state.size);
+    updated.pending = summarizer.pending();
+    updated.partial = summarizer.take_partial();
+    // However many runs built it up, the checkpoint stands for one file.
+    updated.partial.files_processed = 1;
+    write_entry(entry_path, key, updated);
+    summarizer.resume(path, state.size, std::move(updated.partial), updated.pending);
+  }
+
+  // Like a plain summarize, count an unterminated last line; the checkpoint keeps holding it back.
+  summarizer.flush();
+  return summarizer.take_partial();
+}
+
+}  // namespace log_sheriff
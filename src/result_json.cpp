@@ -0,0 +1,224 @@
+#include "log_sheriff/result_json.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace log_sheriff {
+
+std::string format_timestamp_utc(std::time_t epoch_seconds) {
+  std::tm tm{};
+#if defined(_WIN32)
+  gmtime_s(&tm, &epoch_seconds);
+#else
+  gmtime_r(&epoch_seconds, &tm);
+#endif
+  char buffer[32];
+  const std::size_t size = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &tm);
+  return std::string(buffer, size);
+}
+
+std::string format_rate(double per_minute) {
+  char buffer[32];
+  const int size = std::snprintf(buffer, sizeof(buffer), "%.2f", per_minute);
+  return std::string(buffer, static_cast<std::size_t>(size));
+}
+
+std::string format_number(double value) {
+  char buffer[32];
+  const int size = std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+  return std::string(buffer, static_cast<std::size_t>(size));
+}
+
+namespace {
+
+void write_level_counts(JsonWriter& json, const std::array<std::uint64_t, 4>& counts) {
+  for (const auto level : {LogLevel::Error, LogLevel::Warn, LogLevel::Info, LogLevel::Debug}) {
+    json.key(level_name(level)).value(counts[static_cast<std::size_t>(level)]);
+  }
+}
+
+void write_stats(JsonWriter& json, const FieldStats& stats) {
+  json.begin_object();
+  json.key("count").value(stats.count);
+  json.key("min").number(format_number(stats.min));
+  json.key("p50").number(format_number(stats.p50));
+  json.key("p90").number(format_number(stats.p90));
+  json.key("p99").number(format_number(stats.p99));
+  json.key("max").number(format_number(stats.max));
+  json.end_object();
+}
+
+void write_strings(JsonWriter& json, const std::vector<std::string>& values) {
+  json.begin_array();
+  for (const std::string& value : values) {
+    json.value(value);
+  }
+  json.end_array();
+}
+
+// Pattern identity and count of a top line: its text unless the result names lines by ID, and
+// its dictionary ID and previous count when it has them.
+void write_pattern_fields(JsonWriter& json, const TopLine& entry, bool lines_as_ids) {
+  if (!lines_as_ids || !entry.pattern_id.has_value()) {
+    json.key("line").value(entry.normalized_line);
+  }
+  if (entry.pattern_id.has_value()) {
+    json.key("pattern_id").value(*entry.pattern_id);
+  }
+  json.key("count").value(entry.count);
+  if (entry.previous_count.has_value()) {
+    json.key("previous_count").value(*entry.previous_count);
+  }
+}
+
+// Members of a top line object, without the surrounding braces.
+void write_top_line_fields(JsonWriter& json, const TopLine& entry, bool lines_as_ids) {
+  write_pattern_fields(json, entry, lines_as_ids);
+  if (entry.first_seen.has_value()) {
+    json.key("first_seen").value(format_timestamp_utc(*entry.first_seen));
+    json.key("last_seen").value(format_timestamp_utc(*entry.last_seen));
+    json.key("per_minute").number(format_rate(entry.per_minute));
+  }
+  if (entry.stats.has_value()) {
+    json.key("stats");
+    write_stats(json, *entry.stats);
+  }
+  if (!entry.buckets.empty()) {
+    json.key("buckets").begin_array();
+    for (const std::uint64_t count : entry.buckets) {
+      json.value(count);
+    }
+    json.end_array();
+  }
+  if (!entry.samples.empty()) {
+    json.key("samples").begin_array();
+    for (const auto& sample : entry.samples) {
+      json.begin_object();
+      json.key("source").value(sample.source).key("offset").value(sample.offset);
+      json.key("line").value(sample.line);
+      json.end_object();
+    }
+    json.end_array();
+  }
+}
+
+void write_group_fields(JsonWriter& json, const GroupCount& group, bool lines_as_ids) {
+  json.key("values");
+  write_strings(json, group.values);
+  json.key("count").value(group.count);
+  if (!group.top_lines.empty()) {
+    json.key("top_lines").begin_array();
+    for (const auto& entry : group.top_lines) {
+      json.begin_object();
+      write_pattern_fields(json, entry, lines_as_ids);
+      json.end_object();
+    }
+    json.end_array();
+  }
+}
+
+void write_bucket_fields(JsonWriter& json, const TimeBucket& bucket) {
+  json.key("start").value(format_timestamp_utc(bucket.start)).key("matched").value(bucket.matched);
+  write_level_counts(json, bucket.by_level);
+}
+
+// Scalar summary members shared by the JSON document and the NDJSON summary record.
+void write_summary_fields(JsonWriter& json, const SummaryResult& result) {
+  json.key("files_processed").value(result.files_processed);
+  json.key("total_lines").value(result.total_lines);
+  json.key("matched_lines").value(result.matched_lines);
+  json.key("matched_by_level").begin_object();
+  write_level_counts(json, result.matched_by_level);
+  json.end_object();
+  json.key("distinct_patterns").value(result.distinct_patterns);
+  if (!result.distinct_values.empty()) {
+    json.key("distinct_values").begin_object();
+    for (const auto& distinct : result.distinct_values) {
+      json.key(distinct.field).value(distinct.estimate);
+    }
+    json.end_object();
+  }
+  if (!result.group_by.empty()) {
+    json.key("group_by");
+    write_strings(json, result.group_by);
+    json.key("ungrouped_lines").value(result.ungrouped_lines);
+  }
+  if (result.stat_field.has_value()) {
+    json.key("stat_field").value(*result.stat_field);
+    json.key("stats");
+    if (result.stats.has_value()) {
+      write_stats(json, *result.stats);
+    } else {
+      json.null();
+    }
+  }
+  if (result.bucket_seconds != 0) {
+    json.key("bucket_seconds").value(result.bucket_seconds);
+    json.key("unbucketed_lines").value(result.unbucketed_lines);
+  }
+}
+
+}  // namespace
+
+void write_result_json(JsonWriter& json, const SummaryResult& result) {
+  json.begin_object();
+  write_summary_fields(json, result);
+
+  json.key("top_lines").begin_array();
+  for (const auto& entry : result.top_lines) {
+    json.begin_object();
+    write_top_line_fields(json, entry, result.lines_as_ids);
+    json.end_object();
+  }
+  json.end_array();
+
+  if (!result.group_by.empty()) {
+    json.key("groups").begin_array();
+    for (const auto& group : result.groups) {
+      json.begin_object();
+      write_group_fields(json, group, result.lines_as_ids);
+      json.end_object();
+    }
+    json.end_array();
+  }
+
+  if (result.bucket_seconds != 0) {
+    json.key("buckets").begin_array();
+    for (const auto& bucket : result.buckets) {
+      json.begin_object();
+      write_bucket_fields(json, bucket);
+      json.end_object();
+    }
+    json.end_array();
+  }
+
+  json.end_object();
+}
+
+void write_result_ndjson(JsonWriter& json, const SummaryResult& result) {
+  json.begin_object().key("type").value("summary");
+  write_summary_fields(json, result);
+  json.end_object().end_record();
+
+  for (std::size_t i = 0; i < result.top_lines.size(); ++i) {
+    json.begin_object().key("type").value("top_line").key("rank").value(i + 1);
+    write_top_line_fields(json, result.top_lines[i], result.lines_as_ids);
+    json.end_object().end_record();
+  }
+  for (std::size_t i = 0; i < result.groups.size(); ++i) {
+    json.begin_object().key("type").value("group").key("rank").value(i + 1);
+    write_group_fields(json, result.groups[i], result.lines_as_ids);
+    json.end_object().end_record();
+  }
+  for (const auto& bucket : result.buckets) {
+    json.begin_object().key("type").value("bucket");
+    write_bucket_fields(json, bucket);
+    json.end_object().end_record();
+  }
+}
+
+}  // namespace log_sheriff
@@ -1,30 +1,65 @@
 #include "log_sheriff/summarizer.hpp"
 
+#include "log_sheriff/binary_io.hpp"
+#include "log_sheriff/fields.hpp"
+#include "log_sheriff/input_discovery.hpp"
+#include "log_sheriff/thread_pool.hpp"
+
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cstring>
 #include <ctime>
+#include <exception>
+#include <filesystem>
 #include <fstream>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <system_error>
+#include <thread>
 #include <utility>
 #include <vector>
 
 namespace log_sheriff {
 namespace {
 
-struct ParsedTimestamp {
-  std::time_t epoch_seconds = 0;
-  std::size_t consumed_chars = 0;
-};
+// Bytes read from each end of a file to find its first and last timestamps.
+constexpr std::size_t kPeekBytes = 64 * 1024;
 
-std::string to_lower_copy(std::string_view input) {
-  std::string out;
-  out.reserve(input.size());
-  for (unsigned char ch : input) {
-    out.push_back(static_cast<char>(std::tolower(ch)));
+// First timestamp among the complete lines of `block`.
+std::optional<std::time_t> first_timestamp(std::string_view block, Record& record) {
+  std::size_t start = 0;
+  for (std::size_t newline = block.find('\n'); newline != std::string_view::npos;
+       start = newline + 1, newline = block.find('\n', start)) {
+    if (const auto timestamp = record.parse(block.substr(start, newline - start)).timestamp()) {
+      return timestamp;
+    }
   }
-  return out;
+  return std::nullopt;
+}
+
+// Last timestamp in `block`, which ends the file. Its first line may be cut and is skipped.
+std::optional<std::time_t> last_timestamp(std::string_view block, Record& record) {
+  std::size_t end = block.size();
+  if (end > 0 && block[end - 1] == '\n') {
+    --end;
+  }
+  while (true) {
+    const std::size_t newline = end == 0 ? std::string_view::npos : block.rfind('\n', end - 1);
+    if (newline == std::string_view::npos) {
+      return std::nullopt;
+    }
+    if (const auto timestamp = record.parse(block.substr(newline + 1, end - newline - 1)).timestamp()) {
+      return timestamp;
+    }
+    end = newline;
+  }
+}
+
+void summarize_file(IncrementalSummarizer& summarizer, const std::string& path, std::vector<char>& buffer) {
+  summarizer.begin_source(path);
+  read_file_chunks(path, buffer, [&summarizer](std::span<const char> chunk) { summarizer.feed(chunk); });
+  summarizer.flush();
 }
 
 std::string trim_and_collapse_ws(std::string_view input) {
@@ -58,6 +93,8 @@ std::string trim_and_collapse_ws(std::string_view input) {
   return out;
 }
 
+}  // namespace
+
 std::string normalize_line(std::string_view input) {
   const std::string collapsed = trim_and_collapse_ws(input);
   if (collapsed.empty()) {
@@ -84,312 +121,654 @@ std::string normalize_line(std::string_view input) {
   return out;
 }
 
-bool line_has_level(std::string_view line, LogLevel wanted) {
-  const std::string lower = to_lower_copy(line);
-  switch (wanted) {
-    case LogLevel::Error:
-      return lower.find("error") != std::string::npos;
-    case LogLevel::Warn:
-      return lower.find("warn") != std::string::npos;
-    case LogLevel::Info:
-      return lower.find("info") != std::string::npos;
-    case LogLevel::Debug:
-      return lower.find("debug") != std::string::npos;
-  }
-  return false;
+namespace {
+
+std::optional<FieldStats> field_stats(const DDSketch& sketch) {
+  if (sketch.count() == 0) {
+    return std::nullopt;
+  }
+  return FieldStats{sketch.count(),        sketch.min(),          sketch.quantile(0.5),
+                    sketch.quantile(0.9), sketch.quantile(0.99), sketch.max()};
 }
 
-std::optional<LogLevel> detect_level(std::string_view line) {
-  const std::string lower = to_lower_copy(line);
-  if (lower.find("error") != std::string::npos) {
-    return LogLevel::Error;
+}  // namespace
+
+LineFilter::LineFilter(const SummarizeOptions& options)
+    : format_(options.input_format), contains_(options.contains), level_(options.level) {
+  if (options.where.has_value()) {
+    where_ = WhereFilter::compile(*options.where);
   }
-  if (lower.find("warn") != std::string::npos) {
-    return LogLevel::Warn;
+  if (options.since.has_value()) {
+    since_bound_ = parse_timestamp(*options.since);
+    if (!since_bound_.has_value()) {
+      throw std::invalid_argument(
+          "invalid --since timestamp; expected YYYY-MM-DDTHH:MM:SSZ or YYYY-MM-DD HH:MM:SS");
+    }
   }
-  if (lower.find("info") != std::string::npos) {
-    return LogLevel::Info;
+  if (options.until.has_value()) {
+    until_bound_ = parse_timestamp(*options.until);
+    if (!until_bound_.has_value()) {
+      throw std::invalid_argument(
+          "invalid --until timestamp; expected YYYY-MM-DDTHH:MM:SSZ or YYYY-MM-DD HH:MM:SS");
+    }
   }
-  if (lower.find("debug") != std::string::npos) {
-    return LogLevel::Debug;
+  if (since_bound_.has_value() && until_bound_.has_value() && *since_bound_ > *until_bound_) {
+    throw std::invalid_argument("--since must be less than or equal to --until");
   }
-  return std::nullopt;
 }
 
-bool parse_fixed_int(std::string_view input, std::size_t pos, std::size_t len, int& value) {
-  if (pos + len > input.size()) {
+bool LineFilter::matches(const Record& record, std::optional<std::time_t>& timestamp) const {
+  if (has_time_filter()) {
+    const auto parsed = record.timestamp();
+    if (!parsed.has_value()) {
+      return false;
+    }
+    if (since_bound_.has_value() && *parsed < *since_bound_) {
+      return false;
+    }
+    if (until_bound_.has_value() && *parsed > *until_bound_) {
+      return false;
+    }
+    timestamp = *parsed;
+  }
+
+  if (contains_.has_value() && record.line().find(*contains_) == std::string_view::npos) {
     return false;
   }
 
-  int out = 0;
-  for (std::size_t i = 0; i < len; ++i) {
-    const unsigned char ch = static_cast<unsigned char>(input[pos + i]);
-    if (std::isdigit(ch) == 0) {
-      return false;
-    }
-    out = out * 10 + (ch - static_cast<unsigned char>('0'));
+  if (where_.has_value() && !where_->matches(record)) {
+    return false;
   }
 
-  value = out;
-  return true;
+  return !level_.has_value() || record.has_level(*level_);
 }
 
-bool is_leap_year(int year) {
-  if (year % 400 == 0) {
-    return true;
-  }
-  if (year % 100 == 0) {
-    return false;
+IncrementalSummarizer::IncrementalSummarizer(const SummarizeOptions& options)
+    : filter_(options),
+      record_(options.input_format),
+      top_n_(options.top_n),
+      group_top_n_(options.group_top_n),
+      bucket_patterns_(options.bucket_seconds != 0 && options.bucket_patterns),
+      multiline_(options.multiline) {
+  partial_.bucket_seconds = options.bucket_seconds;
+  partial_.stat_field = options.stat_field;
+  partial_.group_by = options.group_by;
+  partial_.distinct_patterns = HyperLogLog(options.hll_precision);
+  partial_.distinct_fields = options.distinct_fields;
+  partial_.distinct_values.assign(options.distinct_fields.size(), HyperLogLog(options.hll_precision));
+  partial_.samples = ReservoirSampler(options.samples_per_pattern);
+}
+
+void IncrementalSummarizer::begin_source(std::string_view name, std::uint64_t offset) {
+  flush();
+  const auto known = std::find(partial_.sources.begin(), partial_.sources.end(), name);
+  source_ = static_cast<std::uint32_t>(known - partial_.sources.begin());
+  if (known == partial_.sources.end()) {
+    partial_.sources.emplace_back(name);
   }
-  return year % 4 == 0;
+  consumed_ = offset;
+}
+
+void IncrementalSummarizer::resume(std::string_view name, std::uint64_t offset, SummaryPartial partial,
+                                   std::string_view pending) {
+  if (pending.size() > offset) {
+    throw std::invalid_argument("checkpoint holds more pending bytes than it consumed");
+  }
+  partial_ = std::move(partial);
+  pending_.clear();
+  held_record_ = 0;
+  record_open_ = false;
+  begin_source(name, offset - pending.size());
+  // Held-back bytes never end a record, so feeding them again only restores what was open.
+  feed(pending);
 }
 
-int days_in_month(int year, int month) {
-  static constexpr int kDaysByMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-  if (month < 1 || month > 12) {
-    return 0;
+void IncrementalSummarizer::feed(std::span<const char> data) {
+  const char* const begin = data.data();
+  const char* cursor = begin;
+  const char* const end = data.data() + data.size();
+  const std::uint64_t base = consumed_;
+  consumed_ += data.size();
+
+  if (pending_.size() > held_record_) {
+    const auto* newline = static_cast<const char*>(std::memchr(cursor, '\n', data.size()));
+    if (newline == nullptr) {
+      pending_.append(cursor, end);
+      return;
+    }
+    pending_.append(cursor, newline);
+    take_pending_line();
+    cursor = newline + 1;
   }
-  if (month == 2 && is_leap_year(year)) {
-    return 29;
+
+  while (cursor < end) {
+    const auto* newline =
+        static_cast<const char*>(std::memchr(cursor, '\n', static_cast<std::size_t>(end - cursor)));
+    const std::uint64_t offset = base + static_cast<std::uint64_t>(cursor - begin);
+    if (newline == nullptr) {
+      break;
+    }
+    take_line(std::string_view(cursor, static_cast<std::size_t>(newline - cursor)), offset);
+    cursor = newline + 1;
   }
-  return kDaysByMonth[month - 1];
-}
 
-std::time_t to_time_utc(std::tm tm) {
-#if defined(_WIN32)
-  return _mkgmtime(&tm);
-#else
-  return timegm(&tm);
-#endif
+  // Hold back what the next feed() may still extend: an open record, then an unterminated line.
+  if (record_open_ && held_record_ == 0) {
+    pending_.assign(record_view_);
+    pending_.push_back('\n');
+    held_record_ = pending_.size();
+    pending_offset_ = record_offset_;
+  }
+  if (cursor < end) {
+    if (pending_.empty()) {
+      pending_offset_ = base + static_cast<std::uint64_t>(cursor - begin);
+    }
+    pending_.append(cursor, end);
+  }
 }
 
-std::string_view trim(std::string_view input) {
-  std::size_t start = 0;
-  while (start < input.size() && std::isspace(static_cast<unsigned char>(input[start])) != 0) {
-    ++start;
+void IncrementalSummarizer::flush() {
+  if (pending_.size() > held_record_) {
+    take_pending_line();
   }
+  close_record();
+}
 
-  std::size_t end = input.size();
-  while (end > start && std::isspace(static_cast<unsigned char>(input[end - 1])) != 0) {
-    --end;
+void IncrementalSummarizer::take_line(std::string_view line, std::uint64_t offset) {
+  if (multiline_ == MultilineMode::None) {
+    process_line(line, offset);
+    return;
+  }
+  if (record_open_ && continues_record(line)) {
+    if (held_record_ > 0) {
+      pending_.append(line);
+      pending_.push_back('\n');
+      held_record_ = pending_.size();
+    } else {
+      // Lines of one feed() are adjacent, so the record stays a single view.
+      record_view_ = std::string_view(record_view_.data(),
+                                      static_cast<std::size_t>(line.data() + line.size() - record_view_.data()));
+    }
+    return;
   }
+  close_record();
+  record_open_ = true;
+  record_view_ = line;
+  record_offset_ = offset;
+}
 
-  return input.substr(start, end - start);
+void IncrementalSummarizer::take_pending_line() {
+  const std::string_view line = std::string_view(pending_).substr(held_record_);
+  if (multiline_ == MultilineMode::None) {
+    process_line(line, pending_offset_);
+    pending_.clear();
+    return;
+  }
+  if (!record_open_ || !continues_record(line)) {
+    close_record();
+    record_open_ = true;
+    record_offset_ = pending_offset_;
+  }
+  pending_.push_back('\n');
+  held_record_ = pending_.size();
 }
 
-std::optional<ParsedTimestamp> parse_timestamp_prefix(std::string_view input) {
-  if (input.size() < 19) {
-    return std::nullopt;
+bool IncrementalSummarizer::continues_record(std::string_view line) {
+  if (multiline_ == MultilineMode::Indent) {
+    return !line.empty() && (line[0] == ' ' || line[0] == '\t' || line.starts_with("Caused by:"));
+  }
+  if (record_.format() == InputFormat::Text) {
+    return timestamp_prefix_length(line) == 0;
   }
+  return !record_.parse(line).timestamp().has_value();
+}
 
-  if (input[4] != '-' || input[7] != '-' || input[13] != ':' || input[16] != ':') {
-    return std::nullopt;
+void IncrementalSummarizer::close_record() {
+  if (!record_open_) {
+    return;
+  }
+  record_open_ = false;
+  if (held_record_ == 0) {
+    process_line(record_view_, record_offset_);
+    return;
   }
+  // Drop the trailing newline; whatever follows the record in pending_ stays held back.
+  process_line(std::string_view(pending_).substr(0, held_record_ - 1), pending_offset_);
+  pending_.erase(0, held_record_);
+  pending_offset_ += held_record_;
+  held_record_ = 0;
+}
 
-  const char separator = input[10];
-  if (separator != 'T' && separator != ' ') {
-    return std::nullopt;
+SummaryResult IncrementalSummarizer::snapshot() const { return finalize(partial_, top_n_, group_top_n_); }
+
+SummaryPartial IncrementalSummarizer::take_partial() {
+  SummaryPartial out = std::move(partial_);
+  // Handed-out partials may be read from several threads, which const sketches allow only once
+  // compacted.
+  out.distinct_patterns.compact();
+  for (HyperLogLog& sketch : out.distinct_values) {
+    sketch.compact();
+  }
+  partial_ = SummaryPartial{};
+  partial_.bucket_seconds = out.bucket_seconds;
+  partial_.stat_field = out.stat_field;
+  partial_.group_by = out.group_by;
+  partial_.distinct_patterns = HyperLogLog(out.distinct_patterns.precision());
+  partial_.distinct_fields = out.distinct_fields;
+  partial_.distinct_values.assign(out.distinct_fields.size(), HyperLogLog(out.distinct_patterns.precision()));
+  // Keep the source list so the current source index stays valid for later lines.
+  partial_.sources = out.sources;
+  partial_.samples = ReservoirSampler(out.samples.per_key());
+  return out;
+}
+
+void IncrementalSummarizer::process_line(std::string_view line, std::uint64_t offset) {
+  ++partial_.total_lines;
+
+  const Record& record = record_.parse(line);
+  std::optional<std::time_t> timestamp;
+  if (!filter_.matches(record, timestamp)) {
+    return;
   }
 
-  int year = 0;
-  int month = 0;
-  int day = 0;
-  int hour = 0;
-  int minute = 0;
-  int second = 0;
+  ++partial_.matched_lines;
 
-  if (!parse_fixed_int(input, 0, 4, year) || !parse_fixed_int(input, 5, 2, month) ||
-      !parse_fixed_int(input, 8, 2, day) || !parse_fixed_int(input, 11, 2, hour) ||
-      !parse_fixed_int(input, 14, 2, minute) || !parse_fixed_int(input, 17, 2, second)) {
-    return std::nullopt;
+  if (!filter_.has_time_filter()) {
+    timestamp = record.timestamp();
   }
 
-  if (month < 1 || month > 12) {
-    return std::nullopt;
+  const auto detected = record.level();
+  if (detected.has_value()) {
+    ++partial_.matched_by_level[static_cast<std::size_t>(*detected)];
   }
-  if (day < 1 || day > days_in_month(year, month)) {
-    return std::nullopt;
+
+  const std::size_t known_patterns = partial_.patterns.size();
+  const std::size_t pattern = partial_.patterns.add(normalize_line(record.message()));
+  // Re-adding a key never changes a sketch, so only a pattern's first sighting is hashed.
+  if (partial_.patterns.size() != known_patterns) {
+    partial_.distinct_patterns.add(partial_.patterns.pattern(pattern));
   }
-  if (hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59) {
-    return std::nullopt;
+  if (timestamp.has_value()) {
+    partial_.patterns.observe_time(pattern, *timestamp);
   }
 
-  const bool is_utc_z = separator == 'T';
-  std::size_t consumed_chars = 19;
-  if (is_utc_z) {
-    if (input.size() < 20 || input[19] != 'Z') {
-      return std::nullopt;
+  if (partial_.samples.enabled()) {
+    if (partial_.sources.empty()) {
+      // Data fed without begin_source(): one unnamed source.
+      partial_.sources.emplace_back();
     }
-    consumed_chars = 20;
+    partial_.samples.offer(pattern, line, source_, offset);
   }
 
-  if (input.size() > consumed_chars &&
-      std::isspace(static_cast<unsigned char>(input[consumed_chars])) == 0) {
-    return std::nullopt;
+  if (partial_.stat_field.has_value()) {
+    record_stat(record, pattern);
   }
 
-  std::tm tm{};
-  tm.tm_year = year - 1900;
-  tm.tm_mon = month - 1;
-  tm.tm_mday = day;
-  tm.tm_hour = hour;
-  tm.tm_min = minute;
-  tm.tm_sec = second;
-  tm.tm_isdst = -1;
-
-  std::time_t epoch_seconds = 0;
-  if (is_utc_z) {
-    epoch_seconds = to_time_utc(tm);
-  } else {
-    epoch_seconds = std::mktime(&tm);
+  if (!partial_.group_by.empty()) {
+    record_group(record, pattern);
   }
 
-  if (epoch_seconds == static_cast<std::time_t>(-1)) {
-    return std::nullopt;
+  if (!partial_.distinct_fields.empty()) {
+    record_distinct(record);
   }
 
-  return ParsedTimestamp{epoch_seconds, consumed_chars};
+  if (partial_.bucket_seconds != 0) {
+    record_bucket(timestamp, detected, pattern);
+  }
 }
 
-std::optional<std::time_t> parse_timestamp_exact(std::string_view input) {
-  const std::string_view trimmed = trim(input);
-  const auto parsed = parse_timestamp_prefix(trimmed);
-  if (!parsed.has_value()) {
-    return std::nullopt;
+void IncrementalSummarizer::record_stat(const Record& record, std::size_t pattern) {
+  const auto raw = record.field(*partial_.stat_field);
+  if (!raw.has_value()) {
+    return;
   }
-  if (parsed->consumed_chars != trimmed.size()) {
-    return std::nullopt;
+  const auto value = parse_number(*raw);
+  if (!value.has_value()) {
+    return;
+  }
+
+  partial_.stats.add(*value);
+  if (pattern >= partial_.pattern_stats.size()) {
+    partial_.pattern_stats.resize(pattern + 1);
   }
-  return parsed->epoch_seconds;
+  partial_.pattern_stats[pattern].add(*value);
 }
 
-}  // namespace
+void IncrementalSummarizer::record_group(const Record& record, std::size_t pattern) {
+  group_values_.clear();
+  for (const std::string& key : partial_.group_by) {
+    const auto value = record.field(key);
+    if (!value.has_value()) {
+      ++partial_.ungrouped_lines;
+      return;
+    }
+    group_values_.push_back(*value);
+  }
 
-std::optional<LogLevel> parse_level(std::string_view raw) {
-  const std::string lower = to_lower_copy(raw);
-  if (lower == "error") {
-    return LogLevel::Error;
+  const std::size_t group = partial_.groups.add(group_values_);
+  if (group_top_n_ > 0) {
+    partial_.groups.add_pattern(group, pattern);
   }
-  if (lower == "warn") {
-    return LogLevel::Warn;
+}
+
+void IncrementalSummarizer::record_distinct(const Record& record) {
+  for (std::size_t i = 0; i < partial_.distinct_fields.size(); ++i) {
+    if (const auto value = record.field(partial_.distinct_fields[i]); value.has_value()) {
+      partial_.distinct_values[i].add(*value);
+    }
   }
-  if (lower == "info") {
-    return LogLevel::Info;
+}
+
+void IncrementalSummarizer::record_bucket(std::optional<std::time_t> timestamp, std::optional<LogLevel> detected,
+                                          std::size_t pattern) {
+  if (!timestamp.has_value()) {
+    ++partial_.unbucketed_lines;
+    return;
   }
-  if (lower == "debug") {
-    return LogLevel::Debug;
+  const std::int64_t index = bucket_index(*timestamp, partial_.bucket_seconds);
+  LevelBucket& bucket = partial_.level_buckets.at(index);
+  ++bucket.matched;
+  if (detected.has_value()) {
+    ++bucket.by_level[static_cast<std::size_t>(*detected)];
   }
-  return std::nullopt;
-}
 
-std::string_view level_name(LogLevel level) {
-  switch (level) {
-    case LogLevel::Error:
-      return "error";
-    case LogLevel::Warn:
-      return "warn";
-    case LogLevel::Info:
-      return "info";
-    case LogLevel::Debug:
-      return "debug";
-  }
-  return "unknown";
+  if (bucket_patterns_) {
+    if (pattern >= partial_.pattern_buckets.size()) {
+      partial_.pattern_buckets.resize(pattern + 1);
+    }
+    ++partial_.pattern_buckets[pattern].at(index);
+  }
 }
 
-SummaryResult Summarizer::summarize(const SummarizeOptions& options) const {
+SummaryPartial Summarizer::summarize_partial(const SummarizeOptions& options) const {
   if (options.files.empty()) {
     throw std::invalid_argument("no input files supplied");
   }
 
-  const bool has_time_filter = options.since.has_value() || options.until.has_value();
-  std::optional<std::time_t> since_bound;
-  std::optional<std::time_t> until_bound;
-  if (options.since.has_value()) {
-    since_bound = parse_timestamp_exact(*options.since);
-    if (!since_bound.has_value()) {
-      throw std::invalid_argument(
-          "invalid --since timestamp; expected YYYY-MM-DDTHH:MM:SSZ or YYYY-MM-DD HH:MM:SS");
+  std::vector<const std::string*> inputs;
+  inputs.reserve(options.files.size());
+  const LineFilter filter(options);
+  for (const std::string& path : options.files) {
+    if (!filter.has_time_filter() || !file_outside_time_range(path, filter)) {
+      inputs.push_back(&path);
     }
   }
-  if (options.until.has_value()) {
-    until_bound = parse_timestamp_exact(*options.until);
-    if (!until_bound.has_value()) {
-      throw std::invalid_argument(
-          "invalid --until timestamp; expected YYYY-MM-DDTHH:MM:SSZ or YYYY-MM-DD HH:MM:SS");
+
+  const std::size_t threads =
+      options.threads == 0 ? std::max(1U, std::thread::hardware_concurrency()) : options.threads;
+  SummaryPartial result;
+  if (threads == 1 || inputs.size() <= 1) {
+    IncrementalSummarizer summarizer(options);
+    std::vector<char> buffer(kReadChunkBytes);
+    for (const std::string* path : inputs) {
+      summarize_file(summarizer, *path, buffer);
+    }
+    result = summarizer.take_partial();
+  } else {
+    // Largest files first, so a big file picked up last does not leave the other workers idle.
+    std::vector<std::pair<std::uintmax_t, const std::string*>> order;
+    order.reserve(inputs.size());
+    for (const std::string* path : inputs) {
+      std::error_code error;
+      const std::uintmax_t size = std::filesystem::file_size(*path, error);
+      order.emplace_back(error ? 0 : size, path);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+    // One summarizer per worker, each taking the next file in order; their partials are merged.
+    const std::size_t workers = std::min(threads, inputs.size());
+    std::vector<SummaryPartial> partials(workers);
+    std::vector<std::exception_ptr> errors(workers);
+    std::atomic<std::size_t> next{0};
+    {
+      ThreadPool pool(workers);
+      for (std::size_t worker = 0; worker < workers; ++worker) {
+        pool.submit([&, worker] {
+          try {
+            IncrementalSummarizer summarizer(options);
+            std::vector<char> buffer(kReadChunkBytes);
+            for (std::size_t i = next++; i < order.size(); i = next++) {
+              summarize_file(summarizer, *order[i].second, buffer);
+            }
+            partials[worker] = summarizer.take_partial();
+          } catch (...) {
+            errors[worker] = std::current_exception();
+            // Stop the other workers early.
+            next = order.size();
+          }
+        });
+      }
+    }
+    for (const std::exception_ptr& error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+    for (const SummaryPartial& partial : partials) {
+      merge(result, partial);
     }
   }
-  if (since_bound.has_value() && until_bound.has_value() && *since_bound > *until_bound) {
-    throw std::invalid_argument("--since must be less than or equal to --until");
+
+  result.files_processed = inputs.size();
+  return result;
+}
+
+bool file_outside_time_range(const std::string& path, const LineFilter& filter) {
+  const std::optional<std::time_t> since = filter.since_bound();
+  const std::optional<std::time_t> until = filter.until_bound();
+  if (!since.has_value() && !until.has_value()) {
+    return false;
   }
 
-  std::unordered_map<std::string, std::uint64_t> frequency;
+  // A file holds no line written after its last modification. One that cannot be stat'ed is
+  // left for the read to report.
+  const std::optional<std::time_t> modified = file_modified_time(path);
+  if (!modified.has_value()) {
+    return false;
+  }
+  if (since.has_value() && *modified < *since) {
+    return true;
+  }
 
-  SummaryResult result;
-  for (const std::string& path : options.files) {
-    std::ifstream in(path, std::ios::in);
-    if (!in.is_open()) {
-      throw std::runtime_error("failed to open file: " + path);
-    }
-
-    ++result.files_processed;
-
-    std::string line;
-    while (std::getline(in, line)) {
-      ++result.total_lines;
-
-      if (has_time_filter) {
-        const auto parsed = parse_timestamp_prefix(line);
-        if (!parsed.has_value()) {
-          continue;
-        }
-        if (since_bound.has_value() && parsed->epoch_seconds < *since_bound) {
-          continue;
-        }
-        if (until_bound.has_value() && parsed->epoch_seconds > *until_bound) {
-          continue;
-        }
-      }
+  std::ifstream in(path, std::ios::in | std::ios::binary);
+  if (!in.is_open()) {
+    return false;
+  }
+  in.seekg(0, std::ios::end);
+  const auto size = static_cast<std::uint64_t>(std::max<std::streamoff>(in.tellg(), 0));
+  // Files this small are cheaper to read than to judge.
+  if (size <= 2 * kPeekBytes) {
+    return false;
+  }
 
-      if (options.contains.has_value() && line.find(*options.contains) == std::string::npos) {
-        continue;
-      }
+  std::string block(kPeekBytes, '\0');
+  Record record(filter.format());
+  in.seekg(0);
+  in.read(block.data(), static_cast<std::streamsize>(block.size()));
+  const auto first = first_timestamp(std::string_view(block.data(), static_cast<std::size_t>(in.gcount())), record);
+  if (!first.has_value()) {
+    return false;
+  }
+  if (until.has_value() && *first > *until) {
+    return true;
+  }
 
-      if (options.level.has_value() && !line_has_level(line, *options.level)) {
-        continue;
-      }
+  in.seekg(static_cast<std::streamoff>(size - kPeekBytes));
+  in.read(block.data(), static_cast<std::streamsize>(block.size()));
+  const auto last =
+      last_timestamp(std::string_view(block.data(), static_cast<std::size_t>(in.gcount())), record);
+  return last.has_value() && since.has_value() && *last < *since;
+}
 
-      ++result.matched_lines;
+SummaryResult Summarizer::summarize(const SummarizeOptions& options) const {
+  return finalize(summarize_partial(options), options.top_n, options.group_top_n);
+}
 
-      if (const auto detected = detect_level(line); detected.has_value()) {
-        ++result.matched_by_level[static_cast<std::size_t>(*detected)];
-      }
+void merge(SummaryPartial& into, const SummaryPartial& other) {
+  // A default-constructed partial adopts the configuration of whatever is merged into it.
+  if (into.files_processed == 0 && into.total_lines == 0) {
+    into.bucket_seconds = other.bucket_seconds;
+    into.stat_field = other.stat_field;
+    into.group_by = other.group_by;
+    into.distinct_patterns = HyperLogLog(other.distinct_patterns.precision());
+    into.distinct_fields = other.distinct_fields;
+    into.distinct_values.assign(other.distinct_fields.size(), HyperLogLog(other.distinct_patterns.precision()));
+    into.samples = ReservoirSampler(other.samples.per_key());
+  } else if (other.files_processed == 0 && other.total_lines == 0) {
+    // Nothing to add, such as a partial whose inputs were all pruned by time. Its sketches need
+    // not match this one's, so none of it is merged.
+    return;
+  } else {
+    if (into.bucket_seconds != other.bucket_seconds) {
+      throw std::invalid_argument("cannot merge summaries with different bucket widths");
+    }
+    if (into.stat_field != other.stat_field) {
+      throw std::invalid_argument("cannot merge summaries with different stat fields");
+    }
+    if (into.group_by != other.group_by) {
+      throw std::invalid_argument("cannot merge summaries with different group-by fields");
+    }
+    if (into.distinct_fields != other.distinct_fields) {
+      throw std::invalid_argument("cannot merge summaries with different distinct fields");
+    }
+    if (into.distinct_patterns.precision() != other.distinct_patterns.precision()) {
+      throw std::invalid_argument("cannot merge summaries with different sketch precisions");
+    }
+    if (into.samples.per_key() != other.samples.per_key()) {
+      throw std::invalid_argument("cannot merge summaries with different sample sizes");
+    }
+  }
+
+  into.files_processed += other.files_processed;
+  into.total_lines += other.total_lines;
+  into.matched_lines += other.matched_lines;
+  for (std::size_t i = 0; i < into.matched_by_level.size(); ++i) {
+    into.matched_by_level[i] += other.matched_by_level[i];
+  }
+
+  into.unbucketed_lines += other.unbucketed_lines;
+  into.level_buckets.merge(other.level_buckets);
+
+  const std::vector<std::size_t> mapping = into.patterns.merge(other.patterns);
+  for (std::size_t i = 0; i < other.pattern_buckets.size(); ++i) {
+    const std::size_t index = mapping[i];
+    if (into.pattern_buckets.size() <= index) {
+      into.pattern_buckets.resize(index + 1);
+    }
+    into.pattern_buckets[index].merge(other.pattern_buckets[i]);
+  }
 
-      ++frequency[normalize_line(line)];
+  into.stats.merge(other.stats);
+  for (std::size_t i = 0; i < other.pattern_stats.size(); ++i) {
+    const std::size_t index = mapping[i];
+    if (into.pattern_stats.size() <= index) {
+      into.pattern_stats.resize(index + 1);
     }
+    into.pattern_stats[index].merge(other.pattern_stats[i]);
   }
 
-  std::vector<TopLine> entries;
-  entries.reserve(frequency.size());
-  for (auto& [line, count] : frequency) {
-    entries.push_back(TopLine{line, count});
+  into.ungrouped_lines += other.ungrouped_lines;
+  into.groups.merge(other.groups, mapping);
+
+  into.distinct_patterns.merge(other.distinct_patterns);
+  for (std::size_t i = 0; i < other.distinct_values.size(); ++i) {
+    into.distinct_values[i].merge(other.distinct_values[i]);
   }
 
-  const auto cmp = [](const TopLine& lhs, const TopLine& rhs) {
-    if (lhs.count != rhs.count) {
-      return lhs.count > rhs.count;
+  std::vector<std::uint32_t> source_mapping;
+  source_mapping.reserve(other.sources.size());
+  for (const std::string& source : other.sources) {
+    const auto known = std::find(into.sources.begin(), into.sources.end(), source);
+    source_mapping.push_back(static_cast<std::uint32_t>(known - into.sources.begin()));
+    if (known == into.sources.end()) {
+      into.sources.push_back(source);
     }
-    return lhs.normalized_line < rhs.normalized_line;
-  };
+  }
+  into.samples.merge(other.samples, mapping, source_mapping);
+}
 
-  const std::size_t limit = std::min(options.top_n, entries.size());
-  if (limit == 0) {
-    result.top_lines.clear();
-    return result;
+SummaryResult finalize(const SummaryPartial& partial, std::size_t top_n, std::size_t group_top_n) {
+  SummaryResult result;
+  result.files_processed = partial.files_processed;
+  result.total_lines = partial.total_lines;
+  result.matched_lines = partial.matched_lines;
+  result.matched_by_level = partial.matched_by_level;
+  result.bucket_seconds = partial.bucket_seconds;
+  result.unbucketed_lines = partial.unbucketed_lines;
+  result.stat_field = partial.stat_field;
+  if (partial.stat_field.has_value()) {
+    result.stats = field_stats(partial.stats);
+  }
+
+  // Matched lines in buckets outside the shown window count like unparseable timestamps.
+  const BucketSeries<LevelBucket>& series = partial.level_buckets;
+  const auto [first_bucket, last_bucket] =
+      series.densest_window([](const LevelBucket& bucket) { return bucket.matched; });
+  for (const auto& [index, bucket] : series.buckets()) {
+    if (index < first_bucket || index > last_bucket) {
+      result.unbucketed_lines += bucket.matched;
+    }
+  }
+  for (std::int64_t index = first_bucket; index <= last_bucket; ++index) {
+    const LevelBucket bucket = series.get(index);
+    result.buckets.push_back(TimeBucket{static_cast<std::time_t>(index * partial.bucket_seconds), bucket.matched,
+                                        bucket.by_level});
+  }
+
+  for (const std::size_t index : partial.patterns.top(top_n)) {
+    TopLine line;
+    line.normalized_line = partial.patterns.pattern(index);
+    line.count = partial.patterns.count(index);
+    line.first_seen = partial.patterns.first_seen(index);
+    line.last_seen = partial.patterns.last_seen(index);
+    if (line.first_seen.has_value()) {
+      const double minutes = static_cast<double>(*line.last_seen - *line.first_seen) / 60.0;
+      line.per_minute = static_cast<double>(line.count) / std::max(minutes, 1.0);
+    }
+    if (index < partial.pattern_buckets.size() && !series.empty()) {
+      const BucketSeries<std::uint64_t>& counts = partial.pattern_buckets[index];
+      line.buckets.reserve(result.buckets.size());
+      for (std::int64_t bucket = first_bucket; bucket <= last_bucket; ++bucket) {
+        line.buckets.push_back(counts.get(bucket));
+      }
+    }
+    if (index < partial.pattern_stats.size()) {
+      line.stats = field_stats(partial.pattern_stats[index]);
+    }
+    for (const ReservoirSampler::Sample& sample : partial.samples.samples(index)) {
+      line.samples.push_back(LineSample{std::string{sample.line}, partial.sources[sample.source], sample.offset});
+    }
+    result.top_lines.push_back(std::move(line));
   }
 
-  std::partial_sort(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(limit), entries.end(), cmp);
-  entries.resize(limit);
-  result.top_lines = std::move(entries);
+  result.distinct_patterns = partial.distinct_patterns.estimate();
+  for (std::size_t i = 0; i < partial.distinct_fields.size(); ++i) {
+    result.distinct_values.push_back(DistinctCount{partial.distinct_fields[i], partial.distinct_values[i].estimate()});
+  }
+
+  result.group_by = partial.group_by;
+  result.ungrouped_lines = partial.ungrouped_lines;
+  for (const std::size_t group : partial.groups.top(top_n)) {
+    GroupCount entry{partial.groups.values(group), partial.groups.count(group), {}};
+    for (const auto& [pattern, count] : partial.groups.patterns(group)) {
+      TopLine line;
+      line.normalized_line = partial.patterns.pattern(pattern);
+      line.count = count;
+      entry.top_lines.push_back(std::move(line));
+    }
+    const auto cmp = [](const TopLine& lhs, const TopLine& rhs) {
+      if (lhs.count != rhs.count) {
+        return lhs.count > rhs.count;
+      }
+      return lhs.normalized_line < rhs.normalized_line;
+    };
+    const std::size_t limit = std::min(group_top_n, entry.top_lines.size());
+    std::partial_sort(entry.top_lines.begin(), entry.top_lines.begin() + static_cast<std::ptrdiff_t>(limit),
+                      entry.top_lines.end(), cmp);
+    entry.top_lines.resize(limit);
+    result.groups.push_back(std::move(entry));
+  }
 
   return result;
 }
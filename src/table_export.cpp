@@ -0,0 +1,559 @@
+#include "log_sheriff/table_export.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace log_sheriff {
+namespace {
+
+constexpr std::size_t kAlign = 8;
+
+std::size_t align_up(std::size_t value, std::size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+void pad_to(std::string& out, std::size_t alignment) {
+  out.append(align_up(out.size(), alignment) - out.size(), '\0');
+}
+
+// Little-endian store of the low `size` bytes of `value` at `pos`.
+void store_le(std::string& out, std::size_t pos, std::uint64_t value, std::size_t size) {
+  for (std::size_t i = 0; i < size; ++i) {
+    out[pos + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+void put_le(std::string& out, std::uint64_t value, std::size_t size) {
+  out.append(size, '\0');
+  store_le(out, out.size() - size, value, size);
+}
+
+// Minimal FlatBuffers encoder for the handful of Arrow metadata tables written here. Objects are
+// laid out front to back: a table is written first and the strings, vectors and tables it refers
+// to follow it, since FlatBuffers offsets to child objects must point forward.
+class FlatBuilder {
+ public:
+  using Child = std::function<std::size_t()>;
+
+  struct Field {
+    std::uint16_t id = 0;
+    // Inline scalar width in bytes; offsets to child objects are 4 bytes wide.
+    std::uint8_t size = 0;
+    std::uint64_t scalar = 0;
+    Child child;
+  };
+
+  static Field scalar(std::uint16_t id, std::uint8_t size, std::uint64_t value) {
+    return Field{id, size, value, {}};
+  }
+  static Field offset(std::uint16_t id, Child child) { return Field{id, 4, 0, std::move(child)}; }
+
+  std::size_t table(const std::vector<Field>& fields) {
+    std::uint16_t slots = 0;
+    for (const Field& field : fields) {
+      slots = std::max<std::uint16_t>(slots, static_cast<std::uint16_t>(field.id + 1));
+    }
+
+    // Widest fields first after the 4-byte vtable reference keeps padding minimal.
+    std::vector<std::size_t> order(fields.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&fields](std::size_t lhs, std::size_t rhs) { return fields[lhs].size > fields[rhs].size; });
+    std::vector<std::size_t> field_offset(fields.size());
+    std::size_t inline_size = 4;
+    for (const std::size_t index : order) {
+      inline_size = align_up(inline_size, fields[index].size);
+      field_offset[index] = inline_size;
+      inline_size += fields[index].size;
+    }
+
+    // The vtable sits directly before its table, which starts 8-aligned.
+    const std::size_t vtable_size = 4 + 2 * static_cast<std::size_t>(slots);
+    while ((buffer_.size() + vtable_size) % kAlign != 0) {
+      buffer_.push_back('\0');
+    }
+    const std::size_t vtable = buffer_.size();
+    put_le(buffer_, vtable_size, 2);
+    put_le(buffer_, inline_size, 2);
+    for (std::uint16_t slot = 0; slot < slots; ++slot) {
+      std::size_t at = 0;
+      for (std::size_t i = 0; i < fields.size(); ++i) {
+        at = fields[i].id == slot ? field_offset[i] : at;
+      }
+      put_le(buffer_, at, 2);
+    }
+
+    const std::size_t table = buffer_.size();
+    buffer_.append(inline_size, '\0');
+    store_le(buffer_, table, table - vtable, 4);
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+      if (!fields[i].child) {
+        store_le(buffer_, table + field_offset[i], fields[i].scalar, fields[i].size);
+      }
+    }
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+      if (fields[i].child) {
+        link(table + field_offset[i], fields[i].child());
+      }
+    }
+    return table;
+  }
+
+  std::size_t string(std::string_view text) {
+    pad_to(buffer_, 4);
+    const std::size_t pos = buffer_.size();
+    put_le(buffer_, text.size(), 4);
+    buffer_.append(text);
+    buffer_.push_back('\0');
+    return pos;
+  }
+
+  std::size_t table_vector(const std::vector<Child>& elements) {
+    pad_to(buffer_, 4);
+    const std::size_t pos = buffer_.size();
+    put_le(buffer_, elements.size(), 4);
+    buffer_.append(4 * elements.size(), '\0');
+    for (std::size_t i = 0; i < elements.size(); ++i) {
+      link(pos + 4 + 4 * i, elements[i]());
+    }
+    return pos;
+  }
+
+  // Vector of structs made of `stride` int64 members each.
+  std::size_t long_struct_vector(const std::vector<std::int64_t>& members, std::size_t stride) {
+    // Elements must be 8-aligned, and they follow the 4-byte length.
+    while (buffer_.size() % kAlign != 4) {
+      buffer_.push_back('\0');
+    }
+    const std::size_t pos = buffer_.size();
+    put_le(buffer_, members.size() / stride, 4);
+    for (const std::int64_t member : members) {
+      put_le(buffer_, static_cast<std::uint64_t>(member), 8);
+    }
+    return pos;
+  }
+
+  std::string finish(const Child& root) {
+    buffer_.assign(4, '\0');
+    link(0, root());
+    pad_to(buffer_, kAlign);
+    return std::move(buffer_);
+  }
+
+ private:
+  void link(std::size_t at, std::size_t target) { store_le(buffer_, at, target - at, 4); }
+
+  std::string buffer_;
+};
+
+// Arrow format enums (Schema.fbs / Message.fbs).
+constexpr std::uint64_t kMetadataV5 = 4;
+constexpr std::uint64_t kHeaderSchema = 1;
+constexpr std::uint64_t kHeaderRecordBatch = 3;
+constexpr std::uint64_t kTypeInt = 2;
+constexpr std::uint64_t kTypeFloatingPoint = 3;
+constexpr std::uint64_t kTypeUtf8 = 5;
+constexpr std::uint64_t kTypeTimestamp = 10;
+constexpr std::uint64_t kPrecisionDouble = 2;
+constexpr std::uint64_t kTimeUnitSecond = 0;
+
+std::size_t write_field(FlatBuilder& fb, const Column& column) {
+  std::uint64_t type_id = kTypeUtf8;
+  FlatBuilder::Child type = [&fb] { return fb.table({}); };
+  switch (column.type()) {
+    case ColumnType::UInt64:
+      type_id = kTypeInt;
+      type = [&fb] { return fb.table({FlatBuilder::scalar(0, 4, 64), FlatBuilder::scalar(1, 1, 0)}); };
+      break;
+    case ColumnType::Float64:
+      type_id = kTypeFloatingPoint;
+      type = [&fb] { return fb.table({FlatBuilder::scalar(0, 2, kPrecisionDouble)}); };
+      break;
+    case ColumnType::Timestamp:
+      type_id = kTypeTimestamp;
+      type = [&fb] {
+        return fb.table({FlatBuilder::scalar(0, 2, kTimeUnitSecond),
+                         FlatBuilder::offset(1, [&fb] { return fb.string("UTC"); })});
+      };
+      break;
+    case ColumnType::Utf8:
+      break;
+  }
+
+  return fb.table({
+      FlatBuilder::offset(0, [&fb, &column] { return fb.string(column.name()); }),
+      FlatBuilder::scalar(1, 1, 1),
+      FlatBuilder::scalar(2, 1, type_id),
+      FlatBuilder::offset(3, type),
+      FlatBuilder::offset(5, [&fb] { return fb.table_vector({}); }),
+  });
+}
+
+std::string schema_message(const ColumnTable& table) {
+  FlatBuilder fb;
+  return fb.finish([&fb, &table] {
+    const auto schema = [&fb, &table] {
+      std::vector<FlatBuilder::Child> fields;
+      for (const Column& column : table.columns) {
+        fields.push_back([&fb, &column] { return write_field(fb, column); });
+      }
+      const std::uint64_t endianness = std::endian::native == std::endian::little ? 0 : 1;
+      return fb.table({FlatBuilder::scalar(0, 2, endianness),
+                       FlatBuilder::offset(1, [&fb, fields] { return fb.table_vector(fields); })});
+    };
+    return fb.table({FlatBuilder::scalar(0, 2, kMetadataV5), FlatBuilder::scalar(1, 1, kHeaderSchema),
+                     FlatBuilder::offset(2, schema), FlatBuilder::scalar(3, 8, 0)});
+  });
+}
+
+// Appends `bytes` to the body 8-aligned and records its (offset, length) buffer entry.
+void add_buffer(std::string& body, std::vector<std::int64_t>& buffers, const void* bytes, std::size_t size) {
+  buffers.push_back(static_cast<std::int64_t>(body.size()));
+  buffers.push_back(static_cast<std::int64_t>(size));
+  body.append(static_cast<const char*>(bytes), size);
+  pad_to(body, kAlign);
+}
+
+void append_message(std::string& out, const std::string& metadata, const std::string& body) {
+  put_le(out, 0xFFFFFFFFU, 4);
+  put_le(out, metadata.size(), 4);
+  out += metadata;
+  out += body;
+}
+
+void append_iso_time(std::string& out, std::time_t epoch_seconds) {
+  std::tm tm{};
+#if defined(_WIN32)
+  gmtime_s(&tm, &epoch_seconds);
+#else
+  gmtime_r(&epoch_seconds, &tm);
+#endif
+  char buffer[32];
+  out.append(buffer, std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &tm));
+}
+
+void append_csv_text(std::string& out, std::string_view text) {
+  if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+    out += text;
+    return;
+  }
+  out.push_back('"');
+  for (const char ch : text) {
+    if (ch == '"') {
+      out.push_back('"');
+    }
+    out.push_back(ch);
+  }
+  out.push_back('"');
+}
+
+void append_csv_cell(std::string& out, const Column& column, std::size_t row) {
+  if (!column.is_valid(row)) {
+    return;
+  }
+  char digits[32];
+  std::to_chars_result result{};
+  switch (column.type()) {
+    case ColumnType::UInt64:
+      result = std::to_chars(digits, digits + sizeof(digits), column.words()[row]);
+      out.append(digits, result.ptr);
+      break;
+    case ColumnType::Float64:
+      result = std::to_chars(digits, digits + sizeof(digits), column.double_at(row));
+      out.append(digits, result.ptr);
+      break;
+    case ColumnType::Timestamp:
+      append_iso_time(out, static_cast<std::time_t>(static_cast<std::int64_t>(column.words()[row])));
+      break;
+    case ColumnType::Utf8:
+      append_csv_text(out, column.text_at(row));
+      break;
+  }
+}
+
+void append_optional_time(Column& column, const std::optional<std::time_t>& value) {
+  if (value.has_value()) {
+    column.append_time(*value);
+  } else {
+    column.append_null();
+  }
+}
+
+void append_optional_uint(Column& column, std::optional<std::uint64_t> value) {
+  if (value.has_value()) {
+    column.append_uint(*value);
+  } else {
+    column.append_null();
+  }
+}
+
+ColumnTable top_table(const SummaryResult& result) {
+  ColumnTable table;
+  table.columns.emplace_back("rank", ColumnType::UInt64);
+  table.columns.emplace_back("count", ColumnType::UInt64);
+  table.columns.emplace_back("line", ColumnType::Utf8);
+  table.columns.emplace_back("first_seen", ColumnType::Timestamp);
+  table.columns.emplace_back("last_seen", ColumnType::Timestamp);
+  table.columns.emplace_back("per_minute", ColumnType::Float64);
+  if (result.stat_field.has_value()) {
+    for (const char* suffix : {"_count", "_min", "_p50", "_p90", "_p99", "_max"}) {
+      table.columns.emplace_back(*result.stat_field + suffix,
+                                 suffix == std::string_view("_count") ? ColumnType::UInt64 : ColumnType::Float64);
+    }
+  }
+  // Dictionary columns go last, so the stat columns keep their positions.
+  const std::size_t id_column = table.columns.size();
+  const bool has_ids = std::any_of(result.top_lines.begin(), result.top_lines.end(),
+                                   [](const TopLine& entry) { return entry.pattern_id.has_value(); });
+  if (has_ids) {
+    table.columns.emplace_back("pattern_id", ColumnType::UInt64);
+    table.columns.emplace_back("previous_count", ColumnType::UInt64);
+  }
+
+  for (std::size_t i = 0; i < result.top_lines.size(); ++i) {
+    const TopLine& entry = result.top_lines[i];
+    table.columns[0].append_uint(i + 1);
+    table.columns[1].append_uint(entry.count);
+    if (result.lines_as_ids && entry.pattern_id.has_value()) {
+      table.columns[2].append_null();
+    } else {
+      table.columns[2].append_text(entry.normalized_line);
+    }
+    if (has_ids) {
+      append_optional_uint(table.columns[id_column], entry.pattern_id);
+      append_optional_uint(table.columns[id_column + 1], entry.previous_count);
+    }
+    append_optional_time(table.columns[3], entry.first_seen);
+    append_optional_time(table.columns[4], entry.last_seen);
+    if (entry.first_seen.has_value()) {
+      table.columns[5].append_double(entry.per_minute);
+    } else {
+      table.columns[5].append_null();
+    }
+    if (!result.stat_field.has_value()) {
+      continue;
+    }
+    if (!entry.stats.has_value()) {
+      for (std::size_t column = 6; column < 12; ++column) {
+        table.columns[column].append_null();
+      }
+      continue;
+    }
+    table.columns[6].append_uint(entry.stats->count);
+    table.columns[7].append_double(entry.stats->min);
+    table.columns[8].append_double(entry.stats->p50);
+    table.columns[9].append_double(entry.stats->p90);
+    table.columns[10].append_double(entry.stats->p99);
+    table.columns[11].append_double(entry.stats->max);
+  }
+  return table;
+}
+
+ColumnTable buckets_table(const SummaryResult& result) {
+  ColumnTable table;
+  table.columns.emplace_back("start", ColumnType::Timestamp);
+  table.columns.emplace_back("matched", ColumnType::UInt64);
+  for (const LogLevel level : {LogLevel::Error, LogLevel::Warn, LogLevel::Info, LogLevel::Debug}) {
+    table.columns.emplace_back(std::string{level_name(level)}, ColumnType::UInt64);
+  }
+  std::vector<const TopLine*> patterns;
+  for (std::size_t i = 0; i < result.top_lines.size(); ++i) {
+    if (!result.top_lines[i].buckets.empty()) {
+      table.columns.emplace_back("top_" + std::to_string(i + 1), ColumnType::UInt64);
+      patterns.push_back(&result.top_lines[i]);
+    }
+  }
+
+  for (std::size_t row = 0; row < result.buckets.size(); ++row) {
+    const TimeBucket& bucket = result.buckets[row];
+    table.columns[0].append_time(bucket.start);
+    table.columns[1].append_uint(bucket.matched);
+    for (std::size_t level = 0; level < bucket.by_level.size(); ++level) {
+      table.columns[2 + level].append_uint(bucket.by_level[level]);
+    }
+    for (std::size_t i = 0; i < patterns.size(); ++i) {
+      table.columns[6 + i].append_uint(patterns[i]->buckets[row]);
+    }
+  }
+  return table;
+}
+
+ColumnTable groups_table(const SummaryResult& result) {
+  ColumnTable table;
+  table.columns.emplace_back("rank", ColumnType::UInt64);
+  table.columns.emplace_back("count", ColumnType::UInt64);
+  for (const std::string& key : result.group_by) {
+    table.columns.emplace_back(key, ColumnType::Utf8);
+  }
+
+  for (std::size_t i = 0; i < result.groups.size(); ++i) {
+    const GroupCount& group = result.groups[i];
+    table.columns[0].append_uint(i + 1);
+    table.columns[1].append_uint(group.count);
+    for (std::size_t key = 0; key < group.values.size(); ++key) {
+      table.columns[2 + key].append_text(group.values[key]);
+    }
+  }
+  return table;
+}
+
+}  // namespace
+
+std::optional<ResultTable> parse_result_table(std::string_view raw) {
+  if (raw == "top") {
+    return ResultTable::Top;
+  }
+  if (raw == "buckets") {
+    return ResultTable::Buckets;
+  }
+  if (raw == "groups") {
+    return ResultTable::Groups;
+  }
+  return std::nullopt;
+}
+
+Column::Column(std::string name, ColumnType type) : name_(std::move(name)), type_(type) {}
+
+void Column::push_valid(bool valid) {
+  if (!valid && validity_.empty()) {
+    // First null: every earlier row was valid.
+    validity_.assign(align_up(size_ + 1, 8) / 8, 0);
+    for (std::size_t row = 0; row < size_; ++row) {
+      validity_[row / 8] |= static_cast<std::uint8_t>(1U << (row % 8));
+    }
+  }
+  if (!validity_.empty()) {
+    validity_.resize(size_ / 8 + 1, 0);
+    if (valid) {
+      validity_[size_ / 8] |= static_cast<std::uint8_t>(1U << (size_ % 8));
+    }
+  }
+  null_count_ += valid ? 0 : 1;
+  ++size_;
+}
+
+void Column::append_uint(std::uint64_t value) {
+  words_.push_back(value);
+  push_valid(true);
+}
+
+void Column::append_double(double value) {
+  words_.push_back(std::bit_cast<std::uint64_t>(value));
+  push_valid(true);
+}
+
+void Column::append_time(std::time_t value) {
+  words_.push_back(static_cast<std::uint64_t>(static_cast<std::int64_t>(value)));
+  push_valid(true);
+}
+
+void Column::append_text(std::string_view value) {
+  text_.append(value);
+  if (text_.size() > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) {
+    throw std::length_error("column text exceeds 2 GiB");
+  }
+  offsets_.push_back(static_cast<std::int32_t>(text_.size()));
+  push_valid(true);
+}
+
+void Column::append_null() {
+  if (type_ == ColumnType::Utf8) {
+    offsets_.push_back(offsets_.back());
+  } else {
+    words_.push_back(0);
+  }
+  push_valid(false);
+}
+
+bool Column::is_valid(std::size_t row) const {
+  return validity_.empty() || (validity_[row / 8] & (1U << (row % 8))) != 0;
+}
+
+double Column::double_at(std::size_t row) const { return std::bit_cast<double>(words_[row]); }
+
+std::string_view Column::text_at(std::size_t row) const {
+  return text().substr(static_cast<std::size_t>(offsets_[row]),
+                       static_cast<std::size_t>(offsets_[row + 1] - offsets_[row]));
+}
+
+ColumnTable result_table(const SummaryResult& result, ResultTable which) {
+  switch (which) {
+    case ResultTable::Top:
+      return top_table(result);
+    case ResultTable::Buckets:
+      return buckets_table(result);
+    case ResultTable::Groups:
+      return groups_table(result);
+  }
+  return ColumnTable{};
+}
+
+std::string to_csv(const ColumnTable& table) {
+  std::string out;
+  for (std::size_t i = 0; i < table.columns.size(); ++i) {
+    if (i > 0) {
+      out.push_back(',');
+    }
+    append_csv_text(out, table.columns[i].name());
+  }
+  out += "\r\n";
+
+  for (std::size_t row = 0; row < table.rows(); ++row) {
+    for (std::size_t i = 0; i < table.columns.size(); ++i) {
+      if (i > 0) {
+        out.push_back(',');
+      }
+      append_csv_cell(out, table.columns[i], row);
+    }
+    out += "\r\n";
+  }
+  return out;
+}
+
+std::string to_arrow_stream(const ColumnTable& table) {
+  // Body: per column an optional validity bitmap, then values, or offsets and bytes for strings.
+  // The column memory is copied as is.
+  std::string body;
+  std::vector<std::int64_t> nodes;
+  std::vector<std::int64_t> buffers;
+  for (const Column& column : table.columns) {
+    nodes.push_back(static_cast<std::int64_t>(column.size()));
+    nodes.push_back(static_cast<std::int64_t>(column.null_count()));
+    add_buffer(body, buffers, column.validity().data(), column.null_count() == 0 ? 0 : column.validity().size());
+    if (column.type() == ColumnType::Utf8) {
+      add_buffer(body, buffers, column.offsets().data(), column.offsets().size_bytes());
+      add_buffer(body, buffers, column.text().data(), column.text().size());
+    } else {
+      add_buffer(body, buffers, column.words().data(), column.words().size_bytes());
+    }
+  }
+
+  FlatBuilder fb;
+  const std::string batch = fb.finish([&] {
+    const auto record_batch = [&] {
+      return fb.table({FlatBuilder::scalar(0, 8, table.rows()),
+                       FlatBuilder::offset(1, [&] { return fb.long_struct_vector(nodes, 2); }),
+                       FlatBuilder::offset(2, [&] { return fb.long_struct_vector(buffers, 2); })});
+    };
+    return fb.table({FlatBuilder::scalar(0, 2, kMetadataV5), FlatBuilder::scalar(1, 1, kHeaderRecordBatch),
+                     FlatBuilder::offset(2, record_batch), FlatBuilder::scalar(3, 8, body.size())});
+  });
+
+  std::string out;
+  append_message(out, schema_message(table), {});
+  append_message(out, batch, body);
+  // End-of-stream marker.
+  put_le(out, 0xFFFFFFFFU, 4);
+  put_le(out, 0, 4);
+  return out;
+}
+
+}  // namespace log_sheriff
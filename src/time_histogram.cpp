@@ -0,0 +1,71 @@
+#include "log_sheriff/time_histogram.hpp"
+
+#include <cctype>
+#include <limits>
+
+namespace log_sheriff {
+
+std::optional<std::uint32_t> parse_duration(std::string_view raw) {
+  if (raw.empty()) {
+    return std::nullopt;
+  }
+
+  std::uint64_t multiplier = 1;
+  switch (raw.back()) {
+    case 's':
+      raw.remove_suffix(1);
+      break;
+    case 'm':
+      multiplier = 60;
+      raw.remove_suffix(1);
+      break;
+    case 'h':
+      multiplier = 60 * 60;
+      raw.remove_suffix(1);
+      break;
+    case 'd':
+      multiplier = 24 * 60 * 60;
+      raw.remove_suffix(1);
+      break;
+    default:
+      break;
+  }
+
+  if (raw.empty() || raw.size() > 9) {
+    return std::nullopt;
+  }
+
+  std::uint64_t value = 0;
+  for (const unsigned char ch : raw) {
+    if (std::isdigit(ch) == 0) {
+      return std::nullopt;
+    }
+    value = value * 10 + (ch - static_cast<unsigned char>('0'));
+  }
+
+  value *= multiplier;
+  if (value == 0 || value > std::numeric_limits<std::uint32_t>::max()) {
+    return std::nullopt;
+  }
+  return static_cast<std::uint32_t>(value);
+}
+
+std::int64_t bucket_index(std::time_t epoch_seconds, std::uint32_t width_seconds) {
+  const auto seconds = static_cast<std::int64_t>(epoch_seconds);
+  const auto width = static_cast<std::int64_t>(width_seconds);
+  std::int64_t index = seconds / width;
+  if (seconds % width < 0) {
+    --index;
+  }
+  return index;
+}
+
+LevelBucket& LevelBucket::operator+=(const LevelBucket& other) {
+  matched += other.matched;
+  for (std::size_t i = 0; i < by_level.size(); ++i) {
+    by_level[i] += other.by_level[i];
+  }
+  return *this;
+}
+
+}  // namespace log_sheriff
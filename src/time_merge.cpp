@@ -0,0 +1,72 @@
+#include "log_sheriff/time_merge.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace log_sheriff {
+
+TimeMerger::TimeMerger(std::vector<std::span<const char>> inputs, InputFormat format) {
+  // Lines point at their cursor's record, so the cursors must not move once filled in.
+  cursors_.reserve(inputs.size());
+  for (const std::span<const char> input : inputs) {
+    cursors_.push_back(Cursor{input, 0, Line{}, Record(format), std::numeric_limits<std::time_t>::min()});
+  }
+
+  heap_.reserve(cursors_.size());
+  for (std::size_t input = 0; input < cursors_.size(); ++input) {
+    if (advance(input)) {
+      heap_.push_back(input);
+    }
+  }
+  std::make_heap(heap_.begin(), heap_.end(), [this](std::size_t lhs, std::size_t rhs) { return after(lhs, rhs); });
+}
+
+bool TimeMerger::next(Line& line) {
+  const auto cmp = [this](std::size_t lhs, std::size_t rhs) { return after(lhs, rhs); };
+  if (yielded_.has_value()) {
+    const std::size_t input = *yielded_;
+    yielded_.reset();
+    if (advance(input)) {
+      heap_.push_back(input);
+      std::push_heap(heap_.begin(), heap_.end(), cmp);
+    }
+  }
+  if (heap_.empty()) {
+    return false;
+  }
+
+  std::pop_heap(heap_.begin(), heap_.end(), cmp);
+  const std::size_t input = heap_.back();
+  heap_.pop_back();
+  line = cursors_[input].current;
+  yielded_ = input;
+  return true;
+}
+
+bool TimeMerger::advance(std::size_t input) {
+  Cursor& cursor = cursors_[input];
+  if (cursor.pos >= cursor.data.size()) {
+    return false;
+  }
+
+  const char* const begin = cursor.data.data() + cursor.pos;
+  const std::size_t remaining = cursor.data.size() - cursor.pos;
+  const auto* newline = static_cast<const char*>(std::memchr(begin, '\n', remaining));
+  const std::size_t length = newline == nullptr ? remaining : static_cast<std::size_t>(newline - begin);
+  cursor.current = Line{std::string_view(begin, length), newline != nullptr, input, &cursor.record};
+  cursor.pos += newline == nullptr ? length : length + 1;
+
+  if (const auto timestamp = cursor.record.parse(cursor.current.text).timestamp(); timestamp.has_value()) {
+    cursor.key = *timestamp;
+  }
+  return true;
+}
+
+bool TimeMerger::after(std::size_t lhs, std::size_t rhs) const {
+  const std::time_t left = cursors_[lhs].key;
+  const std::time_t right = cursors_[rhs].key;
+  return left != right ? left > right : lhs > rhs;
+}
+
+}  // namespace log_sheriff
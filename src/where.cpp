@@ -0,0 +1,302 @@
+#include "log_sheriff/where.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "log_sheriff/fields.hpp"
+
+namespace log_sheriff {
+namespace {
+
+bool is_space(char ch) { return std::isspace(static_cast<unsigned char>(ch)) != 0; }
+
+bool is_key_char(char ch) {
+  switch (ch) {
+    case '(':
+    case ')':
+    case '=':
+    case '!':
+    case '<':
+    case '>':
+    case '~':
+    case '"':
+    case '&':
+    case '|':
+      return false;
+    default:
+      return !is_space(ch);
+  }
+}
+
+bool equals_ignore_case(std::string_view lhs, std::string_view rhs) {
+  return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+           return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+         });
+}
+
+}  // namespace
+
+class WhereParser {
+ public:
+  WhereParser(std::string_view input, WhereFilter& filter) : input_(input), filter_(filter) {}
+
+  void parse() {
+    filter_.root_ = parse_or();
+    skip_space();
+    if (pos_ != input_.size()) {
+      fail("unexpected '" + std::string{input_.substr(pos_, 1)} + "'");
+    }
+  }
+
+ private:
+  using Node = WhereFilter::Node;
+  using NodeKind = WhereFilter::NodeKind;
+  using CompareOp = WhereFilter::CompareOp;
+
+  std::uint32_t parse_or() {
+    std::uint32_t lhs = parse_and();
+    while (consume_keyword("or") || consume_symbol("||")) {
+      lhs = add_binary(NodeKind::Or, lhs, parse_and());
+    }
+    return lhs;
+  }
+
+  std::uint32_t parse_and() {
+    std::uint32_t lhs = parse_unary();
+    while (true) {
+      if (consume_keyword("and") || consume_symbol("&&")) {
+        lhs = add_binary(NodeKind::And, lhs, parse_unary());
+        continue;
+      }
+      // Juxtaposed terms (`status>=500 shard=3`) are an implicit `and`.
+      skip_space();
+      if (pos_ < input_.size() && input_[pos_] != ')' && input_[pos_] != '|' && !at_keyword("or")) {
+        lhs = add_binary(NodeKind::And, lhs, parse_unary());
+        continue;
+      }
+      return lhs;
+    }
+  }
+
+  std::uint32_t parse_unary() {
+    if (consume_keyword("not") || consume_symbol("!")) {
+      Node node;
+      node.kind = NodeKind::Not;
+      node.lhs = parse_unary();
+      return add(std::move(node));
+    }
+    if (consume_symbol("(")) {
+      const std::uint32_t inner = parse_or();
+      if (!consume_symbol(")")) {
+        fail("expected ')'");
+      }
+      return inner;
+    }
+    return parse_comparison();
+  }
+
+  std::uint32_t parse_comparison() {
+    skip_space();
+    const std::size_t start = pos_;
+    while (pos_ < input_.size() && is_key_char(input_[pos_])) {
+      ++pos_;
+    }
+    if (pos_ == start) {
+      fail(pos_ < input_.size() ? "expected a field name" : "unexpected end of expression");
+    }
+
+    Node node;
+    node.key = intern_key(input_.substr(start, pos_ - start));
+
+    const std::optional<CompareOp> op = parse_operator();
+    if (!op.has_value()) {
+      node.kind = NodeKind::Exists;
+      return add(std::move(node));
+    }
+
+    node.kind = NodeKind::Compare;
+    node.op = *op;
+    node.text = parse_value();
+    node.number = parse_number(node.text);
+    return add(std::move(node));
+  }
+
+  std::optional<CompareOp> parse_operator() {
+    skip_space();
+    const std::string_view rest = input_.substr(pos_);
+    static constexpr std::pair<std::string_view, CompareOp> kOperators[] = {
+        {"==", CompareOp::Eq}, {"!=", CompareOp::Ne}, {"<=", CompareOp::Le}, {">=", CompareOp::Ge},
+        {"=", CompareOp::Eq},  {"<", CompareOp::Lt},  {">", CompareOp::Gt},  {"~", CompareOp::Contains},
+    };
+    for (const auto& [symbol, op] : kOperators) {
+      if (rest.substr(0, symbol.size()) == symbol) {
+        pos_ += symbol.size();
+        return op;
+      }
+    }
+    return std::nullopt;
+  }
+
+  std::string parse_value() {
+    skip_space();
+    if (pos_ < input_.size() && input_[pos_] == '"') {
+      std::string value;
+      ++pos_;
+      while (pos_ < input_.size() && input_[pos_] != '"') {
+        if (input_[pos_] == '\\' && pos_ + 1 < input_.size()) {
+          ++pos_;
+        }
+        value.push_back(input_[pos_++]);
+      }
+      if (pos_ == input_.size()) {
+        fail("unterminated string");
+      }
+      ++pos_;
+      return value;
+    }
+
+    // Unquoted values end where an operator could start, so `status=500||status=503` is two
+    // comparisons; quote values that hold these characters.
+    const std::size_t start = pos_;
+    while (pos_ < input_.size() && !is_space(input_[pos_]) &&
+           std::string_view("()|&!").find(input_[pos_]) == std::string_view::npos) {
+      ++pos_;
+    }
+    if (pos_ == start) {
+      fail("expected a value");
+    }
+    return std::string{input_.substr(start, pos_ - start)};
+  }
+
+  std::uint32_t intern_key(std::string_view key) {
+    auto& keys = filter_.keys_;
+    if (const auto it = std::find(keys.begin(), keys.end(), key); it != keys.end()) {
+      return static_cast<std::uint32_t>(it - keys.begin());
+    }
+    keys.emplace_back(key);
+    return static_cast<std::uint32_t>(keys.size() - 1);
+  }
+
+  std::uint32_t add_binary(NodeKind kind, std::uint32_t lhs, std::uint32_t rhs) {
+    Node node;
+    node.kind = kind;
+    node.lhs = lhs;
+    node.rhs = rhs;
+    return add(std::move(node));
+  }
+
+  std::uint32_t add(Node node) {
+    filter_.nodes_.push_back(std::move(node));
+    return static_cast<std::uint32_t>(filter_.nodes_.size() - 1);
+  }
+
+  void skip_space() {
+    while (pos_ < input_.size() && is_space(input_[pos_])) {
+      ++pos_;
+    }
+  }
+
+  bool at_keyword(std::string_view keyword) {
+    skip_space();
+    const std::size_t end = pos_ + keyword.size();
+    return end <= input_.size() && equals_ignore_case(input_.substr(pos_, keyword.size()), keyword) &&
+           (end == input_.size() || !is_key_char(input_[end]) || input_[end] == '(');
+  }
+
+  bool consume_keyword(std::string_view keyword) {
+    if (!at_keyword(keyword)) {
+      return false;
+    }
+    pos_ += keyword.size();
+    return true;
+  }
+
+  bool consume_symbol(std::string_view symbol) {
+    skip_space();
+    if (input_.substr(pos_, symbol.size()) != symbol) {
+      return false;
+    }
+    // `!=` is an operator, not negation.
+    if (symbol == "!" && input_.substr(pos_, 2) == "!=") {
+      return false;
+    }
+    pos_ += symbol.size();
+    return true;
+  }
+
+  [[noreturn]] void fail(const std::string& message) const {
+    throw std::invalid_argument("invalid --where expression at offset " + std::to_string(pos_) + ": " +
+                                message);
+  }
+
+  std::string_view input_;
+  WhereFilter& filter_;
+  std::size_t pos_ = 0;
+};
+
+WhereFilter WhereFilter::compile(std::string_view expression) {
+  WhereFilter filter;
+  WhereParser(expression, filter).parse();
+  return filter;
+}
+
+bool WhereFilter::matches(const Record& record) const { return evaluate(root_, record); }
+
+bool WhereFilter::evaluate(std::uint32_t index, const Record& record) const {
+  const Node& node = nodes_[index];
+  switch (node.kind) {
+    case NodeKind::And:
+      return evaluate(node.lhs, record) && evaluate(node.rhs, record);
+    case NodeKind::Or:
+      return evaluate(node.lhs, record) || evaluate(node.rhs, record);
+    case NodeKind::Not:
+      return !evaluate(node.lhs, record);
+    case NodeKind::Exists:
+      return record.field(keys_[node.key]).has_value();
+    case NodeKind::Compare:
+      break;
+  }
+
+  const auto value = record.field(keys_[node.key]);
+  if (!value.has_value()) {
+    return false;
+  }
+
+  if (node.op == CompareOp::Contains) {
+    return value->find(node.text) != std::string_view::npos;
+  }
+
+  int order = 0;
+  const auto number = node.number.has_value() ? parse_number(*value) : std::nullopt;
+  if (number.has_value()) {
+    order = *number < *node.number ? -1 : (*number > *node.number ? 1 : 0);
+  } else if (node.number.has_value() && node.op != CompareOp::Eq && node.op != CompareOp::Ne) {
+    // `status>=500` must not match `status=5000x` through a lexicographic comparison.
+    return false;
+  } else {
+    order = value->compare(node.text);
+  }
+
+  switch (node.op) {
+    case CompareOp::Eq:
+      return order == 0;
+    case CompareOp::Ne:
+      return order != 0;
+    case CompareOp::Lt:
+      return order < 0;
+    case CompareOp::Le:
+      return order <= 0;
+    case CompareOp::Gt:
+      return order > 0;
+    case CompareOp::Ge:
+      return order >= 0;
+    case CompareOp::Contains:
+      break;
+  }
+  return false;
+}
+
+}  // namespace log_sheriff
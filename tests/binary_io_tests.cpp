@@ -0,0 +1,77 @@
+#include "log_sheriff/binary_io.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string read_file(const std::filesystem::path& path) {
+  std::ifstream in(path, std::ios::in | std::ios::binary);
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+std::string read_in_chunks(const std::string& path, std::size_t chunk_bytes) {
+  std::vector<char> buffer(chunk_bytes);
+  std::string out;
+  log_sheriff::read_file_chunks(path, buffer, [&out, chunk_bytes](std::span<const char> chunk) {
+    REQUIRE(chunk.size() <= chunk_bytes);
+    out.append(chunk.data(), chunk.size());
+  });
+  return out;
+}
+
+}  // namespace
+
+TEST_CASE("little-endian integers round-trip", "[binary]") {
+  std::string out;
+  log_sheriff::put_u32(out, 0x01020304U);
+  log_sheriff::put_u64(out, 0xF1E2D3C4B5A69788ULL);
+  REQUIRE(out.size() == 12);
+  REQUIRE(out.substr(0, 4) == "\x04\x03\x02\x01");
+  REQUIRE(log_sheriff::load_u32(out.data()) == 0x01020304U);
+  REQUIRE(log_sheriff::load_u64(out.data() + 4) == 0xF1E2D3C4B5A69788ULL);
+}
+
+TEST_CASE("files are replaced through a temporary file", "[binary]") {
+  const std::filesystem::path path = std::filesystem::temp_directory_path() / "log_sheriff_replace.bin";
+  log_sheriff::replace_file(path, "first", "test file");
+  log_sheriff::replace_file(path, "second", "test file");
+  REQUIRE(read_file(path) == "second");
+  REQUIRE_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+
+  try {
+    log_sheriff::replace_file("/nonexistent/log-sheriff/file.bin", "x", "test file");
+    FAIL("expected an exception");
+  } catch (const std::runtime_error& error) {
+    REQUIRE(std::string(error.what()).starts_with("failed to write test file: "));
+  }
+}
+
+TEST_CASE("files are read in bounded blocks", "[binary]") {
+  const std::filesystem::path path = std::filesystem::temp_directory_path() / "log_sheriff_binary_chunks.log";
+  std::ofstream(path, std::ios::binary) << "0123456789abc";
+  REQUIRE(read_in_chunks(path.string(), 4) == "0123456789abc");
+  REQUIRE(read_in_chunks(path.string(), 64) == "0123456789abc");
+
+  // From wherever the stream stands.
+  std::ifstream in(path, std::ios::in | std::ios::binary);
+  in.seekg(10);
+  std::vector<char> buffer(2);
+  std::string rest;
+  log_sheriff::read_stream_chunks(in, buffer,
+                                  [&rest](std::span<const char> chunk) { rest.append(chunk.data(), chunk.size()); });
+  REQUIRE(rest == "abc");
+
+  std::ofstream(path, std::ios::binary | std::ios::trunc).flush();
+  REQUIRE(read_in_chunks(path.string(), 4).empty());
+  REQUIRE_THROWS_AS(read_in_chunks("/nonexistent/log-sheriff.log", 4), std::runtime_error);
+  std::filesystem::remove(path);
+}
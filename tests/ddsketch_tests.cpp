@@ -0,0 +1,68 @@
+#include "log_sheriff/ddsketch.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+
+namespace {
+
+bool within_accuracy(double estimate, double expected) {
+  return std::abs(estimate - expected) <= expected * log_sheriff::DDSketch::kRelativeAccuracy + 1e-9;
+}
+
+}  // namespace
+
+TEST_CASE("ddsketch quantiles stay within relative accuracy", "[ddsketch]") {
+  log_sheriff::DDSketch sketch;
+  for (int value = 1; value <= 1000; ++value) {
+    sketch.add(value);
+  }
+
+  REQUIRE(sketch.count() == 1000);
+  REQUIRE(sketch.min() == 1.0);
+  REQUIRE(sketch.max() == 1000.0);
+  REQUIRE(within_accuracy(sketch.quantile(0.5), 500.0));
+  REQUIRE(within_accuracy(sketch.quantile(0.99), 990.0));
+  REQUIRE(sketch.quantile(0.0) == 1.0);
+  REQUIRE(sketch.quantile(1.0) == 1000.0);
+}
+
+TEST_CASE("ddsketch handles zero and negative values", "[ddsketch]") {
+  log_sheriff::DDSketch sketch;
+  sketch.add(-10.0);
+  sketch.add(0.0);
+  sketch.add(10.0);
+
+  REQUIRE(within_accuracy(-sketch.quantile(0.0), 10.0));
+  REQUIRE(sketch.quantile(0.5) == 0.0);
+  REQUIRE(within_accuracy(sketch.quantile(1.0), 10.0));
+}
+
+TEST_CASE("merged ddsketches equal a sketch of all values", "[ddsketch]") {
+  log_sheriff::DDSketch low;
+  log_sheriff::DDSketch high;
+  log_sheriff::DDSketch all;
+  for (int value = 1; value <= 500; ++value) {
+    low.add(value);
+    all.add(value);
+  }
+  for (int value = 501; value <= 1000; ++value) {
+    high.add(value);
+    all.add(value);
+  }
+
+  low.merge(high);
+  REQUIRE(low.count() == all.count());
+  REQUIRE(low.quantile(0.9) == all.quantile(0.9));
+  REQUIRE(low.max() == 1000.0);
+}
+
+TEST_CASE("ddsketch bounds its bin count", "[ddsketch]") {
+  log_sheriff::DDSketch sketch;
+  for (double value = 1e-6; value < 1e30; value *= 1.5) {
+    sketch.add(value);
+  }
+
+  REQUIRE(sketch.positive().bins.size() <= log_sheriff::DDSketch::kMaxBins);
+  REQUIRE(within_accuracy(sketch.quantile(1.0), sketch.max()));
+}
@@ -0,0 +1,92 @@
+#include "log_sheriff/diff.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+log_sheriff::SummaryPartial partial_of(const std::vector<std::pair<std::string, std::uint64_t>>& patterns) {
+  log_sheriff::SummaryPartial partial;
+  for (const auto& [pattern, count] : patterns) {
+    partial.patterns.add(pattern, count);
+    partial.matched_lines += count;
+  }
+  return partial;
+}
+
+}  // namespace
+
+TEST_CASE("diff ranks new and spiking patterns by significance", "[diff]") {
+  const log_sheriff::SummaryPartial baseline =
+      partial_of({{"INFO ok", 1000}, {"WARN slow", 10}, {"ERROR gone", 20}, {"DEBUG steady", 100}});
+  const log_sheriff::SummaryPartial current =
+      partial_of({{"INFO ok", 1000}, {"WARN slow", 60}, {"ERROR timeout", 30}, {"DEBUG steady", 100}});
+
+  const log_sheriff::DiffResult diff = log_sheriff::diff_partials(baseline, current, 10);
+  REQUIRE(diff.baseline_matched == 1130);
+  REQUIRE(diff.current_matched == 1190);
+  REQUIRE(diff.increased.size() == 2);
+  REQUIRE(diff.increased[0].normalized_line == "WARN slow");
+  REQUIRE(diff.increased[0].delta == 50);
+  REQUIRE(diff.increased[0].ratio > 5.0);
+  REQUIRE(diff.increased[0].z_score > diff.increased[1].z_score);
+  REQUIRE(diff.increased[0].p_value < 0.001);
+  REQUIRE(diff.increased[1].normalized_line == "ERROR timeout");
+  REQUIRE(diff.increased[1].baseline_count == 0);
+
+  // Unchanged counts in a larger window still lose share.
+  REQUIRE(diff.decreased.front().normalized_line == "ERROR gone");
+  REQUIRE(diff.decreased.front().current_count == 0);
+  REQUIRE(diff.decreased.front().z_score < 0.0);
+
+  const log_sheriff::DiffResult significant = log_sheriff::diff_partials(baseline, current, 1, 0.01);
+  REQUIRE(significant.increased.size() == 1);
+  REQUIRE(significant.decreased.size() == 1);
+  REQUIRE(significant.decreased[0].normalized_line == "ERROR gone");
+
+  std::string document;
+  {
+    log_sheriff::JsonWriter json(document);
+    log_sheriff::write_diff_json(json, significant);
+  }
+  REQUIRE(document.rfind("{\"baseline\":{\"files_processed\":0,\"matched_lines\":1130},", 0) == 0);
+  REQUIRE(document.find("\"increased\":[{\"line\":\"WARN slow\",\"baseline_count\":10,\"current_count\":60,"
+                        "\"delta\":50,") != std::string::npos);
+}
+
+TEST_CASE("diff summarizes both sides with their own time windows", "[diff]") {
+  const std::filesystem::path path = std::filesystem::temp_directory_path() / "log_sheriff_diff_windows.log";
+  {
+    std::ofstream out(path);
+    out << "2026-02-08T10:00:00Z INFO ok\n"
+           "2026-02-08T10:00:01Z INFO ok\n"
+           "2026-02-09T10:00:00Z INFO ok\n"
+           "2026-02-09T10:00:01Z ERROR disk full\n";
+  }
+
+  log_sheriff::SummarizeOptions baseline;
+  baseline.files = {path.string()};
+  baseline.until = "2026-02-08T23:59:59Z";
+  log_sheriff::SummarizeOptions current = baseline;
+  current.until.reset();
+  current.since = "2026-02-09T00:00:00Z";
+
+  const log_sheriff::DiffResult diff = log_sheriff::diff_summaries(baseline, current, 10);
+  REQUIRE(diff.baseline_matched == 2);
+  REQUIRE(diff.current_matched == 2);
+  REQUIRE(diff.increased.size() == 1);
+  REQUIRE(diff.increased[0].normalized_line == "<num>-<num>-<num>T<num>:<num>:<num>Z ERROR disk full");
+  REQUIRE(diff.decreased.size() == 1);
+  REQUIRE(diff.decreased[0].current_count == 1);
+
+  baseline.files = {"/nonexistent/log_sheriff.log"};
+  REQUIRE_THROWS(log_sheriff::diff_summaries(baseline, current, 10));
+  std::filesystem::remove(path);
+}
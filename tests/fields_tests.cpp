@@ -0,0 +1,27 @@
+#include "log_sheriff/fields.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("find_field matches whole keys only", "[fields]") {
+  constexpr std::string_view line = "GET path=/health status=200 latency_ms=3 sub_status=7";
+  REQUIRE(log_sheriff::find_field(line, "status") == "200");
+  REQUIRE(log_sheriff::find_field(line, "latency_ms") == "3");
+  REQUIRE(log_sheriff::find_field(line, "path") == "/health");
+  REQUIRE_FALSE(log_sheriff::find_field(line, "latency").has_value());
+  REQUIRE_FALSE(log_sheriff::find_field(line, "GET").has_value());
+}
+
+TEST_CASE("find_field understands quoted values", "[fields]") {
+  REQUIRE(log_sheriff::find_field("msg=\"db timed out\" shard=3", "msg") == "db timed out");
+  REQUIRE(log_sheriff::find_field("msg=\"unterminated", "msg") == "unterminated");
+  REQUIRE(log_sheriff::find_field("empty= next=1", "empty") == "");
+}
+
+TEST_CASE("parse_number is strict", "[fields]") {
+  REQUIRE(log_sheriff::parse_number("42") == 42.0);
+  REQUIRE(log_sheriff::parse_number("-2.5") == -2.5);
+  REQUIRE(log_sheriff::parse_number("1e3") == 1000.0);
+  REQUIRE_FALSE(log_sheriff::parse_number("12ms").has_value());
+  REQUIRE_FALSE(log_sheriff::parse_number("").has_value());
+  REQUIRE_FALSE(log_sheriff::parse_number(".").has_value());
+}
@@ -0,0 +1,54 @@
+#include "log_sheriff/group_table.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+TEST_CASE("group table counts value tuples", "[group]") {
+  log_sheriff::GroupTable table;
+  const std::vector<std::string_view> a{"/health", "3"};
+  const std::vector<std::string_view> b{"/orders", "3"};
+
+  REQUIRE(table.add(a) == 0);
+  REQUIRE(table.add(b) == 1);
+  REQUIRE(table.add(a) == 0);
+
+  REQUIRE(table.size() == 2);
+  REQUIRE(table.count(0) == 2);
+  REQUIRE(table.values(1) == std::vector<std::string>{"/orders", "3"});
+  REQUIRE(table.top(1) == std::vector<std::size_t>{0});
+}
+
+TEST_CASE("group table keeps distinct groups through rehashing", "[group]") {
+  log_sheriff::GroupTable table;
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 1000; ++i) {
+      const std::string value = std::to_string(i);
+      const std::string_view view = value;
+      table.add(std::span<const std::string_view>(&view, 1));
+    }
+  }
+
+  REQUIRE(table.size() == 1000);
+  for (std::size_t i = 0; i < table.size(); ++i) {
+    REQUIRE(table.count(i) == 3);
+  }
+}
+
+TEST_CASE("group table merge remaps patterns", "[group]") {
+  const std::vector<std::string_view> shard{"7"};
+
+  log_sheriff::GroupTable left;
+  left.add_pattern(left.add(shard), 0);
+
+  log_sheriff::GroupTable right;
+  right.add_pattern(right.add(shard, 2), 0, 2);
+
+  left.merge(right, {5});
+  REQUIRE(left.size() == 1);
+  REQUIRE(left.count(0) == 3);
+  REQUIRE(left.patterns(0).at(0) == 1);
+  REQUIRE(left.patterns(0).at(5) == 2);
+}
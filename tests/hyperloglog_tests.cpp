@@ -0,0 +1,105 @@
+#include "log_sheriff/hyperloglog.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+bool within_error(std::uint64_t estimate, double expected, double relative_error) {
+  return std::abs(static_cast<double>(estimate) - expected) <= expected * relative_error;
+}
+
+}  // namespace
+
+TEST_CASE("hyperloglog counts small sets exactly while sparse", "[hyperloglog]") {
+  log_sheriff::HyperLogLog sketch;
+  REQUIRE(sketch.estimate() == 0);
+
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 500; ++i) {
+      sketch.add("value-" + std::to_string(i));
+    }
+  }
+
+  REQUIRE(sketch.is_sparse());
+  REQUIRE(sketch.estimate() == 500);
+}
+
+TEST_CASE("hyperloglog estimates large sets within a few standard errors", "[hyperloglog]") {
+  log_sheriff::HyperLogLog sketch(12);
+  for (int i = 0; i < 200000; ++i) {
+    sketch.add("user-" + std::to_string(i));
+  }
+
+  REQUIRE_FALSE(sketch.is_sparse());
+  // Standard error at precision 12 is about 1.6%.
+  REQUIRE(within_error(sketch.estimate(), 200000.0, 0.05));
+}
+
+TEST_CASE("hyperloglog merge matches a sketch of the union", "[hyperloglog]") {
+  log_sheriff::HyperLogLog left(10);
+  log_sheriff::HyperLogLog right(10);
+  log_sheriff::HyperLogLog both(10);
+  for (int i = 0; i < 3000; ++i) {
+    const std::string value = "id-" + std::to_string(i);
+    (i % 2 == 0 ? left : right).add(value);
+    both.add(value);
+  }
+  // A sparse sketch merged into a dense one, and the other way round.
+  log_sheriff::HyperLogLog small(10);
+  small.add("id-1");
+
+  log_sheriff::HyperLogLog merged = small;
+  merged.merge(left);
+  merged.merge(right);
+  left.merge(small);
+  left.merge(right);
+
+  REQUIRE(merged.registers() == both.registers());
+  REQUIRE(left.registers() == both.registers());
+  REQUIRE(merged.estimate() == both.estimate());
+
+  REQUIRE_THROWS_AS(merged.merge(log_sheriff::HyperLogLog(11)), std::invalid_argument);
+}
+
+TEST_CASE("hyperloglog reads a shared sketch without modifying it", "[hyperloglog]") {
+  log_sheriff::HyperLogLog shared(10);
+  for (int i = 0; i < 20; ++i) {
+    shared.add("id-" + std::to_string(i % 15));
+  }
+  const std::vector<std::uint32_t> entries = shared.sparse_entries();
+  REQUIRE(entries.size() == 15);
+
+  // Readers merging from and estimating the same const sketch at once.
+  std::vector<std::uint64_t> estimates(4);
+  std::vector<std::thread> readers;
+  for (std::size_t i = 0; i < estimates.size(); ++i) {
+    readers.emplace_back([&shared, &estimates, i] {
+      log_sheriff::HyperLogLog merged(10);
+      merged.add("other");
+      merged.merge(shared);
+      estimates[i] = merged.estimate() + shared.estimate();
+    });
+  }
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  for (const std::uint64_t estimate : estimates) {
+    REQUIRE(estimate == 31);
+  }
+
+  shared.compact();
+  REQUIRE(shared.sparse_entries() == entries);
+}
+
+TEST_CASE("hyperloglog rejects out-of-range precision", "[hyperloglog]") {
+  REQUIRE_THROWS_AS(log_sheriff::HyperLogLog(3), std::invalid_argument);
+  REQUIRE_THROWS_AS(log_sheriff::HyperLogLog(19), std::invalid_argument);
+  REQUIRE_THROWS_AS(log_sheriff::HyperLogLog::restore_dense(4, std::vector<std::uint8_t>(8)), std::invalid_argument);
+}
@@ -0,0 +1,79 @@
+#include "log_sheriff/input_discovery.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+void touch(const std::filesystem::path& path) {
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream out(path);
+  out << "line\n";
+}
+
+}  // namespace
+
+TEST_CASE("glob patterns match shell-style", "[discover]") {
+  using log_sheriff::glob_match;
+  REQUIRE(glob_match("*.log", "app.log"));
+  REQUIRE(glob_match("*.log", ".log"));
+  REQUIRE_FALSE(glob_match("*.log", "app.log.1"));
+  REQUIRE(glob_match("app-*-*.log", "app-a-b-c.log"));
+  REQUIRE(glob_match("app.log.?", "app.log.1"));
+  REQUIRE_FALSE(glob_match("app.log.?", "app.log.10"));
+  REQUIRE(glob_match("pod-[0-9][!x].log", "pod-3y.log"));
+  REQUIRE_FALSE(glob_match("pod-[0-9][!x].log", "pod-3x.log"));
+  REQUIRE(glob_match("[]]", "]"));
+  REQUIRE(glob_match("a[b", "a[b"));
+  REQUIRE(glob_match("*", ""));
+  REQUIRE_FALSE(glob_match("?", ""));
+}
+
+TEST_CASE("inputs expand directories and globs", "[discover]") {
+  const std::filesystem::path root = std::filesystem::temp_directory_path() / "log_sheriff_discover";
+  std::filesystem::remove_all(root);
+  touch(root / "a.log");
+  touch(root / "b.txt");
+  touch(root / "pods" / "p1" / "c.log");
+  touch(root / "pods" / "p2" / "d.log");
+  touch(root / "pods" / "p2" / "deep" / "e.log");
+  std::filesystem::create_directories(root / "empty");
+  const std::string base = root.string();
+
+  log_sheriff::DiscoverOptions options;
+  options.threads = 3;
+  options.directories = {base + "/pods/"};
+  options.paths = {base + "/b.txt", base + "/*.log", base + "/**/d.log"};
+  REQUIRE(log_sheriff::discover_inputs(options) ==
+          std::vector<std::string>{base + "/b.txt", base + "/a.log", base + "/pods/p1/c.log",
+                                   base + "/pods/p2/d.log", base + "/pods/p2/deep/e.log"});
+
+  // Found files modified before the bound are skipped.
+  std::filesystem::last_write_time(root / "pods" / "p1" / "c.log",
+                                   std::filesystem::file_time_type::clock::now() - std::chrono::hours(48));
+  options.paths.clear();
+  options.modified_since = *log_sheriff::file_modified_time(base + "/a.log") - 3600;
+  REQUIRE(log_sheriff::discover_inputs(options) ==
+          std::vector<std::string>{base + "/pods/p2/d.log", base + "/pods/p2/deep/e.log"});
+
+  options = log_sheriff::DiscoverOptions{};
+  options.paths = {base + "/missing.log"};
+  REQUIRE_THROWS_AS(log_sheriff::discover_inputs(options), std::runtime_error);
+  options.paths = {base};
+  REQUIRE_THROWS_AS(log_sheriff::discover_inputs(options), std::runtime_error);
+  options.paths = {base + "/*/c.log"};
+  REQUIRE_THROWS_AS(log_sheriff::discover_inputs(options), std::invalid_argument);
+  options.paths = {};
+  options.directories = {base + "/nope"};
+  REQUIRE_THROWS_AS(log_sheriff::discover_inputs(options), std::runtime_error);
+  options.directories = {base + "/empty"};
+  REQUIRE(log_sheriff::discover_inputs(options).empty());
+
+  std::filesystem::remove_all(root);
+}
@@ -0,0 +1,34 @@
+#include "log_sheriff/json_fields.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+TEST_CASE("json fields locates top-level members without decoding", "[json]") {
+  log_sheriff::JsonFields fields;
+  REQUIRE(fields.parse(
+      R"( {"ts": 1700000000, "level":"warn", "msg": "say \"hi\" \\", "ctx": {"a": [1, "}"]}, "ok": true} )"));
+
+  REQUIRE(fields.members().size() == 5);
+  REQUIRE(fields.find("ts")->value == "1700000000");
+  REQUIRE_FALSE(fields.find("ts")->is_string);
+  REQUIRE(fields.find("level")->value == "warn");
+  REQUIRE(fields.find("level")->is_string);
+  REQUIRE(fields.find("msg")->value == R"(say \"hi\" \\)");
+  REQUIRE(fields.find("ctx")->value == R"({"a": [1, "}"]})");
+  REQUIRE(fields.find("ok")->value == "true");
+  REQUIRE(fields.find("a") == nullptr);
+
+  REQUIRE(fields.parse("{}"));
+  REQUIRE(fields.members().empty());
+}
+
+TEST_CASE("json fields rejects lines that are not one object", "[json]") {
+  log_sheriff::JsonFields fields;
+  for (const std::string bad : {"", "plain text", "[1]", "{", R"({"a" 1})", R"({"a": })", R"({"a": 1,})",
+                                R"({"a": "open})", R"({"a": [1})", R"({"a": 1} trailing)", R"({a: 1})"}) {
+    INFO(bad);
+    REQUIRE_FALSE(fields.parse(bad));
+    REQUIRE(fields.members().empty());
+  }
+}
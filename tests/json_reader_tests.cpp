@@ -0,0 +1,41 @@
+#include "log_sheriff/json_reader.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdexcept>
+#include <string>
+
+TEST_CASE("json reader parses nested documents", "[json]") {
+  const log_sheriff::JsonValue value = log_sheriff::parse_json(
+      R"( {"files": ["a.log", "b\"c.log"], "top": 5, "ratio": -1.5e2, "on": true, "off": false,
+           "none": null, "nested": {"list": [[], {}]}} )");
+
+  REQUIRE(value.kind() == log_sheriff::JsonValue::Kind::Object);
+  REQUIRE(value.members().size() == 7);
+  REQUIRE(value.find("files")->items().size() == 2);
+  REQUIRE(value.find("files")->items()[1].as_string() == "b\"c.log");
+  REQUIRE(value.find("top")->as_number() == 5.0);
+  REQUIRE(value.find("ratio")->as_number() == -150.0);
+  REQUIRE(value.find("on")->as_bool());
+  REQUIRE_FALSE(value.find("off")->as_bool());
+  REQUIRE(value.find("none")->is_null());
+  REQUIRE(value.find("nested")->find("list")->items()[1].members().empty());
+  REQUIRE(value.find("missing") == nullptr);
+  REQUIRE_THROWS_AS(value.find("top")->as_string(), std::invalid_argument);
+}
+
+TEST_CASE("json reader decodes escapes to UTF-8", "[json]") {
+  REQUIRE(log_sheriff::parse_json(R"("tab\t nl\n slash\/ e\u00e9 euro\u20ac")").as_string() ==
+          "tab\t nl\n slash/ e\xc3\xa9 euro\xe2\x82\xac");
+  REQUIRE(log_sheriff::parse_json(R"("\ud83d\ude00")").as_string() == "\xf0\x9f\x98\x80");
+}
+
+TEST_CASE("json reader rejects malformed input", "[json]") {
+  for (const std::string bad : {"", "{", "[1,]", "{\"a\" 1}", "01", "1.", "-", "tru", "\"open", "\"\\x\"",
+                                "\"\\ud83d\"", "\"a\nb\"", "[] []", "nan"}) {
+    INFO(bad);
+    REQUIRE_THROWS_AS(log_sheriff::parse_json(bad), std::invalid_argument);
+  }
+  REQUIRE_THROWS_AS(log_sheriff::parse_json(std::string(100, '[') + std::string(100, ']')), std::invalid_argument);
+  REQUIRE(log_sheriff::parse_json(std::string(10, '[') + std::string(10, ']')).items().size() == 1);
+}
@@ -0,0 +1,103 @@
+#include "log_sheriff/json_writer.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+
+namespace {
+
+std::string escaped(std::string_view text) {
+  std::string out;
+  log_sheriff::append_json_escaped(out, text);
+  return out;
+}
+
+// Reads back everything written to `file`.
+std::string contents(std::FILE* file) {
+  std::rewind(file);
+  std::string out;
+  char buffer[256];
+  std::size_t read = 0;
+  while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    out.append(buffer, read);
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST_CASE("json escaping handles specials at any offset", "[json]") {
+  REQUIRE(escaped("plain text") == "plain text");
+  REQUIRE(escaped("say \"hi\"\\n") == "say \\\"hi\\\"\\\\n");
+  REQUIRE(escaped("tab\there\nnew\r") == "tab\\there\\nnew\\r");
+  REQUIRE(escaped(std::string_view("nul\0bell\x07", 9)) == "nul\\u0000bell\\u0007");
+  REQUIRE(escaped("caf\xc3\xa9 \x7f") == "caf\xc3\xa9 \x7f");
+
+  // Exercise every position within and across vector-sized blocks.
+  for (std::size_t at = 0; at < 40; ++at) {
+    std::string text(40, 'a');
+    text[at] = '"';
+    std::string expected(40, 'a');
+    expected.replace(at, 1, "\\\"");
+    REQUIRE(escaped(text) == expected);
+  }
+}
+
+TEST_CASE("json writer inserts separators and pretty-prints shallow levels", "[json]") {
+  std::FILE* file = std::tmpfile();
+  REQUIRE(file != nullptr);
+  {
+    log_sheriff::JsonWriter json(file, 1);
+    json.begin_object();
+    json.key("name").value("a\"b");
+    json.key("count").value(std::uint64_t{3});
+    json.key("delta").value(-2);
+    json.key("ok").value(true);
+    json.key("ratio").value(0.5);
+    json.key("bad").value(std::numeric_limits<double>::infinity());
+    json.key("list").begin_array().value(1).value(2).end_array();
+    json.key("empty").begin_object().end_object();
+    json.end_object().end_record();
+  }
+  REQUIRE(contents(file) == "{\n"
+                            "  \"name\": \"a\\\"b\",\n"
+                            "  \"count\": 3,\n"
+                            "  \"delta\": -2,\n"
+                            "  \"ok\": true,\n"
+                            "  \"ratio\": 0.5,\n"
+                            "  \"bad\": null,\n"
+                            "  \"list\": [1, 2],\n"
+                            "  \"empty\": {}\n"
+                            "}\n");
+  std::fclose(file);
+}
+
+TEST_CASE("json writer emits compact records and flushes large output", "[json]") {
+  std::FILE* file = std::tmpfile();
+  REQUIRE(file != nullptr);
+  log_sheriff::JsonWriter json(file, 0, 64);
+  for (int i = 0; i < 100; ++i) {
+    json.begin_object().key("i").value(i).key("s").value("x y").end_object().end_record();
+  }
+  json.flush();
+
+  const std::string out = contents(file);
+  REQUIRE(out.rfind("{\"i\":0,\"s\":\"x y\"}\n", 0) == 0);
+  REQUIRE(out.find("{\"i\":99,\"s\":\"x y\"}\n") != std::string::npos);
+  std::fclose(file);
+}
+
+TEST_CASE("json writer can append to a string", "[json]") {
+  std::string out = "prefix ";
+  {
+    log_sheriff::JsonWriter json(out);
+    json.begin_array().value(1).value("two").null().end_array();
+    json.flush();
+    REQUIRE(out == "prefix [1,\"two\",null]");
+    json.begin_object().end_object();
+  }
+  REQUIRE(out == "prefix [1,\"two\",null]{}");
+}
@@ -0,0 +1,58 @@
+#include "log_sheriff/mapped_file.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+std::string write_temp_file(std::string_view name, std::string_view content) {
+  const std::filesystem::path path = std::filesystem::temp_directory_path() / std::string{name};
+  std::ofstream out(path, std::ios::binary);
+  out << content;
+  return path.string();
+}
+
+std::string_view view(const log_sheriff::MappedFile& file) { return {file.data().data(), file.size()}; }
+
+}  // namespace
+
+TEST_CASE("mapped files expose the whole file", "[mapped]") {
+  const std::string path = write_temp_file("log_sheriff_mapped.log", "line one\nline two\n");
+  std::optional<log_sheriff::MappedFile> file = log_sheriff::MappedFile::map(path);
+#if !defined(_WIN32)
+  REQUIRE(file.has_value());
+  REQUIRE(view(*file) == "line one\nline two\n");
+
+  log_sheriff::MappedFile moved = std::move(*file);
+  REQUIRE(view(moved) == "line one\nline two\n");
+  REQUIRE(file->size() == 0);
+#endif
+}
+
+TEST_CASE("empty and missing files", "[mapped]") {
+  REQUIRE_FALSE(log_sheriff::MappedFile::map(write_temp_file("log_sheriff_mapped_empty.log", "")).has_value());
+
+  REQUIRE_THROWS_AS(log_sheriff::MappedFile::map("/nonexistent/log-sheriff.log"), std::runtime_error);
+}
+
+#if !defined(_WIN32)
+TEST_CASE("pipes are left unopened for their reader", "[mapped]") {
+  // Opening a pipe without a writer would block; map must not try.
+  const std::filesystem::path fifo = std::filesystem::temp_directory_path() / "log_sheriff_mapped_fifo";
+  std::filesystem::remove(fifo);
+  REQUIRE(::mkfifo(fifo.c_str(), 0600) == 0);
+  REQUIRE_FALSE(log_sheriff::MappedFile::map(fifo.string()).has_value());
+  std::filesystem::remove(fifo);
+}
+#endif
@@ -0,0 +1,159 @@
+#include "log_sheriff/novelty.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+std::string write_temp_log(std::string_view name, std::string_view content) {
+  const std::filesystem::path path = std::filesystem::temp_directory_path() / std::string{name};
+  std::ofstream out(path, std::ios::trunc | std::ios::binary);
+  out << content;
+  return path.string();
+}
+
+}  // namespace
+
+TEST_CASE("novelty detector reports each pattern missing from the baseline once", "[novelty]") {
+  log_sheriff::PatternTable baseline;
+  baseline.add("INFO request <num> ok");
+  const log_sheriff::PatternDictionary dictionary;
+  log_sheriff::SummarizeOptions options;
+  options.level = log_sheriff::LogLevel::Error;
+  log_sheriff::NoveltyDetector detector(options, dictionary, baseline);
+
+  const std::string path = write_temp_log("log_sheriff_novelty.log",
+                                          "ERROR request 1 ok\n"
+                                          "ERROR disk 3 full\n"
+                                          "INFO unseen but filtered out\n"
+                                          "ERROR disk 4 full\n"
+                                          "ERROR no newline");
+  std::vector<log_sheriff::Novelty> found;
+  log_sheriff::watch_novelties(detector, {path}, log_sheriff::WatchOptions{},
+                               [&](const log_sheriff::Novelty& novelty) { found.push_back(novelty); });
+
+  REQUIRE(found.size() == 3);
+  REQUIRE(found[0].pattern == "ERROR request <num> ok");
+  REQUIRE(found[1].pattern == "ERROR disk <num> full");
+  REQUIRE(found[1].offset == 19);
+  REQUIRE(found[1].line == "ERROR disk 3 full");
+  REQUIRE(found[1].source == path);
+  REQUIRE(found[2].line == "ERROR no newline");
+  REQUIRE(detector.lines_checked() == 5);
+  REQUIRE(detector.novel_patterns() == 3);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("following picks up appended lines and finishes split ones", "[novelty]") {
+  const log_sheriff::PatternTable baseline;
+  const std::vector<std::string> owned{"INFO ok"};
+  const std::vector<std::string_view> patterns(owned.begin(), owned.end());
+  const std::vector<std::uint64_t> counts{1};
+  const std::string dictionary_path =
+      write_temp_log("log_sheriff_novelty.lsd", log_sheriff::build_pattern_dictionary(patterns, counts));
+  const log_sheriff::PatternDictionary dictionary(dictionary_path);
+  log_sheriff::NoveltyDetector detector(log_sheriff::SummarizeOptions{}, dictionary, baseline);
+
+  const std::string path = write_temp_log("log_sheriff_follow.log", "INFO ok\nWARN par");
+  std::vector<log_sheriff::Novelty> found;
+  int polls = 0;
+  log_sheriff::WatchOptions options;
+  options.follow = true;
+  options.poll_interval = std::chrono::milliseconds(1);
+  options.stop = [&] {
+    if (polls++ == 0) {
+      std::ofstream(path, std::ios::app | std::ios::binary) << "tial\nINFO ok\n";
+      return false;
+    }
+    return true;
+  };
+  log_sheriff::watch_novelties(detector, {path}, options,
+                               [&](const log_sheriff::Novelty& novelty) { found.push_back(novelty); });
+
+  REQUIRE(found.size() == 1);
+  REQUIRE(found[0].line == "WARN partial");
+  REQUIRE(found[0].offset == 8);
+  std::filesystem::remove(path);
+  std::filesystem::remove(dictionary_path);
+}
+
+TEST_CASE("following survives rotation and a missing file", "[novelty]") {
+  const log_sheriff::PatternTable baseline;
+  const log_sheriff::PatternDictionary dictionary;
+  log_sheriff::NoveltyDetector detector(log_sheriff::SummarizeOptions{}, dictionary, baseline);
+
+  const std::string path = write_temp_log("log_sheriff_follow_rotate.log", "INFO first\nWARN old tail");
+  const std::string rotated = path + ".1";
+  std::vector<log_sheriff::Novelty> found;
+  int polls = 0;
+  log_sheriff::WatchOptions options;
+  options.follow = true;
+  options.poll_interval = std::chrono::milliseconds(1);
+  options.stop = [&] {
+    switch (polls++) {
+      case 0:
+        // Moved away; nothing under the name for one poll.
+        std::filesystem::rename(path, rotated);
+        return false;
+      case 1:
+        // The replacement is larger than the old offset, so its size alone would not tell.
+        write_temp_log("log_sheriff_follow_rotate.log", "ERROR replacement started up fine\n");
+        return false;
+      default:
+        return true;
+    }
+  };
+  log_sheriff::watch_novelties(detector, {path}, options,
+                               [&](const log_sheriff::Novelty& novelty) { found.push_back(novelty); });
+
+  REQUIRE(found.size() == 3);
+  REQUIRE(found[0].line == "INFO first");
+  REQUIRE(found[1].line == "WARN old tail");
+  REQUIRE(found[2].line == "ERROR replacement started up fine");
+  REQUIRE(found[2].offset == 0);
+  std::filesystem::remove(path);
+  std::filesystem::remove(rotated);
+}
+
+TEST_CASE("following reads what the old file got just before rotation", "[novelty]") {
+  const log_sheriff::PatternTable baseline;
+  const log_sheriff::PatternDictionary dictionary;
+  log_sheriff::NoveltyDetector detector(log_sheriff::SummarizeOptions{}, dictionary, baseline);
+
+  const std::string path = write_temp_log("log_sheriff_follow_drain.log", "INFO first\n");
+  const std::string rotated = path + ".1";
+  std::vector<log_sheriff::Novelty> found;
+  int polls = 0;
+  log_sheriff::WatchOptions options;
+  options.follow = true;
+  options.poll_interval = std::chrono::milliseconds(1);
+  options.stop = [&] {
+    if (polls++ == 0) {
+      // Written after the last poll, then rotated away with its replacement already in place.
+      std::ofstream(path, std::ios::app | std::ios::binary) << "ERROR written before rotation\n";
+      std::filesystem::rename(path, rotated);
+      write_temp_log("log_sheriff_follow_drain.log", "WARN replacement\n");
+      // The old file is still written to by a writer that has not reopened yet.
+      std::ofstream(rotated, std::ios::app | std::ios::binary) << "ERROR late write\n";
+      return false;
+    }
+    return true;
+  };
+  log_sheriff::watch_novelties(detector, {path}, options,
+                               [&](const log_sheriff::Novelty& novelty) { found.push_back(novelty); });
+
+  REQUIRE(found.size() == 4);
+  REQUIRE(found[0].line == "INFO first");
+  REQUIRE(found[1].line == "ERROR written before rotation");
+  REQUIRE(found[2].line == "ERROR late write");
+  REQUIRE(found[3].line == "WARN replacement");
+  REQUIRE(found[3].offset == 0);
+  std::filesystem::remove(path);
+  std::filesystem::remove(rotated);
+}
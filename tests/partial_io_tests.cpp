@@ -0,0 +1,236 @@
+#include "log_sheriff/partial_io.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+std::string write_temp_log(std::string_view name_prefix, std::string_view content) {
+  static std::uint64_t counter = 0;
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() /
+      (std::string{name_prefix} + "_" + std::to_string(counter++) + ".log");
+  std::ofstream out(path);
+  out << content;
+  out.close();
+  return path.string();
+}
+
+log_sheriff::SummaryPartial summarize_file(const std::string& path) {
+  log_sheriff::SummarizeOptions options;
+  options.files = {path};
+  const log_sheriff::Summarizer summarizer;
+  return summarizer.summarize_partial(options);
+}
+
+}  // namespace
+
+TEST_CASE("partials survive a serialization round trip", "[partial]") {
+  const std::string path = write_temp_log(
+      "log_sheriff_partial_a",
+      "ERROR db timeout shard=1\n"
+      "ERROR db timeout shard=2\n"
+      "INFO ok\n");
+
+  const log_sheriff::SummaryPartial original = summarize_file(path);
+  const log_sheriff::SummaryPartial decoded =
+      log_sheriff::deserialize_partial(log_sheriff::serialize_partial(original));
+
+  REQUIRE(decoded.files_processed == 1);
+  REQUIRE(decoded.total_lines == 3);
+  REQUIRE(decoded.matched_lines == 3);
+  REQUIRE(decoded.matched_by_level == original.matched_by_level);
+  REQUIRE(decoded.patterns.size() == 2);
+
+  const auto index = decoded.patterns.find("ERROR db timeout shard=<num>");
+  REQUIRE(index.has_value());
+  REQUIRE(decoded.patterns.count(*index) == 2);
+}
+
+TEST_CASE("first and last sightings survive serialization and merge", "[partial]") {
+  const log_sheriff::SummaryPartial early = summarize_file(write_temp_log(
+      "log_sheriff_partial_seen_a", "2026-02-09T18:00:00Z INFO tick\n2026-02-09T18:00:30Z INFO tick\n"));
+  const log_sheriff::SummaryPartial late = summarize_file(
+      write_temp_log("log_sheriff_partial_seen_b", "2026-02-09T19:00:00Z INFO tick\n"));
+
+  log_sheriff::SummaryPartial merged = log_sheriff::deserialize_partial(log_sheriff::serialize_partial(late));
+  log_sheriff::merge(merged, log_sheriff::deserialize_partial(log_sheriff::serialize_partial(early)));
+
+  const log_sheriff::SummaryResult result = log_sheriff::finalize(merged, 1);
+  REQUIRE(result.top_lines[0].count == 3);
+  REQUIRE(*result.top_lines[0].last_seen - *result.top_lines[0].first_seen == 3600);
+}
+
+TEST_CASE("merged partials match summarizing all files at once", "[partial]") {
+  const std::string path1 = write_temp_log(
+      "log_sheriff_partial_b1",
+      "WARN slow request id=1\n"
+      "INFO ok\n");
+  const std::string path2 = write_temp_log(
+      "log_sheriff_partial_b2",
+      "WARN slow request id=2\n"
+      "WARN slow request id=3\n");
+
+  log_sheriff::SummaryPartial merged = summarize_file(path1);
+  log_sheriff::merge(merged, log_sheriff::deserialize_partial(
+                                 log_sheriff::serialize_partial(summarize_file(path2))));
+
+  log_sheriff::SummarizeOptions options;
+  options.files = {path1, path2};
+  const log_sheriff::Summarizer summarizer;
+  const log_sheriff::SummaryResult expected = summarizer.summarize(options);
+  const log_sheriff::SummaryResult actual = log_sheriff::finalize(merged, options.top_n);
+
+  REQUIRE(actual.files_processed == expected.files_processed);
+  REQUIRE(actual.total_lines == expected.total_lines);
+  REQUIRE(actual.matched_by_level == expected.matched_by_level);
+  REQUIRE(actual.top_lines.size() == expected.top_lines.size());
+  REQUIRE(actual.top_lines[0].normalized_line == "WARN slow request id=<num>");
+  REQUIRE(actual.top_lines[0].count == 3);
+}
+
+TEST_CASE("corrupt partials are rejected", "[partial]") {
+  REQUIRE_THROWS_AS(log_sheriff::deserialize_partial("not a partial"), std::runtime_error);
+
+  const std::string bytes = log_sheriff::serialize_partial(summarize_file(
+      write_temp_log("log_sheriff_partial_c", "INFO one\nINFO two\n")));
+  REQUIRE_THROWS_AS(log_sheriff::deserialize_partial(std::string_view{bytes}.substr(0, bytes.size() - 1)),
+                    std::runtime_error);
+}
+
+TEST_CASE("bucketed partials round trip and refuse mismatched widths", "[partial][histogram]") {
+  const std::string path = write_temp_log(
+      "log_sheriff_partial_d",
+      "2026-02-09T18:01:00Z WARN slow id=1\n"
+      "2026-02-09T18:05:00Z WARN slow id=2\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.files = {path};
+  options.bucket_seconds = 60;
+  options.bucket_patterns = true;
+  const log_sheriff::Summarizer summarizer;
+  const log_sheriff::SummaryPartial original = summarizer.summarize_partial(options);
+
+  log_sheriff::SummaryPartial merged;
+  log_sheriff::merge(merged, log_sheriff::deserialize_partial(log_sheriff::serialize_partial(original)));
+  log_sheriff::merge(merged, original);
+
+  const log_sheriff::SummaryResult result = log_sheriff::finalize(merged, 1);
+  REQUIRE(result.bucket_seconds == 60);
+  REQUIRE(result.buckets.size() == 5);
+  REQUIRE(result.buckets.front().by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Warn)] == 2);
+  REQUIRE(result.top_lines[0].buckets == std::vector<std::uint64_t>{2, 0, 0, 0, 2});
+
+  options.bucket_seconds = 30;
+  REQUIRE_THROWS_AS(log_sheriff::merge(merged, summarizer.summarize_partial(options)), std::invalid_argument);
+}
+
+TEST_CASE("group-by tables survive serialization and merge", "[partial][group]") {
+  const std::string path = write_temp_log(
+      "log_sheriff_partial_group",
+      "GET path=/health status=200\n"
+      "GET path=/orders status=500\n"
+      "GET path=/health status=200\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.files = {path};
+  options.group_by = {"path"};
+  options.group_top_n = 2;
+  const log_sheriff::Summarizer summarizer;
+  const log_sheriff::SummaryPartial original = summarizer.summarize_partial(options);
+
+  log_sheriff::SummaryPartial merged = log_sheriff::deserialize_partial(log_sheriff::serialize_partial(original));
+  log_sheriff::merge(merged, original);
+
+  const log_sheriff::SummaryResult result = log_sheriff::finalize(merged, 5, 2);
+  REQUIRE(result.groups.size() == 2);
+  REQUIRE(result.groups[0].values == std::vector<std::string>{"/health"});
+  REQUIRE(result.groups[0].count == 4);
+  REQUIRE(result.groups[0].top_lines[0].count == 4);
+
+  options.group_by = {"status"};
+  REQUIRE_THROWS_AS(log_sheriff::merge(merged, summarizer.summarize_partial(options)), std::invalid_argument);
+}
+
+TEST_CASE("distinct-count sketches survive serialization and merge", "[partial][distinct]") {
+  const std::string first = write_temp_log("log_sheriff_partial_distinct", "GET user=1\nGET user=2\nPUT user=3\n");
+  const std::string second = write_temp_log("log_sheriff_partial_distinct", "GET user=3\nGET user=4\nDELETE user=5\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.distinct_fields = {"user"};
+  const log_sheriff::Summarizer summarizer;
+  options.files = {first};
+  const log_sheriff::SummaryPartial left = summarizer.summarize_partial(options);
+  options.files = {second};
+  const log_sheriff::SummaryPartial right = summarizer.summarize_partial(options);
+
+  log_sheriff::SummaryPartial merged;
+  log_sheriff::merge(merged, log_sheriff::deserialize_partial(log_sheriff::serialize_partial(left)));
+  log_sheriff::merge(merged, log_sheriff::deserialize_partial(log_sheriff::serialize_partial(right)));
+
+  const log_sheriff::SummaryResult result = log_sheriff::finalize(merged, 5);
+  REQUIRE(result.distinct_patterns == 3);
+  REQUIRE(result.distinct_values.size() == 1);
+  REQUIRE(result.distinct_values[0].estimate == 5);
+
+  options.hll_precision = 12;
+  REQUIRE_THROWS_AS(log_sheriff::merge(merged, summarizer.summarize_partial(options)), std::invalid_argument);
+}
+
+TEST_CASE("merging a partial with no files leaves the other side unchanged", "[partial]") {
+  const std::string path = write_temp_log("log_sheriff_partial_empty", "GET user=1\nGET user=2\n");
+  log_sheriff::SummarizeOptions options;
+  options.files = {path};
+  const log_sheriff::Summarizer summarizer;
+  log_sheriff::SummaryPartial merged = summarizer.summarize_partial(options);
+
+  // Every input pruned by time, under options the other side did not use.
+  log_sheriff::SummaryPartial pruned;
+  pruned.distinct_fields = {"x", "y"};
+  pruned.distinct_values.assign(2, log_sheriff::HyperLogLog(pruned.distinct_patterns.precision()));
+  log_sheriff::merge(merged, log_sheriff::deserialize_partial(log_sheriff::serialize_partial(pruned)));
+
+  REQUIRE(merged.files_processed == 1);
+  REQUIRE(merged.total_lines == 2);
+  REQUIRE(merged.distinct_fields.empty());
+  REQUIRE(merged.distinct_values.empty());
+}
+
+TEST_CASE("line samples survive serialization and merge", "[partial][samples]") {
+  const std::string first = write_temp_log("log_sheriff_partial_samples", "ERROR code=1\nERROR code=2\n");
+  const std::string second = write_temp_log("log_sheriff_partial_samples", "INFO ok\nERROR code=3\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.samples_per_pattern = 3;
+  const log_sheriff::Summarizer summarizer;
+  options.files = {first};
+  const log_sheriff::SummaryPartial left = summarizer.summarize_partial(options);
+  options.files = {second};
+  const log_sheriff::SummaryPartial right = summarizer.summarize_partial(options);
+
+  log_sheriff::SummaryPartial merged;
+  log_sheriff::merge(merged, log_sheriff::deserialize_partial(log_sheriff::serialize_partial(left)));
+  log_sheriff::merge(merged, log_sheriff::deserialize_partial(log_sheriff::serialize_partial(right)));
+  REQUIRE(merged.sources == std::vector<std::string>{first, second});
+
+  const log_sheriff::SummaryResult result = log_sheriff::finalize(merged, 5);
+  REQUIRE(result.top_lines[0].count == 3);
+  const std::vector<log_sheriff::LineSample>& samples = result.top_lines[0].samples;
+  REQUIRE(samples.size() == 3);
+  REQUIRE(samples[0].line == "ERROR code=1");
+  REQUIRE(samples[0].source == first);
+  REQUIRE(samples[1].offset == 13);
+  REQUIRE(samples[2].line == "ERROR code=3");
+  REQUIRE(samples[2].source == second);
+  REQUIRE(samples[2].offset == 8);
+
+  options.samples_per_pattern = 1;
+  REQUIRE_THROWS_AS(log_sheriff::merge(merged, summarizer.summarize_partial(options)), std::invalid_argument);
+}
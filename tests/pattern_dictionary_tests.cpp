@@ -0,0 +1,93 @@
+#include "log_sheriff/pattern_dictionary.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::filesystem::path temp_path(std::string_view name_prefix) {
+  static std::uint64_t counter = 0;
+  return std::filesystem::temp_directory_path() / (std::string{name_prefix} + "_" + std::to_string(counter++));
+}
+
+void write_file(const std::filesystem::path& path, std::string_view content) {
+  std::ofstream out(path, std::ios::trunc | std::ios::binary);
+  out << content;
+}
+
+log_sheriff::SummaryPartial partial_of(const std::vector<std::pair<std::string, std::uint64_t>>& patterns) {
+  log_sheriff::SummaryPartial partial;
+  for (const auto& [pattern, count] : patterns) {
+    partial.patterns.add(pattern, count);
+  }
+  return partial;
+}
+
+}  // namespace
+
+TEST_CASE("pattern dictionary finds every pattern it was built from", "[dictionary]") {
+  std::vector<std::string> owned;
+  for (int i = 0; i < 1000; ++i) {
+    owned.push_back("request <num> served by shard " + std::to_string(i));
+  }
+  owned.push_back("");
+  const std::vector<std::string_view> patterns(owned.begin(), owned.end());
+  std::vector<std::uint64_t> counts;
+  for (std::size_t i = 0; i < patterns.size(); ++i) {
+    counts.push_back(i * 3);
+  }
+
+  const std::filesystem::path path = temp_path("log_sheriff_dictionary");
+  write_file(path, log_sheriff::build_pattern_dictionary(patterns, counts));
+  const log_sheriff::PatternDictionary dictionary(path.string());
+  REQUIRE(dictionary.size() == patterns.size());
+  for (std::uint32_t id = 0; id < patterns.size(); ++id) {
+    REQUIRE(dictionary.find(patterns[id]) == id);
+    REQUIRE(dictionary.pattern(id) == patterns[id]);
+    REQUIRE(dictionary.count(id) == counts[id]);
+  }
+  REQUIRE_FALSE(dictionary.find("request <num> served by shard 1000").has_value());
+  REQUIRE_FALSE(log_sheriff::PatternDictionary().find("anything").has_value());
+
+  const std::vector<std::string_view> repeated{"a", "a"};
+  const std::vector<std::uint64_t> two{1, 2};
+  REQUIRE_THROWS_AS(log_sheriff::build_pattern_dictionary(repeated, two), std::invalid_argument);
+  write_file(path, "LSHPDICT truncated");
+  REQUIRE_THROWS_AS(log_sheriff::PatternDictionary(path.string()), std::runtime_error);
+}
+
+TEST_CASE("pattern dictionary keeps IDs stable across runs", "[dictionary]") {
+  const std::filesystem::path path = temp_path("log_sheriff_dictionary_runs");
+  std::filesystem::remove(path);
+
+  const log_sheriff::SummaryPartial first = partial_of({{"ERROR timeout", 5}, {"INFO ok", 2}});
+  log_sheriff::SummaryResult first_result = log_sheriff::finalize(first, 10);
+  log_sheriff::apply_pattern_dictionary(path, first, first_result);
+  REQUIRE(first_result.top_lines[0].pattern_id == 0U);
+  REQUIRE_FALSE(first_result.top_lines[0].previous_count.has_value());
+
+  // A new pattern seen first, and one of the earlier ones missing.
+  const log_sheriff::SummaryPartial second = partial_of({{"WARN slow", 9}, {"INFO ok", 4}});
+  log_sheriff::SummaryResult second_result = log_sheriff::finalize(second, 10);
+  log_sheriff::apply_pattern_dictionary(path, second, second_result);
+  REQUIRE(second_result.top_lines[0].normalized_line == "WARN slow");
+  REQUIRE(second_result.top_lines[0].pattern_id == 2U);
+  REQUIRE_FALSE(second_result.top_lines[0].previous_count.has_value());
+  REQUIRE(second_result.top_lines[1].pattern_id == 1U);
+  REQUIRE(second_result.top_lines[1].previous_count == 2U);
+
+  const log_sheriff::PatternDictionary dictionary(path.string());
+  REQUIRE(dictionary.size() == 3);
+  REQUIRE(dictionary.find("ERROR timeout") == 0U);
+  REQUIRE(dictionary.count(0) == 0);
+  REQUIRE(dictionary.count(1) == 4);
+  REQUIRE(dictionary.count(2) == 9);
+}
@@ -0,0 +1,217 @@
+#include "log_sheriff/query_server.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <latch>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::string write_temp_log(std::string_view name_prefix, std::string_view content) {
+  static std::uint64_t counter = 0;
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() /
+      (std::string{name_prefix} + "_" + std::to_string(counter++) + ".log");
+  std::ofstream out(path);
+  out << content;
+  out.close();
+  return path.string();
+}
+
+bool contains(std::string_view haystack, std::string_view needle) { return haystack.find(needle) != std::string_view::npos; }
+
+#if !defined(_WIN32)
+// Connects to the socket at `path`, retrying while the server is still starting; -1 on failure.
+int connect_client(const std::string& path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  for (int attempt = 0; attempt < 200; ++attempt) {
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0) {
+      // A server that never answers fails the test instead of hanging it.
+      timeval timeout{};
+      timeout.tv_sec = 5;
+      ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      return fd;
+    }
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return -1;
+}
+
+std::string ask(int fd, std::string_view requests, std::size_t responses) {
+  ::send(fd, requests.data(), requests.size(), 0);
+  std::string out;
+  char buffer[4096];
+  while (static_cast<std::size_t>(std::count(out.begin(), out.end(), '\n')) < responses) {
+    const ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+    if (received <= 0) {
+      break;
+    }
+    out.append(buffer, static_cast<std::size_t>(received));
+  }
+  return out;
+}
+#endif
+
+}  // namespace
+
+TEST_CASE("queries map onto summarize options", "[serve]") {
+  const log_sheriff::SummarizeOptions options = log_sheriff::parse_query(log_sheriff::parse_json(
+      R"({"op": "summarize", "files": ["a.log"], "level": "ERROR", "top": 3, "bucket": "1m",
+          "group_by": ["shard"], "samples": 2, "bucket_patterns": true})"));
+  REQUIRE(options.files == std::vector<std::string>{"a.log"});
+  REQUIRE(options.level == log_sheriff::LogLevel::Error);
+  REQUIRE(options.top_n == 3);
+  REQUIRE(options.bucket_seconds == 60);
+  REQUIRE(options.group_by == std::vector<std::string>{"shard"});
+  REQUIRE(options.samples_per_pattern == 2);
+  REQUIRE(options.bucket_patterns);
+
+  for (const std::string bad : {R"([])", R"({})", R"({"files": []})", R"({"files": "a.log"})",
+                                R"({"files": ["a"], "top": 0})", R"({"files": ["a"], "top": 1.5})",
+                                R"({"files": ["a"], "level": "loud"})", R"({"files": ["a"], "colour": 1})",
+                                R"({"files": ["a"], "op": "delete"})"}) {
+    INFO(bad);
+    REQUIRE_THROWS_AS(log_sheriff::parse_query(log_sheriff::parse_json(bad)), std::invalid_argument);
+  }
+}
+
+TEST_CASE("query engine caches per-file partials until the file changes", "[serve]") {
+  const std::string path = write_temp_log("log_sheriff_serve", "ERROR timeout shard=1\nINFO ok\n");
+  const std::string request = R"({"files": [")" + path + R"("], "level": "error"})";
+
+  log_sheriff::QueryEngine engine;
+  const std::string first = engine.handle(request);
+  REQUIRE(contains(first, "\"matched_lines\":1,"));
+  REQUIRE(contains(first, "\"line\":\"ERROR timeout shard=<num>\",\"count\":1"));
+
+  // Only `top` differs: answered from the cached partial.
+  REQUIRE(engine.handle(R"({"files": [")" + path + R"("], "level": "error", "top": 1})") == first);
+  log_sheriff::QueryEngine::Stats stats = engine.stats();
+  REQUIRE(stats.partial_misses == 1);
+  REQUIRE(stats.partial_hits == 1);
+
+  // Other filters need a new partial.
+  REQUIRE(contains(engine.handle(R"({"files": [")" + path + R"("]})"), "\"matched_lines\":2,"));
+  REQUIRE(engine.stats().cached_partials == 2);
+
+  std::ofstream(path, std::ios::app) << "ERROR timeout shard=2\n";
+  REQUIRE(contains(engine.handle(request), "\"matched_lines\":2,"));
+  stats = engine.stats();
+  REQUIRE(stats.partial_misses == 3);
+  REQUIRE(stats.queries == 4);
+  REQUIRE(contains(engine.handle(R"({"op": "stats"})"), "\"partial_hits\":1,"));
+}
+
+TEST_CASE("query engine re-reads a file truncated in place", "[serve]") {
+  const std::string path = write_temp_log("log_sheriff_serve_truncate", "ERROR one\nERROR two\nERROR three\n");
+  const std::string request = R"({"files": [")" + path + R"("]})";
+
+  log_sheriff::QueryEngine engine;
+  REQUIRE(contains(engine.handle(request), "\"matched_lines\":3,"));
+  std::ofstream(path, std::ios::trunc) << "ERROR four\n";
+  REQUIRE(contains(engine.handle(request), "\"matched_lines\":1,"));
+  REQUIRE(engine.stats().partial_misses == 2);
+}
+
+TEST_CASE("query engine answers the same query from several threads at once", "[serve]") {
+  std::string content;
+  for (int i = 0; i < 200; ++i) {
+    content += "ERROR timeout user=" + std::to_string(i) + " shard=" + std::to_string(i % 7) + "\n";
+  }
+  const std::string path = write_temp_log("log_sheriff_serve_concurrent", content);
+  const std::string request =
+      R"({"files": [")" + path + R"(", ")" + path + R"("], "distinct_fields": ["user"], "group_by": ["shard"]})";
+
+  log_sheriff::QueryEngine engine;
+  const std::string expected = log_sheriff::QueryEngine().handle(request);
+  REQUIRE(contains(expected, "\"matched_lines\":400,"));
+
+  // The threads start together, so they merge cached partials that no other thread has read yet.
+  std::vector<std::string> responses(4);
+  std::latch start(static_cast<std::ptrdiff_t>(responses.size()));
+  std::vector<std::thread> clients;
+  for (std::size_t i = 0; i < responses.size(); ++i) {
+    clients.emplace_back([&engine, &request, &responses, &start, i] {
+      start.arrive_and_wait();
+      for (int round = 0; round < 5; ++round) {
+        responses[i] = engine.handle(request);
+      }
+    });
+  }
+  for (std::thread& client : clients) {
+    client.join();
+  }
+  for (const std::string& response : responses) {
+    REQUIRE(response == expected);
+  }
+  REQUIRE(engine.stats().queries == 20);
+  REQUIRE(engine.stats().cached_partials == 1);
+}
+
+TEST_CASE("query engine reports failures as error responses", "[serve]") {
+  log_sheriff::QueryEngine engine({1});
+  REQUIRE(contains(engine.handle("{not json"), "{\"error\":\"invalid JSON at offset 1"));
+  REQUIRE(contains(engine.handle(R"({"files": ["/nonexistent/log-sheriff.log"]})"), "\"error\":\"failed to open file"));
+  REQUIRE(contains(engine.handle(R"({"files": ["x"], "since": "yesterday"})"), "invalid --since timestamp"));
+
+  // A limit of one evicts older entries.
+  const std::string first = write_temp_log("log_sheriff_serve_lru", "a\n");
+  const std::string second = write_temp_log("log_sheriff_serve_lru", "b\n");
+  engine.handle(R"({"files": [")" + first + R"(", ")" + second + R"("]})");
+  REQUIRE(engine.stats().cached_partials == 1);
+}
+
+#if !defined(_WIN32)
+TEST_CASE("idle connections do not keep other clients waiting for a worker", "[serve]") {
+  const std::string log = write_temp_log("log_sheriff_serve_socket", "ERROR one\nERROR two\n");
+  const std::string socket_path =
+      (std::filesystem::temp_directory_path() / ("log_sheriff_test_" + std::to_string(::getpid()) + ".sock")).string();
+
+  log_sheriff::QueryEngine engine;
+  std::thread server([&] { log_sheriff::serve_unix_socket(socket_path, engine, 1); });
+
+  // With a single worker, two connected but silent clients must not block a third.
+  const int idle_first = connect_client(socket_path);
+  const int idle_second = connect_client(socket_path);
+  const int active = connect_client(socket_path);
+  REQUIRE(idle_first >= 0);
+  REQUIRE(idle_second >= 0);
+  REQUIRE(active >= 0);
+  ::send(idle_first, "{\"op\":", 6, 0);
+
+  // Two requests in one write, plus a blank line: answered in order.
+  const std::string responses = ask(active, "{\"files\": [\"" + log + "\"]}\n\n{\"op\": \"stats\"}\n", 2);
+  REQUIRE(contains(responses, "\"matched_lines\":2,"));
+  REQUIRE(contains(responses.substr(responses.find('\n') + 1), "\"queries\":2,"));
+  REQUIRE(contains(ask(idle_second, "{\"op\": \"stats\"}\n", 1), "\"queries\":3,"));
+
+  ::close(idle_first);
+  ::close(idle_second);
+  ::close(active);
+  std::raise(SIGTERM);
+  server.join();
+  REQUIRE_FALSE(std::filesystem::exists(socket_path));
+}
+#endif
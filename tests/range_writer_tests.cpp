@@ -0,0 +1,193 @@
+#include "log_sheriff/range_writer.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+std::string contents(std::FILE* file) {
+  std::rewind(file);
+  std::string out;
+  char buffer[256];
+  std::size_t read = 0;
+  while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    out.append(buffer, read);
+  }
+  return out;
+}
+
+std::span<const char> bytes(std::string_view text) { return {text.data(), text.size()}; }
+
+}  // namespace
+
+TEST_CASE("range writer writes queued ranges in order", "[emit]") {
+  std::FILE* file = std::tmpfile();
+  REQUIRE(file != nullptr);
+  const std::string data = "abcdefgh";
+  {
+    log_sheriff::RangeWriter out(fileno(file));
+    out.add(bytes(std::string_view(data).substr(0, 2)));
+    out.add(bytes(std::string_view(data).substr(2, 2)));  // adjacent: merged with the previous range
+    out.add(bytes(std::string_view(data).substr(6, 2)));
+    // More ranges than one batch holds.
+    for (std::size_t i = 0; i < log_sheriff::RangeWriter::kMaxPending + 10; ++i) {
+      out.add(bytes(std::string_view(data).substr(i % 2 == 0 ? 0 : 4, 1)));
+    }
+    out.flush();
+  }
+
+  const std::string written = contents(file);
+  REQUIRE(written.substr(0, 6) == "abcdgh");
+  REQUIRE(written.size() == 6 + log_sheriff::RangeWriter::kMaxPending + 10);
+  REQUIRE(written.substr(6, 4) == "aeae");
+  std::fclose(file);
+}
+
+TEST_CASE("matching lines are emitted with their newlines", "[emit]") {
+  log_sheriff::SummarizeOptions options;
+  options.contains = "ERROR";
+  const log_sheriff::LineFilter filter(options);
+  const std::string data =
+      "INFO ok\n"
+      "ERROR one\n"
+      "ERROR two\n"
+      "WARN meh\n"
+      "ERROR last without newline";
+
+  std::FILE* file = std::tmpfile();
+  REQUIRE(file != nullptr);
+  {
+    log_sheriff::RangeWriter out(fileno(file));
+    REQUIRE(log_sheriff::emit_matching_lines(bytes(data), filter, &out) == 3);
+  }
+  REQUIRE(contents(file) == "ERROR one\nERROR two\nERROR last without newline\n");
+  std::fclose(file);
+
+  REQUIRE(log_sheriff::emit_matching_lines(bytes(data), filter, nullptr) == 3);
+  REQUIRE(log_sheriff::emit_matching_lines(bytes(""), filter, nullptr) == 0);
+}
+
+TEST_CASE("matching lines of several inputs are emitted in time order", "[emit]") {
+  log_sheriff::SummarizeOptions options;
+  options.level = log_sheriff::LogLevel::Error;
+  const log_sheriff::LineFilter filter(options);
+  const std::string pod_a =
+      "2026-02-09T18:01:00Z ERROR a1\n"
+      "2026-02-09T18:01:04Z ERROR a2";
+  const std::string pod_b =
+      "2026-02-09T18:01:02Z ERROR b1\n"
+      "2026-02-09T18:01:03Z INFO b2\n";
+
+  std::FILE* file = std::tmpfile();
+  REQUIRE(file != nullptr);
+  {
+    log_sheriff::RangeWriter out(fileno(file));
+    REQUIRE(log_sheriff::emit_matching_lines_by_time({bytes(pod_a), bytes(pod_b)}, filter, &out) == 3);
+  }
+  REQUIRE(contents(file) ==
+          "2026-02-09T18:01:00Z ERROR a1\n2026-02-09T18:01:02Z ERROR b1\n2026-02-09T18:01:04Z ERROR a2\n");
+  std::fclose(file);
+}
+
+TEST_CASE("files merged in time order may be empty or unmappable", "[emit]") {
+  const log_sheriff::LineFilter filter{log_sheriff::SummarizeOptions{}};
+  const std::filesystem::path directory = std::filesystem::temp_directory_path();
+  const std::filesystem::path pod_a = directory / "log_sheriff_emit_time_a.log";
+  const std::filesystem::path empty = directory / "log_sheriff_emit_time_empty.log";
+  std::ofstream(pod_a, std::ios::binary) << "2026-02-09T18:01:00Z ERROR a1\n2026-02-09T18:01:04Z ERROR a2\n";
+  std::ofstream(empty, std::ios::binary).flush();
+  std::vector<std::string> paths{pod_a.string(), empty.string()};
+
+#if !defined(_WIN32)
+  // A pipe cannot be mapped, so it is read into memory.
+  const std::filesystem::path fifo = directory / "log_sheriff_emit_time_fifo";
+  std::filesystem::remove(fifo);
+  REQUIRE(::mkfifo(fifo.c_str(), 0600) == 0);
+  std::thread writer([&fifo] { std::ofstream(fifo, std::ios::binary) << "2026-02-09T18:01:02Z ERROR b1\n"; });
+  paths.push_back(fifo.string());
+#endif
+
+  std::FILE* file = std::tmpfile();
+  REQUIRE(file != nullptr);
+  std::uint64_t matched = 0;
+  {
+    log_sheriff::RangeWriter out(fileno(file));
+    matched = log_sheriff::emit_matching_file_lines_by_time(paths, filter, &out);
+  }
+#if !defined(_WIN32)
+  writer.join();
+  std::filesystem::remove(fifo);
+  REQUIRE(matched == 3);
+  REQUIRE(contents(file) ==
+          "2026-02-09T18:01:00Z ERROR a1\n2026-02-09T18:01:02Z ERROR b1\n2026-02-09T18:01:04Z ERROR a2\n");
+#else
+  REQUIRE(matched == 2);
+#endif
+  std::fclose(file);
+  std::filesystem::remove(pod_a);
+  std::filesystem::remove(empty);
+  REQUIRE_THROWS_AS(
+      log_sheriff::emit_matching_file_lines_by_time({"/nonexistent/log-sheriff.log"}, filter, nullptr),
+      std::runtime_error);
+}
+
+TEST_CASE("matching lines of a file are emitted whether it is mapped or read in blocks", "[emit]") {
+  log_sheriff::SummarizeOptions options;
+  options.contains = "ERROR";
+  const log_sheriff::LineFilter filter(options);
+  // Enough lines of uneven length that some straddle the 64 KiB read blocks.
+  std::string data;
+  std::string expected;
+  for (int i = 0; i < 20000; ++i) {
+    const std::string line = (i % 3 == 0 ? "ERROR " : "INFO ") + std::string(static_cast<std::size_t>(i % 17), 'x') +
+                             std::to_string(i);
+    data += line + '\n';
+    if (i % 3 == 0) {
+      expected += line + '\n';
+    }
+  }
+  data += "ERROR tail";
+  expected += "ERROR tail\n";
+
+  const std::filesystem::path path = std::filesystem::temp_directory_path() / "log_sheriff_emit_file.log";
+  std::ofstream(path, std::ios::binary) << data;
+  std::FILE* file = std::tmpfile();
+  REQUIRE(file != nullptr);
+  {
+    log_sheriff::RangeWriter out(fileno(file));
+    REQUIRE(log_sheriff::emit_matching_file_lines(path.string(), filter, &out) == 6668);
+  }
+  REQUIRE(contents(file) == expected);
+  std::fclose(file);
+
+#if !defined(_WIN32)
+  // A pipe cannot be mapped, so it is read in blocks.
+  const std::filesystem::path fifo = std::filesystem::temp_directory_path() / "log_sheriff_emit_fifo";
+  std::filesystem::remove(fifo);
+  REQUIRE(::mkfifo(fifo.c_str(), 0600) == 0);
+  std::thread writer([&fifo, &data] { std::ofstream(fifo, std::ios::binary) << data; });
+  file = std::tmpfile();
+  REQUIRE(file != nullptr);
+  {
+    log_sheriff::RangeWriter out(fileno(file));
+    REQUIRE(log_sheriff::emit_matching_file_lines(fifo.string(), filter, &out) == 6668);
+  }
+  writer.join();
+  REQUIRE(contents(file) == expected);
+  std::fclose(file);
+  std::filesystem::remove(fifo);
+#endif
+}
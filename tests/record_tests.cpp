@@ -0,0 +1,122 @@
+#include "log_sheriff/record.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <ctime>
+
+TEST_CASE("text records scan the whole line", "[record]") {
+  log_sheriff::Record record;
+  record.parse("2026-02-09T18:01:03Z INFO retry after error shard=3");
+
+  REQUIRE(record.message() == record.line());
+  REQUIRE(record.timestamp() == 1770660063);
+  // The token after the timestamp decides the level, not keywords later in the line.
+  REQUIRE(record.level() == log_sheriff::LogLevel::Info);
+  REQUIRE(record.has_level(log_sheriff::LogLevel::Info));
+  REQUIRE_FALSE(record.has_level(log_sheriff::LogLevel::Error));
+  REQUIRE(record.field("shard") == "3");
+
+  record.parse("2026-02-09 18:01:03 [Warning] disk info stale");
+  REQUIRE(record.level() == log_sheriff::LogLevel::Warn);
+  record.parse("2026-02-09T18:01:03Z error: disk full");
+  REQUIRE(record.level() == log_sheriff::LogLevel::Error);
+
+  // Without a level token the whole line is searched for keywords.
+  record.parse("2026-02-09T18:01:03Z worker info and debug output");
+  REQUIRE(record.level() == log_sheriff::LogLevel::Info);
+  REQUIRE(record.has_level(log_sheriff::LogLevel::Debug));
+  record.parse("ERROR no timestamp, warn later");
+  REQUIRE(record.level() == log_sheriff::LogLevel::Error);
+  REQUIRE(record.has_level(log_sheriff::LogLevel::Warn));
+
+  const auto prefix = log_sheriff::parse_timestamp_prefix("2026-02-09 18:01:03 rest");
+  REQUIRE(prefix.has_value());
+  REQUIRE(prefix->length == 19);
+  REQUIRE_FALSE(log_sheriff::parse_timestamp("2026-02-09T18:01:03Z trailing").has_value());
+}
+
+TEST_CASE("json records read the level, time and message members", "[record]") {
+  log_sheriff::Record record(log_sheriff::InputFormat::JsonLines);
+  record.parse(R"({"time": "2026-02-09T18:01:03.250Z", "level": "WARNING", "msg": "slow id=7", "id": 7,)"
+               R"( "note": "error budget"})");
+
+  REQUIRE(record.message() == "slow id=7");
+  REQUIRE(record.timestamp() == 1770660063);
+  REQUIRE(record.level() == log_sheriff::LogLevel::Warn);
+  // The word "error" elsewhere in the object does not make the line an error.
+  REQUIRE_FALSE(record.has_level(log_sheriff::LogLevel::Error));
+  REQUIRE(record.field("id") == "7");
+  REQUIRE_FALSE(record.field("msg=slow").has_value());
+
+  record.parse(R"({"ts": 1770660063500, "severity": "fatal", "message": "down"})");
+  REQUIRE(record.timestamp() == 1770660063);
+  REQUIRE(record.level() == log_sheriff::LogLevel::Error);
+  REQUIRE(record.message() == "down");
+
+  record.parse(R"({"event": "no level or time"})");
+  REQUIRE_FALSE(record.level().has_value());
+  REQUIRE_FALSE(record.timestamp().has_value());
+  REQUIRE(record.message() == record.line());
+
+  // Lines that are not JSON objects fall back to text.
+  record.parse("2026-02-09T18:01:03Z ERROR plain shard=1");
+  REQUIRE(record.level() == log_sheriff::LogLevel::Error);
+  REQUIRE(record.field("shard") == "1");
+
+  REQUIRE(log_sheriff::parse_input_format("JSON") == log_sheriff::InputFormat::JsonLines);
+  REQUIRE_FALSE(log_sheriff::parse_input_format("xml").has_value());
+}
+
+TEST_CASE("logfmt and syslog records read their level, time and message", "[record]") {
+  log_sheriff::Record logfmt(log_sheriff::InputFormat::Logfmt);
+  logfmt.parse(R"(ts=2026-02-09T20:01:03.5+02:00 level=warning msg="slow query" shard=3 note=error)");
+  REQUIRE(logfmt.message() == "slow query");
+  REQUIRE(logfmt.timestamp() == 1770660063);
+  REQUIRE(logfmt.level() == log_sheriff::LogLevel::Warn);
+  REQUIRE_FALSE(logfmt.has_level(log_sheriff::LogLevel::Error));
+  REQUIRE(logfmt.field("shard") == "3");
+
+  log_sheriff::Record syslog(log_sheriff::InputFormat::Syslog);
+  syslog.parse(R"(<11>1 2026-02-09T18:01:03.003Z web01 api 4242 ID47 [meta id="a]b" shard="3"] disk full)");
+  REQUIRE(syslog.kind() == log_sheriff::InputFormat::Syslog);
+  REQUIRE(syslog.message() == "disk full");
+  REQUIRE(syslog.timestamp() == 1770660063);
+  REQUIRE(syslog.level() == log_sheriff::LogLevel::Error);
+  REQUIRE(syslog.field("shard") == "3");
+
+  syslog.parse("<190>1 - host app - - - info only in text");
+  REQUIRE(syslog.level() == log_sheriff::LogLevel::Info);
+  REQUIRE_FALSE(syslog.timestamp().has_value());
+  REQUIRE(syslog.message() == "info only in text");
+
+  // RFC 3164 has no year; the timestamp lands within the last year.
+  syslog.parse("<12>Feb  9 18:01:03 web01 sshd[42]: retrying after error");
+  REQUIRE(syslog.message() == "sshd[42]: retrying after error");
+  REQUIRE(syslog.level() == log_sheriff::LogLevel::Warn);
+  REQUIRE(syslog.timestamp().has_value());
+  REQUIRE(*syslog.timestamp() <= std::time(nullptr) + 86400);
+  REQUIRE(*syslog.timestamp() > std::time(nullptr) - 367 * 86400);
+
+  // Without a priority the level comes from keywords in the message.
+  syslog.parse("Feb 19 08:00:00 web01 kernel: DEBUG probe");
+  REQUIRE(syslog.level() == log_sheriff::LogLevel::Debug);
+
+  syslog.parse("not syslog error");
+  REQUIRE(syslog.kind() == log_sheriff::InputFormat::Text);
+  REQUIRE(syslog.level() == log_sheriff::LogLevel::Error);
+}
+
+TEST_CASE("auto records pick the format from each line", "[record]") {
+  using log_sheriff::InputFormat;
+  log_sheriff::Record record(InputFormat::Auto);
+  REQUIRE(record.parse(R"({"level": "info"})").kind() == InputFormat::JsonLines);
+  REQUIRE(record.parse("<34>Oct 11 22:14:15 mymachine su: failed").kind() == InputFormat::Syslog);
+  REQUIRE(record.parse("Oct 11 22:14:15 mymachine su: failed").kind() == InputFormat::Syslog);
+  REQUIRE(record.parse("level=info msg=ok").kind() == InputFormat::Logfmt);
+  REQUIRE(record.parse("2026-02-09T18:01:03Z INFO a=b").kind() == InputFormat::Text);
+  REQUIRE(record.parse("{not json").kind() == InputFormat::Text);
+  REQUIRE(record.format() == InputFormat::Auto);
+
+  REQUIRE(log_sheriff::parse_input_format("logfmt") == InputFormat::Logfmt);
+  REQUIRE(log_sheriff::input_format_name(InputFormat::Auto) == "auto");
+}
@@ -0,0 +1,93 @@
+#include "log_sheriff/reservoir.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("reservoir keeps every line until it is full", "[reservoir]") {
+  log_sheriff::ReservoirSampler sampler(3);
+  sampler.offer(0, "b", 0, 20);
+  sampler.offer(0, "a", 0, 10);
+  sampler.offer(1, "x", 1, 5);
+
+  const auto samples = sampler.samples(0);
+  REQUIRE(samples.size() == 2);
+  REQUIRE(samples[0].line == "a");
+  REQUIRE(samples[0].offset == 10);
+  REQUIRE(samples[1].line == "b");
+  REQUIRE(sampler.samples(1).size() == 1);
+  REQUIRE(sampler.samples(1)[0].source == 1);
+  REQUIRE(sampler.samples(7).empty());
+
+  log_sheriff::ReservoirSampler disabled;
+  disabled.offer(0, "a", 0, 0);
+  REQUIRE(disabled.keys() == 0);
+  REQUIRE_THROWS_AS(log_sheriff::ReservoirSampler(log_sheriff::ReservoirSampler::kMaxPerKey + 1),
+                    std::invalid_argument);
+}
+
+TEST_CASE("reservoir samples are roughly uniform and memory stays bounded", "[reservoir]") {
+  constexpr int kLines = 100;
+  constexpr int kRounds = 2000;
+  std::vector<int> hits(kLines, 0);
+  log_sheriff::ReservoirSampler sampler(5);
+  for (int round = 0; round < kRounds; ++round) {
+    for (int i = 0; i < kLines; ++i) {
+      sampler.offer(static_cast<std::size_t>(round), "line-" + std::to_string(i), 0, static_cast<std::uint64_t>(i));
+    }
+    for (const auto& sample : sampler.samples(static_cast<std::size_t>(round))) {
+      ++hits[sample.offset];
+    }
+  }
+
+  // Each line is expected in 5% of the rounds (100 hits); allow a wide band around it.
+  for (const int count : hits) {
+    REQUIRE(count > 50);
+    REQUIRE(count < 160);
+  }
+
+  log_sheriff::ReservoirSampler bounded(2);
+  const std::string long_line(4 * log_sheriff::ReservoirSampler::kMaxLineBytes, 'x');
+  for (int i = 0; i < 100000; ++i) {
+    bounded.offer(0, long_line, 0, static_cast<std::uint64_t>(i));
+  }
+  REQUIRE(bounded.seen(0) == 100000);
+  REQUIRE(bounded.samples(0)[0].line.size() == log_sheriff::ReservoirSampler::kMaxLineBytes);
+  REQUIRE(bounded.arena_bytes() <= 256 * 1024);
+}
+
+TEST_CASE("reservoir merge keeps a sample of both sides", "[reservoir]") {
+  log_sheriff::ReservoirSampler left(4);
+  log_sheriff::ReservoirSampler right(4);
+  left.offer(0, "left-a", 0, 0);
+  left.offer(0, "left-b", 0, 10);
+  for (int i = 0; i < 50; ++i) {
+    right.offer(0, "right-" + std::to_string(i), 0, static_cast<std::uint64_t>(i));
+  }
+  right.offer(1, "other", 0, 0);
+
+  // Right's key 0 is left's key 0, its key 1 becomes key 2; its source 0 is left's source 1.
+  const std::vector<std::size_t> keys{0, 2};
+  const std::vector<std::uint32_t> sources{1};
+  left.merge(right, keys, sources);
+
+  REQUIRE(left.seen(0) == 52);
+  REQUIRE(left.samples(0).size() == 4);
+  std::set<std::string> lines;
+  for (const auto& sample : left.samples(0)) {
+    lines.emplace(sample.line);
+    REQUIRE(sample.source == (sample.line.starts_with("left") ? 0U : 1U));
+  }
+  REQUIRE(lines.size() == 4);
+  REQUIRE(left.seen(1) == 0);
+  REQUIRE(left.samples(2).size() == 1);
+  REQUIRE(left.samples(2)[0].line == "other");
+
+  log_sheriff::ReservoirSampler wider(8);
+  wider.offer(0, "a", 0, 0);
+  REQUIRE_THROWS_AS(left.merge(wider, keys, sources), std::invalid_argument);
+}
@@ -0,0 +1,151 @@
+#include "log_sheriff/result_cache.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+std::filesystem::path temp_path(std::string_view name_prefix) {
+  static std::uint64_t counter = 0;
+  return std::filesystem::temp_directory_path() / (std::string{name_prefix} + "_" + std::to_string(counter++));
+}
+
+void write_file(const std::filesystem::path& path, std::string_view content, bool append = false) {
+  std::ofstream out(path, append ? std::ios::app | std::ios::binary : std::ios::trunc | std::ios::binary);
+  out << content;
+}
+
+log_sheriff::SummaryResult summarize(log_sheriff::ResultCache& cache, const log_sheriff::SummarizeOptions& options) {
+  return log_sheriff::finalize(cache.summarize_partial(options), options.top_n);
+}
+
+}  // namespace
+
+TEST_CASE("result cache reuses unchanged files and reads only appended bytes", "[cache]") {
+  const std::filesystem::path directory = temp_path("log_sheriff_cache_dir");
+  const std::filesystem::path log = temp_path("log_sheriff_cache_log");
+  write_file(log, "ERROR timeout shard=1\nINFO ok\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.files = {log.string()};
+  options.samples_per_pattern = 1;
+
+  log_sheriff::ResultCache cache(directory);
+  REQUIRE(summarize(cache, options).matched_lines == 2);
+  REQUIRE(cache.stats().misses == 1);
+
+  // A second cache over the same directory finds the entry on disk.
+  log_sheriff::ResultCache reopened(directory);
+  const log_sheriff::SummaryResult again = summarize(reopened, options);
+  REQUIRE(reopened.stats().hits == 1);
+  REQUIRE(again.matched_lines == 2);
+  REQUIRE(again.top_lines.front().samples.front().source == log.string());
+
+  // Other filters get their own entry.
+  options.level = log_sheriff::LogLevel::Error;
+  REQUIRE(summarize(reopened, options).matched_lines == 1);
+  REQUIRE(reopened.stats().misses == 1);
+  options.level.reset();
+
+  write_file(log, "ERROR timeout shard=2\n", true);
+  const log_sheriff::SummaryResult appended = summarize(reopened, options);
+  REQUIRE(reopened.stats().appends == 1);
+  REQUIRE(appended.files_processed == 1);
+  REQUIRE(appended.total_lines == 3);
+  REQUIRE(appended.top_lines.front().normalized_line == "ERROR timeout shard=<num>");
+  REQUIRE(appended.top_lines.front().count == 2);
+  REQUIRE(appended.top_lines.front().samples.size() == 1);
+
+  const log_sheriff::SummaryResult fresh = log_sheriff::Summarizer{}.summarize(options);
+  REQUIRE(fresh.total_lines == appended.total_lines);
+  REQUIRE(fresh.matched_by_level == appended.matched_by_level);
+  REQUIRE(fresh.distinct_patterns == appended.distinct_patterns);
+
+  std::filesystem::remove_all(directory);
+  std::filesystem::remove(log);
+}
+
+TEST_CASE("result cache resumes held-back lines and re-reads rewritten or rotated files", "[cache]") {
+  const std::filesystem::path directory = temp_path("log_sheriff_cache_dir");
+  const std::filesystem::path log = temp_path("log_sheriff_cache_log");
+  log_sheriff::SummarizeOptions options;
+  options.files = {log.string()};
+  log_sheriff::ResultCache cache(directory);
+
+  write_file(log, "INFO a\nINFO b\n");
+  summarize(cache, options);
+
+  // Same size, different leading bytes.
+  write_file(log, "WARN a\nINFO bb");
+  REQUIRE(summarize(cache, options).matched_by_level[1] == 1);
+  REQUIRE(cache.stats().misses == 2);
+
+  // The checkpoint held back the unterminated line, so the appended bytes complete it.
+  write_file(log, "b\n", true);
+  const log_sheriff::SummaryResult completed = summarize(cache, options);
+  REQUIRE(cache.stats().appends == 1);
+  REQUIRE(completed.total_lines == 2);
+  REQUIRE(completed.top_lines.size() == 2);
+
+  // A replacement file has a new inode even when it grew.
+  const std::filesystem::path rotated = temp_path("log_sheriff_cache_log");
+  write_file(rotated, "INFO a\nINFO bbb\nINFO c\n");
+  std::filesystem::rename(rotated, log);
+  REQUIRE(summarize(cache, options).total_lines == 3);
+  REQUIRE(cache.stats().appends == 1);
+  REQUIRE(cache.stats().misses == 3);
+
+  // Corrupt entries are ignored and replaced.
+  for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+    write_file(entry.path(), "LSHCACHE garbage");
+  }
+  REQUIRE(summarize(cache, options).total_lines == 3);
+  REQUIRE(cache.stats().misses == 4);
+  REQUIRE(summarize(cache, options).total_lines == 3);
+  REQUIRE(cache.stats().hits == 1);
+
+  std::filesystem::remove_all(directory);
+  std::filesystem::remove(log);
+}
+
+TEST_CASE("result cache prunes and counts files like a plain summarize", "[cache]") {
+  const std::filesystem::path directory = temp_path("log_sheriff_cache_dir");
+  const std::filesystem::path recent = temp_path("log_sheriff_cache_recent");
+  const std::filesystem::path stale = temp_path("log_sheriff_cache_stale");
+  const std::filesystem::path empty = temp_path("log_sheriff_cache_empty");
+  write_file(recent, "2026-02-09T18:01:00Z ERROR timeout\n");
+  write_file(stale, "2026-02-09T18:01:30Z ERROR stale\n");
+  std::filesystem::last_write_time(stale, std::filesystem::last_write_time(stale) - std::chrono::hours(24 * 400));
+  write_file(empty, "");
+
+  log_sheriff::SummarizeOptions options;
+  options.files = {recent.string(), stale.string(), empty.string()};
+  options.since = "2026-02-09T18:00:00Z";
+  options.distinct_fields = {"user"};
+  log_sheriff::ResultCache cache(directory);
+  const log_sheriff::SummaryResult cached = summarize(cache, options);
+  const log_sheriff::SummaryResult plain = log_sheriff::Summarizer{}.summarize(options);
+  REQUIRE(cached.files_processed == 2);
+  REQUIRE(cached.files_processed == plain.files_processed);
+  REQUIRE(cached.total_lines == plain.total_lines);
+  REQUIRE(cached.matched_lines == 1);
+  // Only the recent file was read: one miss for it, one for the empty file.
+  REQUIRE(cache.stats().misses == 2);
+
+  // With every file pruned, the result still reflects the options.
+  options.files = {stale.string()};
+  const log_sheriff::SummaryResult none = summarize(cache, options);
+  REQUIRE(none.files_processed == 0);
+  REQUIRE(none.distinct_values.size() == 1);
+
+  std::filesystem::remove_all(directory);
+  std::filesystem::remove(recent);
+  std::filesystem::remove(stale);
+  std::filesystem::remove(empty);
+}
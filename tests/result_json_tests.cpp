@@ -0,0 +1,50 @@
+#include "log_sheriff/result_json.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+TEST_CASE("results render as one JSON document or NDJSON records", "[json]") {
+  log_sheriff::SummaryResult result;
+  result.files_processed = 1;
+  result.total_lines = 3;
+  result.matched_lines = 2;
+  log_sheriff::TopLine line;
+  line.normalized_line = "ERROR <num>";
+  line.count = 2;
+  line.samples.push_back(log_sheriff::LineSample{"ERROR 7", "a.log", 12});
+  result.top_lines.push_back(line);
+
+  std::string document;
+  {
+    log_sheriff::JsonWriter json(document);
+    log_sheriff::write_result_json(json, result);
+  }
+  REQUIRE(document.rfind("{\"files_processed\":1,\"total_lines\":3,\"matched_lines\":2,", 0) == 0);
+  REQUIRE(document.find("\"top_lines\":[{\"line\":\"ERROR <num>\",\"count\":2,"
+                        "\"samples\":[{\"source\":\"a.log\",\"offset\":12,\"line\":\"ERROR 7\"}]}]") !=
+          std::string::npos);
+
+  std::string records;
+  {
+    log_sheriff::JsonWriter json(records);
+    log_sheriff::write_result_ndjson(json, result);
+  }
+  REQUIRE(records.rfind("{\"type\":\"summary\",", 0) == 0);
+  REQUIRE(records.find("\n{\"type\":\"top_line\",\"rank\":1,\"line\":\"ERROR <num>\"") != std::string::npos);
+  REQUIRE(records.back() == '\n');
+
+  result.top_lines[0].pattern_id = 7;
+  result.top_lines[0].previous_count = 1;
+  result.lines_as_ids = true;
+  std::string by_id;
+  {
+    log_sheriff::JsonWriter json(by_id);
+    log_sheriff::write_result_json(json, result);
+  }
+  REQUIRE(by_id.find("\"top_lines\":[{\"pattern_id\":7,\"count\":2,\"previous_count\":1,") != std::string::npos);
+
+  REQUIRE(log_sheriff::format_timestamp_utc(0) == "1970-01-01T00:00:00Z");
+  REQUIRE(log_sheriff::format_rate(2.0) == "2.00");
+  REQUIRE(log_sheriff::format_number(0.5) == "0.5");
+}
@@ -2,8 +2,12 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <span>
+#include <stdexcept>
 #include <string_view>
 #include <string>
 #include <vector>
@@ -96,6 +100,40 @@ TEST_CASE("summarize supports multiple files", "[summarize]") {
   REQUIRE(result.matched_by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Error)] == 1);
 }
 
+TEST_CASE("files summarized on several threads give the same counts", "[summarize]") {
+  std::vector<std::string> files;
+  for (int i = 0; i < 6; ++i) {
+    std::string content;
+    for (int line = 0; line <= i * 40; ++line) {
+      content += line % 3 == 0 ? "ERROR timeout shard=" + std::to_string(i) : "INFO ok user=" + std::to_string(line);
+      content += '\n';
+    }
+    files.push_back(write_temp_log("log_sheriff_sample_threads", content));
+  }
+
+  log_sheriff::SummarizeOptions options;
+  options.files = files;
+  options.group_by = {"shard"};
+  options.distinct_fields = {"user"};
+  const log_sheriff::SummaryResult sequential = log_sheriff::Summarizer{}.summarize(options);
+  options.threads = 4;
+  const log_sheriff::SummaryResult threaded = log_sheriff::Summarizer{}.summarize(options);
+
+  REQUIRE(threaded.files_processed == 6);
+  REQUIRE(threaded.total_lines == sequential.total_lines);
+  REQUIRE(threaded.matched_by_level == sequential.matched_by_level);
+  REQUIRE(threaded.top_lines.size() == sequential.top_lines.size());
+  for (std::size_t i = 0; i < sequential.top_lines.size(); ++i) {
+    REQUIRE(threaded.top_lines[i].normalized_line == sequential.top_lines[i].normalized_line);
+    REQUIRE(threaded.top_lines[i].count == sequential.top_lines[i].count);
+  }
+  REQUIRE(threaded.groups.size() == sequential.groups.size());
+  REQUIRE(threaded.distinct_values[0].estimate == sequential.distinct_values[0].estimate);
+
+  options.files.push_back("/nonexistent/log_sheriff.log");
+  REQUIRE_THROWS_AS(log_sheriff::Summarizer{}.summarize(options), std::runtime_error);
+}
+
 TEST_CASE("parse_level is case-insensitive", "[summarize]") {
   REQUIRE(log_sheriff::parse_level("ERROR") == log_sheriff::LogLevel::Error);
   REQUIRE(log_sheriff::parse_level("Warn") == log_sheriff::LogLevel::Warn);
@@ -130,6 +168,48 @@ TEST_CASE("time range filters are inclusive and exclude lines without timestamps
   REQUIRE(result.matched_by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Error)] == 1);
 }
 
+TEST_CASE("files outside the time range are skipped without being read", "[summarize]") {
+  const std::string recent = write_temp_log("log_sheriff_prune_recent",
+                                            "2026-02-09T18:01:00Z INFO recent\n2026-02-09T18:02:00Z ERROR recent\n");
+  // Last modified long before --since.
+  const std::string stale = write_temp_log("log_sheriff_prune_stale", "2026-02-09T18:01:30Z ERROR stale\n");
+  std::filesystem::last_write_time(stale, std::filesystem::last_write_time(stale) - std::chrono::hours(24 * 400));
+  // An old day in its name, but written to recently: only the mtime counts.
+  const std::filesystem::path renamed = std::filesystem::temp_directory_path() / "log_sheriff_prune.log-20250101";
+  std::ofstream(renamed) << "2026-02-09T18:01:30Z ERROR renamed\n";
+  // Missing files are not pruned, whatever their name, so reading them fails.
+  const std::filesystem::path missing =
+      std::filesystem::temp_directory_path() / "log_sheriff_prune_missing.log-20250101";
+  std::filesystem::remove(missing);
+  // Large enough to be judged by its first and last timestamps, all after --until.
+  std::string late_content;
+  while (late_content.size() < 200 * 1024) {
+    late_content += "2026-02-10T09:00:00Z INFO late request served\n";
+  }
+  const std::string late = write_temp_log("log_sheriff_prune_late", late_content);
+
+  log_sheriff::SummarizeOptions options;
+  options.since = "2026-02-09T18:00:00Z";
+  options.until = "2026-02-09T23:59:59Z";
+  const log_sheriff::LineFilter filter(options);
+  REQUIRE_FALSE(log_sheriff::file_outside_time_range(recent, filter));
+  REQUIRE(log_sheriff::file_outside_time_range(stale, filter));
+  REQUIRE_FALSE(log_sheriff::file_outside_time_range(renamed.string(), filter));
+  REQUIRE_FALSE(log_sheriff::file_outside_time_range(missing.string(), filter));
+  REQUIRE(log_sheriff::file_outside_time_range(late, filter));
+  REQUIRE_FALSE(log_sheriff::file_outside_time_range(late, log_sheriff::LineFilter(log_sheriff::SummarizeOptions{})));
+
+  options.files = {recent, stale, renamed.string(), late};
+  const log_sheriff::SummaryResult result = log_sheriff::Summarizer{}.summarize(options);
+  // Only the files actually read are counted.
+  REQUIRE(result.files_processed == 2);
+  REQUIRE(result.total_lines == 3);
+  REQUIRE(result.matched_lines == 3);
+  options.files.push_back(missing.string());
+  REQUIRE_THROWS_AS(log_sheriff::Summarizer{}.summarize(options), std::runtime_error);
+  std::filesystem::remove(renamed);
+}
+
 TEST_CASE("lines without timestamps are kept when no time filters are set", "[summarize]") {
   const std::string path = write_temp_log(
       "log_sheriff_sample_time_b",
@@ -168,3 +248,427 @@ TEST_CASE("time filters support local timestamp format", "[summarize]") {
   REQUIRE(result.matched_lines == 2);
   REQUIRE(result.matched_by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Info)] == 2);
 }
+
+TEST_CASE("incremental summarizer joins lines split across buffers", "[incremental]") {
+  const std::string data =
+      "2026-02-09T18:01:00Z INFO request id=1 done\n"
+      "2026-02-09T18:01:01Z ERROR request id=2 failed\n"
+      "2026-02-09T18:01:02Z INFO request id=3 done";
+
+  log_sheriff::SummarizeOptions options;
+  options.top_n = 5;
+  log_sheriff::IncrementalSummarizer summarizer(options);
+
+  for (std::size_t pos = 0; pos < data.size(); pos += 7) {
+    const std::size_t len = std::min<std::size_t>(7, data.size() - pos);
+    summarizer.feed(std::span<const char>(data.data() + pos, len));
+  }
+
+  REQUIRE(summarizer.snapshot().total_lines == 2);
+
+  summarizer.flush();
+  const log_sheriff::SummaryResult result = summarizer.snapshot();
+
+  REQUIRE(result.total_lines == 3);
+  REQUIRE(result.matched_by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Info)] == 2);
+  REQUIRE(result.top_lines[0].normalized_line ==
+          "<num>-<num>-<num>T<num>:<num>:<num>Z INFO request id=<num> done");
+  REQUIRE(result.top_lines[0].count == 2);
+}
+
+TEST_CASE("incremental summarizer applies the same filters as file summaries", "[incremental]") {
+  log_sheriff::SummarizeOptions options;
+  options.contains = "timeout";
+  options.since = "2026-02-09T18:01:01Z";
+  log_sheriff::IncrementalSummarizer summarizer(options);
+
+  const std::string_view data =
+      "2026-02-09T18:01:00Z ERROR timeout shard=1\n"
+      "2026-02-09T18:01:02Z ERROR timeout shard=2\n"
+      "2026-02-09T18:01:03Z INFO ok\n";
+  summarizer.feed(std::span<const char>(data.data(), data.size()));
+  summarizer.flush();
+
+  const log_sheriff::SummaryResult result = summarizer.snapshot();
+  REQUIRE(result.total_lines == 3);
+  REQUIRE(result.matched_lines == 1);
+}
+
+TEST_CASE("incremental summarizer resumes from a checkpoint", "[incremental]") {
+  log_sheriff::SummarizeOptions options;
+  options.samples_per_pattern = 2;
+  const std::string_view first = "ERROR a=1\nERROR a=";
+  const std::string_view rest = "22\nINFO b\n";
+
+  log_sheriff::IncrementalSummarizer before(options);
+  before.begin_source("app.log");
+  before.feed(std::span<const char>(first.data(), first.size()));
+  const std::string pending{before.pending()};
+  REQUIRE(pending == "ERROR a=");
+
+  log_sheriff::IncrementalSummarizer after(options);
+  after.resume("app.log", first.size(), before.take_partial(), pending);
+  after.feed(std::span<const char>(rest.data(), rest.size()));
+  REQUIRE(after.pending().empty());
+
+  const log_sheriff::SummaryResult result = after.snapshot();
+  REQUIRE(result.total_lines == 3);
+  REQUIRE(result.top_lines[0].normalized_line == "ERROR a=<num>");
+  REQUIRE(result.top_lines[0].count == 2);
+  REQUIRE(result.top_lines[0].samples[1].line == "ERROR a=22");
+  REQUIRE(result.top_lines[0].samples[1].offset == 10);
+}
+
+TEST_CASE("incremental summarizer joins multi-line records", "[incremental][multiline]") {
+  const std::string data =
+      "2026-02-09T18:01:00Z ERROR request failed id=1\n"
+      "java.lang.IllegalStateException: closed\n"
+      "\tat a.B.c(B.java:10)\n"
+      "Caused by: java.io.IOException: reset\n"
+      "2026-02-09T18:01:01Z INFO ok\n"
+      "2026-02-09T18:01:02Z ERROR request failed id=2\n"
+      "java.lang.IllegalStateException: closed\n"
+      "\tat a.B.c(B.java:12)\n"
+      "Caused by: java.io.IOException: reset";
+
+  log_sheriff::SummarizeOptions options;
+  options.multiline = log_sheriff::MultilineMode::Timestamp;
+  options.samples_per_pattern = 2;
+
+  // The same records come out however the data is split across feeds.
+  for (std::size_t chunk = 1; chunk <= data.size(); chunk += 9) {
+    log_sheriff::IncrementalSummarizer summarizer(options);
+    for (std::size_t pos = 0; pos < data.size(); pos += chunk) {
+      summarizer.feed(std::span<const char>(data.data() + pos, std::min(chunk, data.size() - pos)));
+    }
+    summarizer.flush();
+    const log_sheriff::SummaryResult result = summarizer.snapshot();
+    INFO(chunk);
+    REQUIRE(result.total_lines == 3);
+    REQUIRE(result.matched_by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Error)] == 2);
+    REQUIRE(result.top_lines[0].count == 2);
+    REQUIRE(result.top_lines[0].normalized_line ==
+            "<num>-<num>-<num>T<num>:<num>:<num>Z ERROR request failed id=<num> java.lang.IllegalStateException: "
+            "closed at a.B.c(B.java:<num>) Caused by: java.io.IOException: reset");
+    REQUIRE(result.top_lines[0].samples[1].offset == data.find("2026-02-09T18:01:02Z"));
+    REQUIRE(result.top_lines[0].samples[1].line == data.substr(data.find("2026-02-09T18:01:02Z")));
+  }
+
+  // A checkpoint holds the open record back with the unterminated line.
+  const std::size_t split = data.rfind("Caused by") + 4;
+  log_sheriff::IncrementalSummarizer before(options);
+  before.feed(std::span<const char>(data.data(), split));
+  const std::string pending{before.pending()};
+  REQUIRE(pending == data.substr(data.find("2026-02-09T18:01:02Z"), split - data.find("2026-02-09T18:01:02Z")));
+
+  log_sheriff::IncrementalSummarizer after(options);
+  after.resume("", split, before.take_partial(), pending);
+  after.feed(std::span<const char>(data.data() + split, data.size() - split));
+  after.flush();
+  REQUIRE(after.snapshot().total_lines == 3);
+  REQUIRE(after.snapshot().top_lines[0].count == 2);
+
+  // Indent mode keeps the unindented exception line as a record of its own.
+  options.multiline = log_sheriff::MultilineMode::Indent;
+  log_sheriff::IncrementalSummarizer indent(options);
+  indent.feed(std::span<const char>(data.data(), data.size()));
+  indent.flush();
+  REQUIRE(indent.snapshot().total_lines == 5);
+}
+
+TEST_CASE("bucketed summaries count matches per level and per pattern", "[summarize][histogram]") {
+  const std::string path1 = write_temp_log(
+      "log_sheriff_sample_bucket_a",
+      "2026-02-09T18:03:10Z ERROR timeout shard=1\n"
+      "2026-02-09T18:03:50Z INFO ok\n"
+      "no timestamp ERROR timeout\n");
+  const std::string path2 = write_temp_log(
+      "log_sheriff_sample_bucket_b",
+      "2026-02-09T18:01:30Z ERROR timeout shard=2\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.files = {path1, path2};
+  options.bucket_seconds = 60;
+  options.bucket_patterns = true;
+  options.top_n = 1;
+
+  const log_sheriff::Summarizer summarizer;
+  const log_sheriff::SummaryResult result = summarizer.summarize(options);
+
+  REQUIRE(result.bucket_seconds == 60);
+  REQUIRE(result.unbucketed_lines == 1);
+  REQUIRE(result.buckets.size() == 3);
+  REQUIRE(result.buckets[0].matched == 1);
+  REQUIRE(result.buckets[0].by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Error)] == 1);
+  REQUIRE(result.buckets[1].matched == 0);
+  REQUIRE(result.buckets[2].matched == 2);
+  REQUIRE(result.buckets[2].by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Info)] == 1);
+
+  REQUIRE(result.top_lines.size() == 1);
+  REQUIRE(result.top_lines[0].count == 2);
+  REQUIRE(result.top_lines[0].buckets == std::vector<std::uint64_t>{1, 0, 1});
+}
+
+TEST_CASE("bucket histograms do not depend on file order", "[summarize][histogram]") {
+  // Its first line is a year early: it must not decide which buckets are shown.
+  const std::string stray = write_temp_log(
+      "log_sheriff_bucket_order_a",
+      "2025-02-09T18:00:00Z ERROR clock not set\n"
+      "2026-02-09T18:00:10Z ERROR timeout\n");
+  const std::string steady = write_temp_log(
+      "log_sheriff_bucket_order_b",
+      "2026-02-09T18:00:20Z ERROR timeout\n"
+      "2026-02-09T18:00:40Z INFO ok\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.bucket_seconds = 1;
+  options.bucket_patterns = true;
+  std::vector<log_sheriff::SummaryResult> results;
+  for (const auto& files : {std::vector<std::string>{stray, steady}, std::vector<std::string>{steady, stray}}) {
+    for (const std::size_t threads : {1, 2}) {
+      options.files = files;
+      options.threads = threads;
+      results.push_back(log_sheriff::Summarizer{}.summarize(options));
+    }
+  }
+  for (const log_sheriff::SummaryResult& result : results) {
+    REQUIRE(result.unbucketed_lines == 1);
+    REQUIRE(result.buckets.size() == 31);
+    REQUIRE(result.buckets.front().start == results.front().buckets.front().start);
+    REQUIRE(result.buckets.front().matched == 1);
+    REQUIRE(result.buckets.back().matched == 1);
+    REQUIRE(result.top_lines[0].buckets == results.front().top_lines[0].buckets);
+  }
+}
+
+TEST_CASE("top lines report first and last sighting and rate", "[summarize]") {
+  const std::string path = write_temp_log(
+      "log_sheriff_sample_seen",
+      "2026-02-09T18:10:00Z WARN retry id=1\n"
+      "2026-02-09T18:00:00Z WARN retry id=2\n"
+      "WARN retry id=3\n"
+      "2026-02-09T18:04:00Z WARN retry id=4\n"
+      "2026-02-09T18:04:00Z INFO once\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.files = {path};
+  options.top_n = 2;
+
+  const log_sheriff::Summarizer summarizer;
+  const log_sheriff::SummaryResult result = summarizer.summarize(options);
+
+  REQUIRE(result.top_lines.size() == 2);
+  const log_sheriff::TopLine& retry = result.top_lines[0];
+  REQUIRE(retry.count == 3);
+  REQUIRE(retry.first_seen.has_value());
+  REQUIRE(*retry.last_seen - *retry.first_seen == 600);
+  REQUIRE(retry.per_minute == 0.3);
+
+  const log_sheriff::TopLine& once = result.top_lines[1];
+  REQUIRE(once.first_seen == once.last_seen);
+  REQUIRE(once.per_minute == 1.0);
+}
+
+TEST_CASE("stat field quantiles are tracked per pattern", "[summarize]") {
+  const std::string path = write_temp_log(
+      "log_sheriff_sample_stat",
+      "GET /health status=200 latency_ms=2\n"
+      "GET /health status=200 latency_ms=4\n"
+      "GET /health status=200 latency_ms=100\n"
+      "POST /orders status=429 latency_ms=90\n"
+      "POST /orders status=429 latency_ms=slow\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.files = {path};
+  options.stat_field = "latency_ms";
+
+  const log_sheriff::Summarizer summarizer;
+  const log_sheriff::SummaryResult result = summarizer.summarize(options);
+
+  REQUIRE(result.stat_field == "latency_ms");
+  REQUIRE(result.stats.has_value());
+  REQUIRE(result.stats->count == 4);
+  REQUIRE(result.stats->max == 100.0);
+
+  REQUIRE(result.top_lines[0].normalized_line == "GET /health status=<num> latency_ms=<num>");
+  REQUIRE(result.top_lines[0].stats.has_value());
+  REQUIRE(result.top_lines[0].stats->count == 3);
+  REQUIRE(result.top_lines[0].stats->min == 2.0);
+  REQUIRE(result.top_lines[0].stats->p50 >= 3.96);
+  REQUIRE(result.top_lines[0].stats->p50 <= 4.04);
+}
+
+TEST_CASE("where filter applies to summarize", "[summarize][where]") {
+  const std::string path = write_temp_log(
+      "log_sheriff_sample_where",
+      "GET /health status=200 shard=3\n"
+      "GET /orders status=503 shard=3\n"
+      "GET /orders status=500 shard=4\n"
+      "GET /orders status=5000x shard=3\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.files = {path};
+  options.where = "status>=500 shard=3";
+
+  const log_sheriff::Summarizer summarizer;
+  const log_sheriff::SummaryResult result = summarizer.summarize(options);
+
+  REQUIRE(result.total_lines == 4);
+  REQUIRE(result.matched_lines == 1);
+  REQUIRE(result.top_lines[0].normalized_line == "GET /orders status=<num> shard=<num>");
+}
+
+TEST_CASE("group-by counts matched lines per field tuple", "[summarize][group]") {
+  const std::string path = write_temp_log(
+      "log_sheriff_sample_group",
+      "ERROR timeout shard=7 retries=1\n"
+      "ERROR timeout shard=7 retries=2\n"
+      "ERROR refused shard=7 retries=1\n"
+      "ERROR timeout shard=9 retries=1\n"
+      "ERROR timeout without shard\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.files = {path};
+  options.group_by = {"shard"};
+  options.group_top_n = 1;
+  options.top_n = 5;
+
+  const log_sheriff::Summarizer summarizer;
+  const log_sheriff::SummaryResult result = summarizer.summarize(options);
+
+  REQUIRE(result.group_by == std::vector<std::string>{"shard"});
+  REQUIRE(result.ungrouped_lines == 1);
+  REQUIRE(result.groups.size() == 2);
+  REQUIRE(result.groups[0].values == std::vector<std::string>{"7"});
+  REQUIRE(result.groups[0].count == 3);
+  REQUIRE(result.groups[0].top_lines.size() == 1);
+  REQUIRE(result.groups[0].top_lines[0].normalized_line == "ERROR timeout shard=<num> retries=<num>");
+  REQUIRE(result.groups[0].top_lines[0].count == 2);
+
+  options.group_by = {"shard", "retries"};
+  const log_sheriff::SummaryResult multi = summarizer.summarize(options);
+  REQUIRE(multi.groups.size() == 3);
+  REQUIRE(multi.groups[0].values == std::vector<std::string>{"7", "1"});
+  REQUIRE(multi.groups[0].count == 2);
+}
+
+TEST_CASE("distinct patterns and field values are estimated", "[summarize][distinct]") {
+  const std::string path = write_temp_log(
+      "log_sheriff_sample_distinct",
+      "ERROR timeout user=alice\n"
+      "ERROR timeout user=bob\n"
+      "WARN slow user=alice\n"
+      "INFO started\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.files = {path};
+  options.distinct_fields = {"user", "region"};
+  options.hll_precision = 10;
+
+  const log_sheriff::Summarizer summarizer;
+  const log_sheriff::SummaryResult result = summarizer.summarize(options);
+
+  REQUIRE(result.distinct_patterns == 4);
+  REQUIRE(result.distinct_values.size() == 2);
+  REQUIRE(result.distinct_values[0].field == "user");
+  REQUIRE(result.distinct_values[0].estimate == 2);
+  REQUIRE(result.distinct_values[1].field == "region");
+  REQUIRE(result.distinct_values[1].estimate == 0);
+}
+
+TEST_CASE("json lines summarize their message, level and members", "[summarize][json]") {
+  const std::string path = write_temp_log(
+      "log_sheriff_sample_json",
+      R"({"ts": "2026-02-09T18:01:00Z", "level": "info", "msg": "request done id=1", "route": "/a", "ms": 4})"
+      "\n"
+      R"({"ts": "2026-02-09T18:01:01Z", "level": "info", "msg": "request done id=2", "route": "/b", "ms": 8})"
+      "\n"
+      R"({"ts": "2026-02-09T18:01:02Z", "level": "error", "msg": "db timeout", "route": "/a", "ms": 900})"
+      "\n"
+      "not json, but an ERROR\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.files = {path};
+  options.input_format = log_sheriff::InputFormat::JsonLines;
+  options.where = "ms>5";
+  options.group_by = {"route"};
+  options.since = "2026-02-09T18:01:01Z";
+
+  const log_sheriff::SummaryResult result = log_sheriff::Summarizer{}.summarize(options);
+  REQUIRE(result.total_lines == 4);
+  REQUIRE(result.matched_lines == 2);
+  REQUIRE(result.matched_by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Info)] == 1);
+  REQUIRE(result.matched_by_level[static_cast<std::size_t>(log_sheriff::LogLevel::Error)] == 1);
+  REQUIRE(result.top_lines.size() == 2);
+  REQUIRE((result.top_lines[0].normalized_line == "request done id=<num>" ||
+           result.top_lines[1].normalized_line == "request done id=<num>"));
+  REQUIRE(result.groups.size() == 2);
+
+  // The level member decides for JSON lines; the line that is not JSON falls back to keywords.
+  options = log_sheriff::SummarizeOptions{};
+  options.files = {path};
+  options.input_format = log_sheriff::InputFormat::JsonLines;
+  options.level = log_sheriff::LogLevel::Error;
+  const log_sheriff::SummaryResult errors = log_sheriff::Summarizer{}.summarize(options);
+  REQUIRE(errors.matched_lines == 2);
+  REQUIRE(errors.top_lines[0].count == 1);
+}
+
+TEST_CASE("line filter applies the summary predicates to single lines", "[filter]") {
+  log_sheriff::SummarizeOptions options;
+  options.contains = "timeout";
+  options.level = log_sheriff::LogLevel::Error;
+  options.since = "2026-02-09T18:01:00Z";
+  const log_sheriff::LineFilter filter(options);
+
+  std::optional<std::time_t> timestamp;
+  REQUIRE(filter.matches("2026-02-09T18:01:03Z ERROR database timeout", timestamp));
+  REQUIRE(timestamp.has_value());
+  REQUIRE_FALSE(filter.matches("2026-02-09T18:00:59Z ERROR database timeout"));
+  REQUIRE_FALSE(filter.matches("2026-02-09T18:01:03Z WARN database timeout"));
+  REQUIRE_FALSE(filter.matches("ERROR database timeout"));
+
+  options.until = "2026-02-09T17:00:00Z";
+  REQUIRE_THROWS_AS(log_sheriff::LineFilter(options), std::invalid_argument);
+}
+
+TEST_CASE("top lines carry sampled raw lines with their offsets", "[summarize][samples]") {
+  const std::string path = write_temp_log(
+      "log_sheriff_sample_examples",
+      "ERROR timeout shard=1\n"
+      "INFO ok\n"
+      "ERROR timeout shard=22\n"
+      "ERROR timeout shard=333\n");
+
+  log_sheriff::SummarizeOptions options;
+  options.files = {path};
+  options.samples_per_pattern = 2;
+  const log_sheriff::Summarizer summarizer;
+  const log_sheriff::SummaryResult result = summarizer.summarize(options);
+
+  REQUIRE(result.top_lines[0].count == 3);
+  const std::vector<log_sheriff::LineSample>& samples = result.top_lines[0].samples;
+  REQUIRE(samples.size() == 2);
+  for (const log_sheriff::LineSample& sample : samples) {
+    REQUIRE(sample.source == path);
+    REQUIRE(sample.line.starts_with("ERROR timeout shard="));
+    REQUIRE((sample.offset == 0 || sample.offset == 30 || sample.offset == 53));
+  }
+  REQUIRE(samples[0].offset < samples[1].offset);
+  REQUIRE(result.top_lines[1].samples.size() == 1);
+  REQUIRE(result.top_lines[1].samples[0].offset == 22);
+
+  // Offsets count bytes of the source even when lines straddle fed buffers.
+  options.samples_per_pattern = 1;
+  log_sheriff::IncrementalSummarizer incremental(options);
+  incremental.begin_source("feed");
+  const std::string_view text = "INFO a\nWARN b\n";
+  incremental.feed(std::span<const char>(text.data(), 9));
+  incremental.feed(std::span<const char>(text.data() + 9, text.size() - 9));
+  const log_sheriff::SummaryResult fed = incremental.snapshot();
+  REQUIRE(fed.top_lines.size() == 2);
+  for (const log_sheriff::TopLine& line : fed.top_lines) {
+    REQUIRE(line.samples[0].source == "feed");
+    REQUIRE(line.samples[0].offset == (line.samples[0].line == "INFO a" ? 0U : 7U));
+  }
+}
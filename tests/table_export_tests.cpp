@@ -0,0 +1,214 @@
+#include "log_sheriff/table_export.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+log_sheriff::SummaryResult sample_result() {
+  log_sheriff::SummaryResult result;
+  log_sheriff::TopLine timed;
+  timed.normalized_line = "ERROR timeout shard=<num>";
+  timed.count = 5;
+  timed.first_seen = 1770660000;
+  timed.last_seen = 1770660120;
+  timed.per_minute = 2.5;
+  log_sheriff::TopLine untimed;
+  untimed.normalized_line = "say \"hi\", bye";
+  untimed.count = 2;
+  result.top_lines = {timed, untimed};
+
+  result.bucket_seconds = 60;
+  result.buckets = {{1770660000, 3, {1, 1, 1, 0}}, {1770660060, 4, {4, 0, 0, 0}}};
+  result.group_by = {"shard"};
+  result.groups = {{{"7"}, 4, {}}, {{"9"}, 1, {}}};
+  return result;
+}
+
+std::uint32_t read_u32(const std::string& bytes, std::size_t pos) {
+  std::uint32_t value = 0;
+  for (std::size_t i = 0; i < 4; ++i) {
+    value |= static_cast<std::uint32_t>(static_cast<unsigned char>(bytes[pos + i])) << (8 * i);
+  }
+  return value;
+}
+
+std::uint64_t read_u64(const std::string& bytes, std::size_t pos) {
+  return read_u32(bytes, pos) | static_cast<std::uint64_t>(read_u32(bytes, pos + 4)) << 32;
+}
+
+// Just enough of a FlatBuffers reader to walk Arrow message metadata. Positions are absolute
+// offsets into `bytes`; `base` is where the flatbuffer starts.
+struct FlatReader {
+  const std::string& bytes;
+  std::size_t base;
+
+  std::size_t root() const { return base + read_u32(bytes, base); }
+
+  // Position of field `id` of the table at `table`, or 0 if it is absent.
+  std::size_t field(std::size_t table, std::uint16_t id) const {
+    const std::size_t vtable = table - static_cast<std::int32_t>(read_u32(bytes, table));
+    const std::uint16_t vtable_size = static_cast<std::uint16_t>(read_u32(bytes, vtable) & 0xFFFF);
+    if (4U + 2U * id >= vtable_size) {
+      return 0;
+    }
+    const std::uint16_t offset = static_cast<std::uint16_t>(read_u32(bytes, vtable + 4 + 2 * id) & 0xFFFF);
+    return offset == 0 ? 0 : table + offset;
+  }
+
+  std::uint8_t u8(std::size_t table, std::uint16_t id) const {
+    const std::size_t pos = field(table, id);
+    return pos == 0 ? 0 : static_cast<std::uint8_t>(bytes[pos]);
+  }
+  std::size_t child(std::size_t table, std::uint16_t id) const {
+    const std::size_t pos = field(table, id);
+    return pos + read_u32(bytes, pos);
+  }
+  std::string_view string(std::size_t table, std::uint16_t id) const {
+    const std::size_t pos = child(table, id);
+    return std::string_view(bytes).substr(pos + 4, read_u32(bytes, pos));
+  }
+};
+
+}  // namespace
+
+TEST_CASE("columns track nulls in a lazily built validity bitmap", "[export]") {
+  log_sheriff::Column column("value", log_sheriff::ColumnType::UInt64);
+  column.append_uint(1);
+  REQUIRE(column.validity().empty());
+  for (int i = 0; i < 9; ++i) {
+    column.append_uint(2);
+  }
+  column.append_null();
+  column.append_uint(3);
+
+  REQUIRE(column.size() == 12);
+  REQUIRE(column.null_count() == 1);
+  REQUIRE(column.validity().size() == 2);
+  REQUIRE(column.is_valid(9));
+  REQUIRE_FALSE(column.is_valid(10));
+  REQUIRE(column.is_valid(11));
+
+  log_sheriff::Column text("text", log_sheriff::ColumnType::Utf8);
+  text.append_text("ab");
+  text.append_null();
+  text.append_text("c");
+  REQUIRE(text.text() == "abc");
+  REQUIRE(text.text_at(1).empty());
+  REQUIRE(text.text_at(2) == "c");
+}
+
+TEST_CASE("csv export quotes text and leaves nulls empty", "[export]") {
+  const log_sheriff::SummaryResult result = sample_result();
+
+  REQUIRE(log_sheriff::to_csv(log_sheriff::result_table(result, log_sheriff::ResultTable::Top)) ==
+          "rank,count,line,first_seen,last_seen,per_minute\r\n"
+          "1,5,ERROR timeout shard=<num>,2026-02-09T18:00:00Z,2026-02-09T18:02:00Z,2.5\r\n"
+          "2,2,\"say \"\"hi\"\", bye\",,,\r\n");
+  REQUIRE(log_sheriff::to_csv(log_sheriff::result_table(result, log_sheriff::ResultTable::Buckets)) ==
+          "start,matched,error,warn,info,debug\r\n"
+          "2026-02-09T18:00:00Z,3,1,1,1,0\r\n"
+          "2026-02-09T18:01:00Z,4,4,0,0,0\r\n");
+  REQUIRE(log_sheriff::to_csv(log_sheriff::result_table(result, log_sheriff::ResultTable::Groups)) ==
+          "rank,count,shard\r\n1,4,7\r\n2,1,9\r\n");
+}
+
+TEST_CASE("arrow stream frames a schema and a record batch", "[export]") {
+  const log_sheriff::ColumnTable table =
+      log_sheriff::result_table(sample_result(), log_sheriff::ResultTable::Top);
+  const std::string stream = log_sheriff::to_arrow_stream(table);
+
+  // Schema message: continuation marker, 8-aligned metadata length, no body.
+  REQUIRE(read_u32(stream, 0) == 0xFFFFFFFFU);
+  const std::uint32_t schema_size = read_u32(stream, 4);
+  REQUIRE(schema_size % 8 == 0);
+  REQUIRE(stream.find("first_seen") < 8 + schema_size);
+
+  // Record batch message, whose body carries the raw column bytes.
+  const std::size_t batch = 8 + schema_size;
+  REQUIRE(read_u32(stream, batch) == 0xFFFFFFFFU);
+  REQUIRE(read_u32(stream, batch + 4) % 8 == 0);
+  REQUIRE(stream.find("ERROR timeout shard=<num>say \"hi\", bye") != std::string::npos);
+
+  // End-of-stream marker.
+  REQUIRE(stream.size() % 8 == 0);
+  REQUIRE(read_u32(stream, stream.size() - 8) == 0xFFFFFFFFU);
+  REQUIRE(read_u32(stream, stream.size() - 4) == 0);
+}
+
+TEST_CASE("arrow record batch body holds the column buffers at the offsets its metadata names", "[export]") {
+  log_sheriff::ColumnTable table;
+  table.columns.emplace_back("n", log_sheriff::ColumnType::UInt64);
+  table.columns.emplace_back("s", log_sheriff::ColumnType::Utf8);
+  table.columns[0].append_uint(7);
+  table.columns[0].append_null();
+  table.columns[0].append_uint(9);
+  table.columns[1].append_text("ab");
+  table.columns[1].append_text("");
+  table.columns[1].append_text("c");
+  const std::string stream = log_sheriff::to_arrow_stream(table);
+
+  // Schema: Message.header_type 1 (Schema), one Field per column with its name and type tag.
+  const FlatReader schema_reader{stream, 8};
+  const std::size_t schema_message = schema_reader.root();
+  REQUIRE(schema_reader.u8(schema_message, 1) == 1);
+  const std::size_t fields = schema_reader.child(schema_reader.child(schema_message, 2), 1);
+  REQUIRE(read_u32(stream, fields) == 2);
+  const std::size_t n_field = fields + 4 + read_u32(stream, fields + 4);
+  const std::size_t s_field = fields + 8 + read_u32(stream, fields + 8);
+  REQUIRE(schema_reader.string(n_field, 0) == "n");
+  REQUIRE(schema_reader.u8(n_field, 2) == 2);  // Int
+  const std::size_t int_type = schema_reader.child(n_field, 3);
+  REQUIRE(read_u32(stream, schema_reader.field(int_type, 0)) == 64);
+  REQUIRE(schema_reader.u8(int_type, 1) == 0);  // unsigned
+  REQUIRE(schema_reader.string(s_field, 0) == "s");
+  REQUIRE(schema_reader.u8(s_field, 2) == 5);  // Utf8
+
+  // Record batch: Message.header_type 3, then length, field nodes and buffers.
+  const std::size_t batch = 8 + read_u32(stream, 4);
+  const std::size_t batch_size = read_u32(stream, batch + 4);
+  const FlatReader batch_reader{stream, batch + 8};
+  const std::size_t batch_message = batch_reader.root();
+  REQUIRE(batch_reader.u8(batch_message, 1) == 3);
+  const std::size_t body_length = read_u64(stream, batch_reader.field(batch_message, 3));
+  const std::size_t record_batch = batch_reader.child(batch_message, 2);
+  REQUIRE(read_u64(stream, batch_reader.field(record_batch, 0)) == 3);
+
+  const std::size_t nodes = batch_reader.child(record_batch, 1);
+  REQUIRE(read_u32(stream, nodes) == 2);
+  REQUIRE(read_u64(stream, nodes + 4) == 3);
+  REQUIRE(read_u64(stream, nodes + 12) == 1);
+  REQUIRE(read_u64(stream, nodes + 20) == 3);
+  REQUIRE(read_u64(stream, nodes + 28) == 0);
+
+  // Five buffers: n's validity and values, s's (empty) validity, offsets and bytes. Each starts
+  // 8-aligned in the body.
+  const std::size_t buffers = batch_reader.child(record_batch, 2);
+  REQUIRE(read_u32(stream, buffers) == 5);
+  const std::vector<std::pair<std::uint64_t, std::uint64_t>> expected = {
+      {0, 1}, {8, 24}, {32, 0}, {32, 16}, {48, 3}};
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    INFO(i);
+    REQUIRE(read_u64(stream, buffers + 4 + 16 * i) == expected[i].first);
+    REQUIRE(read_u64(stream, buffers + 12 + 16 * i) == expected[i].second);
+  }
+  REQUIRE(body_length == 56);
+
+  const std::size_t body = batch + 8 + batch_size;
+  REQUIRE(body + body_length + 8 == stream.size());
+  REQUIRE(static_cast<std::uint8_t>(stream[body]) == 0b101);
+  REQUIRE(read_u64(stream, body + 8) == 7);
+  REQUIRE(read_u64(stream, body + 16) == 0);
+  REQUIRE(read_u64(stream, body + 24) == 9);
+  REQUIRE(read_u32(stream, body + 32) == 0);
+  REQUIRE(read_u32(stream, body + 36) == 2);
+  REQUIRE(read_u32(stream, body + 40) == 2);
+  REQUIRE(read_u32(stream, body + 44) == 3);
+  REQUIRE(stream.substr(body + 48, 3) == "abc");
+}
@@ -0,0 +1,20 @@
+#include "log_sheriff/thread_pool.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+
+TEST_CASE("thread pool runs every submitted task before it is destroyed", "[pool]") {
+  std::atomic<int> done{0};
+  {
+    log_sheriff::ThreadPool pool(3);
+    REQUIRE(pool.size() == 3);
+    for (int i = 0; i < 200; ++i) {
+      pool.submit([&done] { done.fetch_add(1); });
+    }
+  }
+  REQUIRE(done.load() == 200);
+
+  const log_sheriff::ThreadPool automatic;
+  REQUIRE(automatic.size() >= 1);
+}
@@ -0,0 +1,79 @@
+#include "log_sheriff/time_histogram.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+TEST_CASE("parse_duration accepts unit suffixes", "[histogram]") {
+  REQUIRE(log_sheriff::parse_duration("45") == 45u);
+  REQUIRE(log_sheriff::parse_duration("30s") == 30u);
+  REQUIRE(log_sheriff::parse_duration("1m") == 60u);
+  REQUIRE(log_sheriff::parse_duration("2h") == 7200u);
+  REQUIRE(log_sheriff::parse_duration("1d") == 86400u);
+  REQUIRE_FALSE(log_sheriff::parse_duration("0m").has_value());
+  REQUIRE_FALSE(log_sheriff::parse_duration("m").has_value());
+  REQUIRE_FALSE(log_sheriff::parse_duration("1w").has_value());
+}
+
+TEST_CASE("bucket_index rounds toward negative infinity", "[histogram]") {
+  REQUIRE(log_sheriff::bucket_index(119, 60) == 1);
+  REQUIRE(log_sheriff::bucket_index(120, 60) == 2);
+  REQUIRE(log_sheriff::bucket_index(-1, 60) == -1);
+}
+
+TEST_CASE("bucket series stores the buckets counted in any order", "[histogram]") {
+  log_sheriff::BucketSeries<std::uint64_t> series;
+  ++series.at(10);
+  ++series.at(12);
+  ++series.at(8);
+  ++series.at(12);
+
+  REQUIRE(series.size() == 3);
+  REQUIRE(series.get(8) == 1);
+  REQUIRE(series.get(9) == 0);
+  REQUIRE(series.get(12) == 2);
+  REQUIRE(series.get(100) == 0);
+
+  // Copies and moves do not share the bucket kept at hand.
+  log_sheriff::BucketSeries<std::uint64_t> copy = series;
+  ++copy.at(12);
+  REQUIRE(series.get(12) == 2);
+  log_sheriff::BucketSeries<std::uint64_t> moved = std::move(copy);
+  ++moved.at(12);
+  REQUIRE(moved.get(12) == 4);
+
+  const auto far = static_cast<std::int64_t>(log_sheriff::BucketSeries<std::uint64_t>::kMaxBuckets) + 8;
+  log_sheriff::BucketSeries<std::uint64_t> other;
+  other.at(9) = 4;
+  other.at(far) = 7;
+  series.merge(other);
+  REQUIRE(series.get(9) == 4);
+  REQUIRE(series.get(far) == 7);
+}
+
+TEST_CASE("bucket series shows its densest window whatever the arrival order", "[histogram]") {
+  constexpr auto kSpan = static_cast<std::int64_t>(log_sheriff::BucketSeries<std::uint64_t>::kMaxBuckets);
+  const auto weight = [](std::uint64_t count) { return count; };
+  // A stray bucket long before the rest and another long after.
+  const std::vector<std::pair<std::int64_t, std::uint64_t>> counts{
+      {-5 * kSpan, 3}, {100, 2}, {101, 5}, {100 + kSpan - 1, 1}, {40 * kSpan, 4}};
+
+  log_sheriff::BucketSeries<std::uint64_t> forward;
+  for (const auto& [bucket, count] : counts) {
+    forward.at(bucket) += count;
+  }
+  log_sheriff::BucketSeries<std::uint64_t> backward;
+  for (auto it = counts.rbegin(); it != counts.rend(); ++it) {
+    backward.at(it->first) += it->second;
+  }
+  REQUIRE(forward.densest_window(weight) == std::pair<std::int64_t, std::int64_t>{100, 100 + kSpan - 1});
+  REQUIRE(backward.densest_window(weight) == forward.densest_window(weight));
+
+  log_sheriff::BucketSeries<std::uint64_t> narrow;
+  narrow.at(3) = 1;
+  narrow.at(7) = 1;
+  REQUIRE(narrow.densest_window(weight) == std::pair<std::int64_t, std::int64_t>{3, 7});
+  REQUIRE(log_sheriff::BucketSeries<std::uint64_t>{}.densest_window(weight).second == -1);
+}
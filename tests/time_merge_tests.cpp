@@ -0,0 +1,61 @@
+#include "log_sheriff/time_merge.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+std::span<const char> bytes(std::string_view text) { return {text.data(), text.size()}; }
+
+std::vector<std::string> merged(log_sheriff::TimeMerger& merger) {
+  std::vector<std::string> out;
+  log_sheriff::TimeMerger::Line line;
+  while (merger.next(line)) {
+    out.push_back(std::to_string(line.input) + ":" + std::string(line.text));
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST_CASE("time merger interleaves inputs by timestamp", "[merge]") {
+  const std::string a =
+      "2026-02-09T18:01:00Z a1\n"
+      "2026-02-09T18:01:03Z a2\n"
+      "\tcontinued\n"
+      "2026-02-09T18:01:05Z a3";
+  const std::string b =
+      "header without time\n"
+      "2026-02-09T18:01:01Z b1\n"
+      "2026-02-09T18:01:03Z b2\n";
+  const std::string c;
+
+  log_sheriff::TimeMerger merger({bytes(a), bytes(b), bytes(c)}, log_sheriff::InputFormat::Text);
+  // Lines without a timestamp stay behind the line before them; ties go to the earlier input.
+  REQUIRE(merged(merger) == std::vector<std::string>{"1:header without time", "0:2026-02-09T18:01:00Z a1",
+                                                     "1:2026-02-09T18:01:01Z b1", "0:2026-02-09T18:01:03Z a2",
+                                                     "0:\tcontinued", "1:2026-02-09T18:01:03Z b2",
+                                                     "0:2026-02-09T18:01:05Z a3"});
+  log_sheriff::TimeMerger::Line line;
+  REQUIRE_FALSE(merger.next(line));
+}
+
+TEST_CASE("time merger hands out each line parsed in the input format", "[merge]") {
+  const std::string a = R"({"ts": 1770660063, "msg": "late"})" "\n";
+  const std::string b = R"({"ts": 1770660000, "level": "error", "msg": "early"})" "\n";
+
+  log_sheriff::TimeMerger merger({bytes(a), bytes(b)}, log_sheriff::InputFormat::JsonLines);
+  log_sheriff::TimeMerger::Line line;
+  REQUIRE(merger.next(line));
+  REQUIRE(line.input == 1);
+  REQUIRE(line.terminated);
+  REQUIRE(line.record->message() == "early");
+  REQUIRE(line.record->level() == log_sheriff::LogLevel::Error);
+  REQUIRE(merger.next(line));
+  REQUIRE(line.record->message() == "late");
+  REQUIRE_FALSE(merger.next(line));
+}
@@ -0,0 +1,68 @@
+#include "log_sheriff/where.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdexcept>
+
+namespace {
+
+bool where(std::string_view expression, std::string_view line) {
+  return log_sheriff::WhereFilter::compile(expression).matches(line);
+}
+
+}  // namespace
+
+TEST_CASE("where compares numerically when both sides are numbers", "[where]") {
+  constexpr std::string_view line = "POST path=/api/v1/orders status=503 latency_ms=88";
+  REQUIRE(where("status>=500", line));
+  REQUIRE(where("status>500", line));
+  REQUIRE_FALSE(where("status<500", line));
+  REQUIRE(where("status=503.0", line));
+  REQUIRE(where("latency_ms<100", line));
+  REQUIRE_FALSE(where("status>=1000", line));
+  REQUIRE_FALSE(where("status>=500", "status=5000x"));
+  REQUIRE(where("status!=500", "status=5000x"));
+}
+
+TEST_CASE("where compares text and substrings", "[where]") {
+  constexpr std::string_view line = "GET path=/health method=GET user=\"jane doe\"";
+  REQUIRE(where("method=GET", line));
+  REQUIRE(where("method!=POST", line));
+  REQUIRE(where("path~health", line));
+  REQUIRE(where("user=\"jane doe\"", line));
+  REQUIRE_FALSE(where("path=/heal", line));
+}
+
+TEST_CASE("where combines terms with boolean operators", "[where]") {
+  constexpr std::string_view line = "ERROR database timeout shard=7 retries=1";
+  REQUIRE(where("shard=7 retries=1", line));
+  REQUIRE(where("shard=3 or shard=7", line));
+  REQUIRE(where("(shard=3 || shard=7) && retries<2", line));
+  REQUIRE_FALSE(where("shard=7 and not retries=1", line));
+  REQUIRE(where("!missing", line));
+  REQUIRE(where("shard", line));
+  REQUIRE_FALSE(where("missing!=1", line));
+}
+
+TEST_CASE("where operators need no spaces around unquoted values", "[where]") {
+  REQUIRE(where("status=500||status=503", "GET status=503"));
+  REQUIRE(where("status=500||status=503", "GET status=500"));
+  REQUIRE_FALSE(where("status=500||status=503", "GET status=200"));
+  REQUIRE(where("shard=7&&retries<2", "shard=7 retries=1"));
+  REQUIRE_FALSE(where("shard=7&&!retries", "shard=7 retries=1"));
+  REQUIRE(where("(shard=3||shard=7)&&retries=1", "shard=7 retries=1"));
+  REQUIRE(where("query=\"a&b|c!\"", "query=\"a&b|c!\""));
+  REQUIRE_THROWS_AS(log_sheriff::WhereFilter::compile("query=a&b"), std::invalid_argument);
+}
+
+TEST_CASE("where does not match keys inside other tokens", "[where]") {
+  REQUIRE_FALSE(where("shard=3", "ERROR subshard=3"));
+  REQUIRE(where("shard=3", "ERROR subshard=4 shard=3"));
+}
+
+TEST_CASE("invalid where expressions are rejected", "[where]") {
+  REQUIRE_THROWS_AS(log_sheriff::WhereFilter::compile(""), std::invalid_argument);
+  REQUIRE_THROWS_AS(log_sheriff::WhereFilter::compile("status>="), std::invalid_argument);
+  REQUIRE_THROWS_AS(log_sheriff::WhereFilter::compile("(shard=3"), std::invalid_argument);
+  REQUIRE_THROWS_AS(log_sheriff::WhereFilter::compile("user=\"open"), std::invalid_argument);
+}